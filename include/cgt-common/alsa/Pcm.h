@@ -80,6 +80,27 @@ public:
      * @param[in] silent Suppress printing of an error message.
      */
     void recover( int code, int silent );
+    /**
+     * @brief Enables timestamps of the status.
+     *
+     * Implemented by <code>snd_pcm_sw_params_set_tstamp_mode</code>
+     * and <code>snd_pcm_sw_params_set_tstamp_type</code>.
+     *
+     * @param[in] type Clock of the timestamps.
+     */
+    void setTimestamps( snd_pcm_tstamp_type_t type );
+    /**
+     * @brief Obtains status of the PCM.
+     *
+     * Implemented by <code>snd_pcm_status</code>. Unlike
+     * the others, it doesn't throw, so that it may be
+     * used while capturing.
+     *
+     * @param[out] status Where to store the status.
+     *
+     * @return Zero, the error code on failure.
+     */
+    int status( snd_pcm_status_t* status );
 
     /**
      * @brief Reads interleaved samples from the PCM.
@@ -115,6 +136,19 @@ public:
      * @return Number of frames read.
      */
     snd_pcm_sframes_t readNonint( void** buffers, snd_pcm_uframes_t size );
+    /**
+     * @brief Reads noninterleaved samples, recovering from errors.
+     *
+     * Implemented by <code>snd_pcm_readn</code> and
+     * <code>snd_pcm_recover</code>.
+     *
+     * @param[out] buffers Where to store the samples.
+     * @param[in]  size    Number of frames to be read.
+     *
+     * @return Number of frames read, the error code
+     *         if the PCM had to be recovered.
+     */
+    snd_pcm_sframes_t readNonintRecover( void** buffers, snd_pcm_uframes_t size );
     /**
      * @brief Writes noninterleaved samples to the PCM.
      *
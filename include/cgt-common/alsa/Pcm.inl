@@ -82,6 +82,36 @@ inline void Pcm::recover( int err, int silent )
                         ::snd_strerror( code ) ) );
 }
 
+inline void Pcm::setTimestamps( snd_pcm_tstamp_type_t type )
+{
+    snd_pcm_sw_params_t* params;
+    int code = ::snd_pcm_sw_params_malloc( &params );
+
+    // Change only the timestamps of the current params
+    if( 0 <= code )
+    {
+        if( 0 <= ( code = ::snd_pcm_sw_params_current( mPcm, params ) )
+            && 0 <= ( code = ::snd_pcm_sw_params_set_tstamp_mode( mPcm, params, SND_PCM_TSTAMP_ENABLE ) )
+            && 0 <= ( code = ::snd_pcm_sw_params_set_tstamp_type( mPcm, params, type ) ) )
+            code = ::snd_pcm_sw_params( mPcm, params );
+
+        ::snd_pcm_sw_params_free( params );
+    }
+
+    // Check for error
+    if( 0 > code )
+        // Throw an error message
+        throw except::RuntimeError(
+            ::ssprintf( "Failed to enable timestamps of PCM device: %s",
+                        ::snd_strerror( code ) ) );
+}
+
+inline int Pcm::status( snd_pcm_status_t* status )
+{
+    // Obtain the status
+    return ::snd_pcm_status( mPcm, status );
+}
+
 inline snd_pcm_sframes_t Pcm::readInt( void* buffer, snd_pcm_uframes_t size )
 {
     // Read the frames
@@ -130,6 +160,19 @@ inline snd_pcm_sframes_t Pcm::readNonint( void** buffers, snd_pcm_uframes_t size
     return code;
 }
 
+inline snd_pcm_sframes_t Pcm::readNonintRecover( void** buffers, snd_pcm_uframes_t size )
+{
+    // Read the frames
+    snd_pcm_sframes_t code = ::snd_pcm_readn( mPcm, buffers, size );
+
+    // Recover from overrun, the samples are lost
+    if( 0 > code )
+        recover( code, 1 );
+
+    // Return the number of read samples or the error
+    return code;
+}
+
 inline snd_pcm_sframes_t Pcm::writeNonint( void** buffers, snd_pcm_uframes_t size )
 {
     // Write the frames
@@ -28,15 +28,18 @@
 /* Standard includes                                                     */
 /*************************************************************************/
 // C standard library
+#include <cerrno>
 #include <climits>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 
 // C++ standard library
 #include <algorithm>
 #include <map>
 #include <memory>
+#include <numeric>
 #include <queue>
 #include <set>
 #include <stdexcept>
@@ -51,6 +54,25 @@
 #   include <inttypes.h>
 #endif /* HAVE_INTTYPES_H */
 
+// POSIX memory mapped files and shared memory
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+// POSIX threads
+#include <pthread.h>
+// POSIX semaphores
+#include <semaphore.h>
+// POSIX signals
+#include <signal.h>
+// POSIX clocks
+#include <time.h>
+
+// Static probes
+#if defined( CGT_USDT ) && defined( HAVE_SYS_SDT_H )
+#   include <sys/sdt.h>
+#endif /* CGT_USDT && HAVE_SYS_SDT_H */
+
 /*************************************************************************/
 /* Dependencies' includes                                                */
 /*************************************************************************/
@@ -10,6 +10,7 @@
 #ifndef __CGT__CONFIG__ARGV_PARSER_H__INCL__
 #define __CGT__CONFIG__ARGV_PARSER_H__INCL__
 
+#include "config/ConfigMgr.h"
 #include "config/XmlParser.h"
 
 namespace cgt { namespace config {
@@ -39,6 +40,12 @@ public:
     /// A map of long options.
     typedef std::map< std::string, IOption* > LongoptMap;
 
+    /**
+     * @brief Initializes the parser.
+     *
+     * @param[in] config The config manager to set values in.
+     */
+    ArgvParser( ConfigMgr& config = ConfigMgr::get() ) : mConfigMgr( config ) {}
     /**
      * @brief Removes all registered options.
      */
@@ -140,6 +147,8 @@ protected:
      */
     unsigned int parse( char* key, unsigned int argc, char* argv[] );
 
+    /// The config manager to set values in.
+    ConfigMgr&  mConfigMgr;
     /// A set of registered options.
     OptionSet   mOptions;
     /// A map with short options.
@@ -276,8 +285,10 @@ class ArgvParser::ConfigOption
 public:
     /**
      * @brief Initializes the config option.
+     *
+     * @param[in] config The config manager to import into.
      */
-    ConfigOption();
+    ConfigOption( ConfigMgr& config );
 
     /**
      * @brief Parses the arguments.
@@ -307,13 +318,14 @@ public:
      * All strings are assumed to be statically allocated and
      * thus NOT freed.
      *
+     * @param[in] config      The config manager to set the flag in.
      * @param[in] shortKey    The short key of the option.
      * @param[in] longKey     The long key of the option.
      * @param[in] configKey   The flag's configuration key.
      * @param[in] description Description of the option.
      * @param[in] value       The value to set.
      */
-    FlagOption( char shortKey, const char* longKey,
+    FlagOption( ConfigMgr& config, char shortKey, const char* longKey,
                 const char* configKey, const char* description,
                 bool value );
 
@@ -323,6 +335,8 @@ public:
     unsigned int parse( unsigned int argc, char* argv[] );
 
 protected:
+    /// The config manager to set the flag in.
+    ConfigMgr& mConfigMgr;
     /// The configuration key.
     const char* mConfigKey;
     /// The boolean value to set.
@@ -374,12 +388,13 @@ public:
      * All strings are assumed to be statically allocated and
      * thus NOT freed.
      *
+     * @param[in] config      The config manager to set the value in.
      * @param[in] shortKey    The short key of the option.
      * @param[in] longKey     The long key of the option.
      * @param[in] configKey   The flag's configuration key.
      * @param[in] description Description of the option.
      */
-    ValueOption( char shortKey, const char* longKey,
+    ValueOption( ConfigMgr& config, char shortKey, const char* longKey,
                  const char* configKey, const char* description );
 
     /**
@@ -388,6 +403,8 @@ public:
     unsigned int parse( unsigned int argc, char* argv[] );
 
 protected:
+    /// The config manager to set the value in.
+    ConfigMgr& mConfigMgr;
     /// The configuration key.
     const char* mConfigKey;
 };
@@ -11,7 +11,6 @@
 #define __CGT__CONFIG__CONFIG_MGR_H__INCL__
 
 #include "db/TextValue.h"
-#include "util/Singleton.h"
 
 namespace cgt { namespace config {
 
@@ -21,12 +20,23 @@ namespace cgt { namespace config {
  * Basically it's a map with
  * both keys and values being text.
  *
+ * Each pipeline may have a manager of its own, passed
+ * explicitly to whatever it configures; copying one
+ * is the way to derive a variant. The process-wide
+ * instance is only what everyone uses by default.
+ *
  * @author Bloody.Rabbit
  */
 class ConfigMgr
-: public util::Singleton< ConfigMgr >
 {
 public:
+    /**
+     * @brief Obtains the process-wide instance.
+     *
+     * @return The instance.
+     */
+    static ConfigMgr& get();
+
     /**
      * @brief Obtains a value from the config manager.
      *
@@ -35,10 +45,28 @@ public:
      * @return The value in question.
      */
     db::TextValue& operator[]( const std::string& key ) { return mValues[ key ]; }
+    /**
+     * @brief Looks up a value without adding it.
+     *
+     * @param[in] key The key identifying the value.
+     *
+     * @return The value, NULL if there's none.
+     */
+    const db::TextValue* find( const std::string& key ) const;
 
 protected:
+    /**
+     * @brief Creates the process-wide instance.
+     */
+    static void create();
+
     /// The values map.
     std::map< std::string, db::TextValue > mValues;
+
+    /// The process-wide instance.
+    static std::auto_ptr< ConfigMgr > mInstance;
+    /// Makes sure it's created once.
+    static pthread_once_t             mInstanceOnce;
 };
 
 /// A macro for convenient access.
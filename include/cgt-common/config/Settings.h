@@ -0,0 +1,61 @@
+/**
+ * @file config/Settings.h
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#ifndef __CGT__CONFIG__SETTINGS_H__INCL__
+#define __CGT__CONFIG__SETTINGS_H__INCL__
+
+#include "config/ConfigMgr.h"
+
+namespace cgt { namespace config {
+
+/**
+ * @brief A typed snapshot of the configuration.
+ *
+ * The keys, their types and defaults are declared once
+ * in config/Settings.def. The text values are parsed
+ * once, when the snapshot is taken; after that it's just
+ * plain fields, so pass it around as const and read it
+ * anywhere without lookups nor parsing.
+ *
+ * Each snapshot gets a new version, so that users can
+ * tell whether the configuration changed.
+ *
+ * @author Bloody.Rabbit
+ */
+struct Settings
+{
+#define CGT_SETTING( type, name, key, value ) \
+    type name;
+#include "config/Settings.def"
+#undef CGT_SETTING
+
+    /// Version of the snapshot, 0 for the defaults.
+    uint64 version;
+
+    /**
+     * @brief Initializes the defaults.
+     */
+    Settings();
+    /**
+     * @brief Takes a snapshot of a config manager.
+     *
+     * Keys which aren't set keep their defaults.
+     *
+     * @param[in] config The config manager.
+     */
+    explicit Settings( const ConfigMgr& config );
+
+protected:
+    /// The last version given out.
+    static volatile uint64 mLastVersion;
+};
+
+}} // cgt::config
+
+#endif /* !__CGT__CONFIG__SETTINGS_H__INCL__ */
@@ -10,6 +10,8 @@
 #ifndef __CGT__CONFIG__XML_PARSER_H__INCL__
 #define __CGT__CONFIG__XML_PARSER_H__INCL__
 
+#include "config/ConfigMgr.h"
+
 namespace cgt { namespace config {
 
 /**
@@ -21,6 +23,13 @@ class XmlParser
 : public TiXmlVisitor
 {
 public:
+    /**
+     * @brief Initializes the parser.
+     *
+     * @param[in] config The config manager to import into.
+     */
+    XmlParser( ConfigMgr& config = ConfigMgr::get() );
+
     /**
      * @brief Visit an element.
      */
@@ -37,6 +46,8 @@ public:
     bool Visit( const TiXmlText& text );
 
 protected:
+    /// The config manager to import into.
+    ConfigMgr&  mConfigMgr;
     /// Current config key.
     std::string mConfigKey;
 };
@@ -11,6 +11,8 @@
 #define __CGT__CORE__ANALYSER_H__INCL__
 
 #include "alsa/Pcm.h"
+#include "core/HopProfile.h"
+#include "util/Thread.h"
 
 namespace cgt {
 /**
@@ -23,9 +25,22 @@ namespace core {
 /**
  * @brief Base class for signal analysers.
  *
+ * May be run by a thread, which keeps stepping
+ * until stop is requested. Alternatively, a host which
+ * has the samples already may push them by process().
+ *
+ * Once initialized, neither step() nor process() allocate;
+ * trouble with the capture is counted rather than thrown.
+ *
+ * Each step captures a hop of samples and checks its
+ * energy against a gate; subclasses analyse only hops
+ * which pass it. When the gate closes, it waits a few
+ * hops first, so that decaying notes aren't cut short.
+ *
  * @author Bloody.Rabbit
  */
 class Analyser
+: public util::Thread::IRunnable
 {
 public:
     /**
@@ -58,8 +73,172 @@ public:
          *
          * No new data will be added until another
          * call to start().
+         *
+         * @param[in] captured When the newest sample was captured
+         *                     [ns], see Frame::captured.
+         */
+        virtual void end( uint64 captured ) = 0;
+    };
+
+    /**
+     * @brief An observer of fundamental frequencies.
+     *
+     * Unlike IObserver, which receives every detected
+     * frequency, it receives only estimated fundamentals.
+     *
+     * @author Bloody.Rabbit
+     */
+    class IPitchObserver
+    {
+    public:
+        /**
+         * @brief Adds a fundamental frequency.
+         *
+         * Called within an analysis run, after
+         * IObserver::start() and before the first
+         * IObserver::add().
+         *
+         * @param[in] freq     The estimated fundamental [Hz].
+         * @param[in] salience Salience of the estimate [dB].
+         */
+        virtual void addPitch( double freq, double salience ) = 0;
+    };
+
+    /**
+     * @brief A detected frequency.
+     *
+     * @author Bloody.Rabbit
+     */
+    struct Peak
+    {
+        /// The frequency [Hz].
+        double       freq;
+        /// Magnitude of the frequency.
+        double       mag;
+        /// Analyser-specific bin the frequency was found in.
+        unsigned int bin;
+        /// Confidence of the estimate, from 0 to 1.
+        double       confidence;
+    };
+
+    /**
+     * @brief Result of a single analysis run.
+     *
+     * The arrays are owned by the analyser and remain
+     * valid only until the observer returns.
+     *
+     * @author Bloody.Rabbit
+     */
+    struct Frame
+    {
+        /// Number of samples captured before the newest one.
+        uint64       position;
+        /// The sample rate.
+        unsigned int rate;
+        /// When the newest sample was captured [ns], monotonic clock, 0 if unknown.
+        uint64       captured;
+        /// Group delay of the analysis, how far behind the newest sample it is [samples].
+        unsigned int delay;
+
+        /// Estimated fundamentals, magnitude is their salience.
+        const Peak* pitches;
+        /// Number of fundamentals.
+        size_t      pitchCount;
+        /// Detected frequencies, in ascending order.
+        const Peak* peaks;
+        /// Number of frequencies.
+        size_t      peakCount;
+
+        /**
+         * @brief Obtains time of the newest sample.
+         *
+         * @return The time since init() [s].
+         */
+        double time() const { return double( position ) / rate; }
+    };
+
+    /**
+     * @brief An observer of whole analysis runs.
+     *
+     * @author Bloody.Rabbit
+     */
+    class IFrameObserver
+    {
+    public:
+        /**
+         * @brief Adds an analysis frame.
+         *
+         * @param[in] frame The frame.
+         */
+        virtual void addFrame( const Frame& frame ) = 0;
+    };
+
+    /**
+     * @brief A change applied between hops.
+     *
+     * Anything expensive is done when the change is made,
+     * apply() only swaps it in: it runs in the analysis
+     * thread, so it must not allocate, lock nor throw.
+     * Applied changes are deleted by reclaim(), by the thread
+     * posting the next one, or when the analyser is freed.
+     *
+     * @author Bloody.Rabbit
+     */
+    class Change
+    {
+        friend class Analyser;
+
+    public:
+        /**
+         * @brief Initializes the change.
+         */
+        Change() : mNext( NULL ) {}
+        /**
+         * @brief A virtual destructor.
          */
-        virtual void end() = 0;
+        virtual ~Change() {}
+
+        /**
+         * @brief Applies the change.
+         *
+         * @param[in] analyser The analyser to change.
+         */
+        virtual void apply( Analyser& analyser ) = 0;
+
+    private:
+        /// The next change in a list.
+        Change* mNext;
+    };
+
+    /**
+     * @brief Feeds frames to per-frequency observers.
+     *
+     * @author Bloody.Rabbit
+     */
+    class ObserverAdapter
+    : public IFrameObserver
+    {
+    public:
+        /**
+         * @brief Binds the observers.
+         *
+         * @param[in] observer      The observer.
+         * @param[in] pitchObserver The pitch observer, NULL if none.
+         */
+        ObserverAdapter( IObserver& observer, IPitchObserver* pitchObserver = NULL );
+
+        /**
+         * @brief Passes the frame on.
+         *
+         * @param[in] frame The frame.
+         */
+        void addFrame( const Frame& frame );
+
+    protected:
+        /// The bound observer.
+        IObserver&      mObserver;
+        /// The bound pitch observer.
+        IPitchObserver* mPitchObserver;
     };
 
     /**
@@ -67,7 +246,7 @@ public:
      *
      * @param[in] observer The observer.
      */
-    Analyser( IObserver& observer );
+    Analyser( IFrameObserver& observer );
     /**
      * @brief Releases acquired resources.
      */
@@ -92,44 +271,235 @@ public:
      */
     unsigned int captureSize() const { return mCaptureSize; }
 
+    /**
+     * @brief Obtains the gate threshold.
+     *
+     * @return The threshold [dB].
+     */
+    double gateThreshold() const { return mGateThreshold; }
+    /**
+     * @brief Sets the gate threshold.
+     *
+     * @param[in] threshold The threshold [dB], -HUGE_VAL to disable the gate.
+     */
+    void setGateThreshold( double threshold );
+    /**
+     * @brief Obtains number of hops the gate stays open below threshold.
+     *
+     * @return Number of hops.
+     */
+    unsigned int gateHold() const { return mGateHold; }
+    /**
+     * @brief Sets number of hops the gate stays open below threshold.
+     *
+     * @param[in] hold Number of hops.
+     */
+    void setGateHold( unsigned int hold ) { mGateHold = hold; }
+
+    /**
+     * @brief Obtains number of hops analysed.
+     *
+     * @return Number of hops.
+     */
+    uint64 hopsAnalysed() const { return mHopsAnalysed; }
+    /**
+     * @brief Obtains number of hops skipped by the gate.
+     *
+     * @return Number of hops.
+     */
+    uint64 hopsSkipped() const { return mHopsSkipped; }
+    /**
+     * @brief Obtains number of gaps in the captured samples.
+     *
+     * @return Number of gaps.
+     */
+    uint64 gaps() const { return mGaps; }
+    /**
+     * @brief Obtains number of reads which got fewer samples than asked.
+     *
+     * @return Number of reads.
+     */
+    uint64 shortReads() const { return mShortReads; }
+
+#ifdef CGT_PROFILE
+    /**
+     * @brief Obtains where the time of hops goes.
+     *
+     * @return The profile, recorded by the thread running the analyser.
+     */
+    const HopProfile& profile() const { return mProfile; }
+#endif /* CGT_PROFILE */
+
+    /**
+     * @brief Obtains group delay of the analysis.
+     *
+     * What's reported describes the signal this far
+     * behind the newest sample; for a symmetric window,
+     * it's the middle of it.
+     *
+     * @return The delay [samples].
+     */
+    virtual unsigned int groupDelay() const { return ( bufferSize() - 1 ) / 2; }
+    /**
+     * @brief Checks whether the fundamentals are reported.
+     *
+     * If not, the frames carry only the frequencies and
+     * it's up to the observers to tell the fundamentals.
+     *
+     * @retval true  The frames carry the fundamentals.
+     * @retval false The frames carry frequencies only.
+     */
+    virtual bool emitsPitches() const { return false; }
+
     /**
      * @brief Obtains current observer.
      *
      * @return Current observer.
      */
-    IObserver& observer() const { return *mObserver; }
+    IFrameObserver& observer() const { return *mObserver; }
     /**
      * @brief Sets new observer.
      *
      * @param[in] observer The new observer.
      */
-    void setObserver( IObserver& observer ) { mObserver = &observer; }
+    void setObserver( IFrameObserver& observer ) { mObserver = &observer; }
 
     /**
-     * @brief Initializes the analyser.
+     * @brief Initializes the analyser to capture from a PCM.
      *
      * @param[in] name        Name of the PCM.
      * @param[in] rate        The sample rate to use.
      * @param[in] bufferSize  The size of the sample buffer.
      * @param[in] captureSize The sample capture size.
      */
-    virtual void init( const char* name, unsigned int rate,
-                       unsigned int bufferSize, unsigned int captureSize );
+    void init( const char* name, unsigned int rate,
+               unsigned int bufferSize, unsigned int captureSize );
+    /**
+     * @brief Initializes the analyser for pushed samples.
+     *
+     * @param[in] rate        The sample rate of the samples.
+     * @param[in] bufferSize  The size of the sample buffer.
+     * @param[in] captureSize The sample capture size.
+     */
+    virtual void init( unsigned int rate, unsigned int bufferSize,
+                       unsigned int captureSize );
     /**
      * @brief Frees the analyser resources.
      */
     virtual void free();
 
+    /**
+     * @brief Posts a change to apply before the next hop.
+     *
+     * Safe to call from any thread while the analysis runs;
+     * changes are applied in the order they were posted.
+     * Never throws.
+     *
+     * @param[in] change The change, deleted once applied.
+     */
+    void post( Change* change );
+    /**
+     * @brief Deletes the changes applied so far.
+     *
+     * The analysis thread doesn't free them itself, so
+     * call this once in a while from any other thread;
+     * post() does so as well.
+     */
+    void reclaim();
+    /**
+     * @brief Prepares a change of the capture size.
+     *
+     * Nothing is replanned and the analysis state survives.
+     *
+     * @param[in] captureSize The new capture size.
+     *
+     * @return The change, post it or delete it.
+     */
+    Change* prepareCaptureSize( unsigned int captureSize ) const;
+    /**
+     * @brief Prepares a change of the buffer size.
+     *
+     * The new buffers and plans are prepared in the calling
+     * thread and swapped in between hops, keeping the latest
+     * samples; a larger buffer starts with silence at the
+     * front. Capture goes on without a gap.
+     *
+     * @param[in] bufferSize  The new buffer size.
+     * @param[in] captureSize The new capture size.
+     *
+     * @return The change, post it or delete it.
+     */
+    Change* prepareResize( unsigned int bufferSize, unsigned int captureSize ) const;
+    /**
+     * @brief Prepares capturing from another PCM.
+     *
+     * The PCM is opened in the calling thread, at the
+     * current sample rate; the switch is reported as a gap.
+     *
+     * @param[in] name Name of the PCM.
+     *
+     * @return The change, post it or delete it.
+     */
+    Change* prepareReopen( const char* name ) const;
+    /**
+     * @brief Changes the capture size before the next hop.
+     *
+     * @param[in] captureSize The new capture size.
+     */
+    void setCaptureSize( unsigned int captureSize );
+    /**
+     * @brief Changes the buffer size before the next hop.
+     *
+     * @param[in] bufferSize  The new buffer size.
+     * @param[in] captureSize The new capture size.
+     */
+    void resize( unsigned int bufferSize, unsigned int captureSize );
+    /**
+     * @brief Captures from another PCM from the next hop on.
+     *
+     * @param[in] name Name of the PCM.
+     */
+    void reopen( const char* name );
+
     /**
      * @brief Runs a step in the process.
+     *
+     * If samples get lost while capturing, the hop is dropped
+     * and the next step captures a full buffer again, so that
+     * no analysis spans the gap.
+     */
+    void step();
+    /**
+     * @brief Processes pushed samples.
+     *
+     * Blocks may be of any size; a frame is passed to the
+     * observer for each complete hop. The samples go straight
+     * to the sample buffer, so blocks of the capture size
+     * cost no extra copy.
+     *
+     * Safe to call from a real-time audio callback as long
+     * as the observer is: it doesn't allocate, lock nor throw.
+     * Does nothing before init().
+     *
+     * @param[in] samples The samples.
+     * @param[in] count   Number of the samples.
+     */
+    void process( const float* samples, size_t count );
+    /**
+     * @brief Runs steps until stop is requested.
+     *
+     * @param[in] thread The running thread.
      */
-    virtual void step() { ( this->* ( CAPTURE_ROUTINES[ mCapture ] ) )(); }
+    void run( util::Thread& thread );
     /**
      * @brief Resets the process.
      */
     virtual void reset();
 
 protected:
+    /// Hysteresis of the gate [dB].
+    static const double GATE_HYSTERESIS;
+
     /**
      * @brief Describes current capture state.
      *
@@ -141,21 +511,190 @@ protected:
         CAPTURE_STEP  //< A step capture pending.
     };
 
+    // Changes made by the analyser itself.
+    class CaptureSizeChange;
+    class ResizeChange;
+    class ReopenChange;
+
+    /**
+     * @brief Applies the posted changes.
+     *
+     * Called by the analysis thread between hops.
+     */
+    void applyChanges();
+    /**
+     * @brief Creates an analyser set up like this one.
+     *
+     * It's initialized and then adopted when resizing.
+     *
+     * @return The new analyser.
+     */
+    virtual Analyser* createTwin() const = 0;
+    /**
+     * @brief Swaps buffers and analysis state with a twin.
+     *
+     * Called between hops, so it must not allocate, lock
+     * nor throw. Overrides swap their own state, then
+     * call the parent.
+     *
+     * @param[in] twin The twin, made by createTwin().
+     */
+    virtual void adopt( Analyser& twin );
+    /**
+     * @brief Adapts the analysis state to a new capture size.
+     *
+     * Called between hops, once the size has changed.
+     *
+     * @param[in] previous The previous capture size.
+     */
+    virtual void rehop( unsigned int previous ) {}
+    /**
+     * @brief Deletes a list of changes.
+     *
+     * @param[in] changes The first change of the list.
+     */
+    static void deleteChanges( Change* changes );
+
     /**
      * @brief Fills the buffer entirely.
      *
      * Any previous captured content is overwritten.
+     *
+     * @retval true  The buffer is filled.
+     * @retval false Samples got lost, see read().
      */
-    void captureFull();
+    bool captureFull();
     /**
      * @brief Captures only a bit.
+     *
+     * @retval true  The hop is captured.
+     * @retval false Samples got lost, see read().
+     */
+    bool captureStep();
+    /**
+     * @brief Moves the samples a hop back, making room for a new one.
+     */
+    void shift();
+    /**
+     * @brief Reads samples from the PCM.
+     *
+     * Keeps reading after short reads, counting them. An overrun
+     * or a read getting nothing at all ends it as a gap, see lose().
+     * Throws only if the PCM can't be recovered.
+     *
+     * @param[out] samples Where to store the samples.
+     * @param[in]  count   Number of the samples.
+     *
+     * @retval true  All the samples are read, without a gap.
+     * @retval false Samples got lost.
      */
-    void captureStep();
+    bool read( double* samples, unsigned int count );
+    /**
+     * @brief Reports lost samples as a gap.
+     *
+     * The buffered samples don't connect to the next
+     * ones anymore, so a full capture is due.
+     */
+    void lose();
+    /**
+     * @brief Obtains when the newest sample read was captured.
+     *
+     * Uses the timestamp of the PCM status, less the samples
+     * still waiting to be read; the current time if the PCM
+     * has no timestamps.
+     *
+     * @return The time [ns], monotonic clock.
+     */
+    uint64 captureTime();
+    /**
+     * @brief Opens a PCM to capture from.
+     *
+     * @param[in] name Name of the PCM.
+     * @param[in] rate The sample rate to use.
+     *
+     * @return The PCM.
+     */
+    static alsa::Pcm* openPcm( const char* name, unsigned int rate );
+
+    /**
+     * @brief Analyses the captured samples.
+     *
+     * Called only if the gate is open.
+     */
+    virtual void analyse() = 0;
+    /**
+     * @brief Drops state which got stale while the gate was closed.
+     *
+     * Called when the gate opens again.
+     */
+    virtual void relock() {}
+    /**
+     * @brief Drops state which doesn't survive lost samples.
+     *
+     * Called when samples were lost, before the next
+     * ones are captured.
+     */
+    virtual void gap() {}
+
+    /**
+     * @brief Analyses a newly captured hop, if the gate lets it.
+     *
+     * @param[in] count Number of the newly captured samples.
+     */
+    void processHop( size_t count );
+    /**
+     * @brief Updates the gate.
+     *
+     * @param[in] samples The newly captured samples.
+     * @param[in] count   Number of the samples.
+     *
+     * @retval true  The gate is open.
+     * @retval false The gate is closed.
+     */
+    bool processGate( const double* samples, size_t count );
+    /**
+     * @brief Computes mean square of samples.
+     *
+     * @param[in] samples The samples.
+     * @param[in] count   Number of the samples.
+     *
+     * @return The mean square.
+     */
+    static double meanSquare( const double* samples, size_t count );
+
+    /**
+     * @brief Starts a new frame.
+     */
+    void startFrame();
+    /**
+     * @brief Adds a fundamental to the frame.
+     *
+     * @param[in] freq       The frequency [Hz].
+     * @param[in] mag        Salience of the fundamental.
+     * @param[in] bin        The bin it was found in.
+     * @param[in] confidence Confidence of the estimate.
+     */
+    void addPitch( double freq, double mag, unsigned int bin, double confidence );
+    /**
+     * @brief Adds a frequency to the frame.
+     *
+     * @param[in] freq       The frequency [Hz].
+     * @param[in] mag        Magnitude of the frequency.
+     * @param[in] bin        The bin it was found in.
+     * @param[in] confidence Confidence of the estimate.
+     */
+    void addPeak( double freq, double mag, unsigned int bin, double confidence );
+    /**
+     * @brief Passes the frame to the observer.
+     */
+    void endFrame();
 
     /// The bound observer.
-    IObserver* mObserver;
+    IFrameObserver* mObserver;
     /// The underlying PCM.
     alsa::Pcm* mPcm;
+    /// Status of the PCM, allocated with it.
+    snd_pcm_status_t* mStatus;
 
 #ifdef CGT_DEBUG_ANALYSIS_FREQ
     /// Current phase.
@@ -165,6 +704,33 @@ protected:
     /// Current capture state.
     Capture mCapture;
 
+    /// The gate threshold.
+    double       mGateThreshold;
+    /// Mean square opening the gate.
+    double       mGateOpen;
+    /// Mean square below which the gate starts closing.
+    double       mGateClose;
+    /// Number of hops to hold the gate open.
+    unsigned int mGateHold;
+    /// Number of hops left before the gate closes.
+    unsigned int mGateHoldLeft;
+    /// Whether the gate is open.
+    bool         mGateOpened;
+
+    /// Number of hops analysed.
+    uint64 mHopsAnalysed;
+    /// Number of hops skipped.
+    uint64 mHopsSkipped;
+    /// Number of gaps.
+    uint64 mGaps;
+    /// Number of short reads.
+    uint64 mShortReads;
+
+#ifdef CGT_PROFILE
+    /// Durations of the hop stages.
+    HopProfile mProfile;
+#endif /* CGT_PROFILE */
+
     /// Current sample rate.
     unsigned int mSampleRate;
     /// Size of the sample buffer.
@@ -174,9 +740,25 @@ protected:
 
     /// The sample buffer.
     double* mSamples;
+    /// Number of samples captured so far.
+    uint64  mPosition;
+    /// Number of samples pushed into the current hop.
+    size_t  mPushed;
+    /// When the newest sample was captured [ns].
+    uint64  mCaptured;
+
+    /// Fundamentals of the current frame.
+    std::vector< Peak > mPitches;
+    /// Frequencies of the current frame.
+    std::vector< Peak > mPeaks;
+
+    /// Changes posted and not applied yet, last posted first.
+    Change* volatile mPending;
+    /// Changes applied and not deleted yet.
+    Change* volatile mApplied;
 
     /// Capture state routine table.
-    static void ( Analyser::* CAPTURE_ROUTINES[] )();
+    static bool ( Analyser::* CAPTURE_ROUTINES[] )();
 };
 
 }} // cgt::core
@@ -0,0 +1,74 @@
+/**
+ * @file core/AnalyserFactory.h
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#ifndef __CGT__CORE__ANALYSER_FACTORY_H__INCL__
+#define __CGT__CORE__ANALYSER_FACTORY_H__INCL__
+
+#include "config/Settings.h"
+#include "core/Analyser.h"
+
+namespace cgt { namespace core {
+
+/**
+ * @brief Makes analysers as configured.
+ *
+ * The analyser is picked by the "cgt.analyser" setting
+ * and set up by the "cgt.fft.*", "cgt.yin.*", "cgt.cq.*"
+ * and "cgt.gate.*" ones. Each pipeline hands over its own
+ * settings, so several of them may differ.
+ *
+ * @author Bloody.Rabbit
+ */
+class AnalyserFactory
+{
+public:
+    /**
+     * @brief Binds the factory to settings.
+     *
+     * @param[in] settings The settings to follow.
+     */
+    AnalyserFactory( const config::Settings& settings );
+
+    /**
+     * @brief Makes an analyser.
+     *
+     * The analyser is not initialized yet, so it may
+     * be fed either by a PCM or by process().
+     *
+     * @param[in] observer The observer to report to.
+     *
+     * @return The analyser, delete it when done.
+     */
+    Analyser* create( Analyser::IFrameObserver& observer ) const;
+    /**
+     * @brief Reconfigures a running analyser.
+     *
+     * Buffer and capture sizes and the device are prepared
+     * here; they and the cheap parameters (cutoffs, thresholds,
+     * gate) are applied by the analysis thread between hops,
+     * so the pipeline keeps running. Changing the analyser,
+     * the sample rate or anything its setup depends on
+     * needs a new analyser.
+     *
+     * @param[in] analyser The analyser, made from @a previous.
+     * @param[in] previous The settings it was made from.
+     */
+    void reconfigure( Analyser& analyser, const config::Settings& previous ) const;
+
+protected:
+    // Applies the cheap parameters at once.
+    class Parameters;
+
+    /// The settings to follow.
+    const config::Settings& mSettings;
+};
+
+}} // cgt::core
+
+#endif /* !__CGT__CORE__ANALYSER_FACTORY_H__INCL__ */
@@ -0,0 +1,166 @@
+/**
+ * @file core/CqAnalyser.h
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#ifndef __CGT__CORE__CQ_ANALYSER_H__INCL__
+#define __CGT__CORE__CQ_ANALYSER_H__INCL__
+
+#include "core/Analyser.h"
+
+namespace cgt { namespace core {
+
+/**
+ * @brief A constant-Q spectral analyser.
+ *
+ * Bins are spaced logarithmically and each of them looks only
+ * at as many of the newest samples as its Q requires, so low
+ * notes are resolved by long windows while high notes react
+ * quickly. Implemented using precomputed sparse spectral
+ * kernels, so that per-step cost stays close to a single FFT.
+ *
+ * @author Bloody.Rabbit
+ */
+class CqAnalyser
+: public Analyser
+{
+public:
+    /// Kernel values smaller than this are dropped.
+    static const double KERNEL_THRESHOLD;
+
+    /**
+     * @brief Performs basic initialization.
+     *
+     * @param[in] observer      The observer.
+     * @param[in] minFreq       Frequency of the lowest bin [Hz].
+     * @param[in] maxFreq       Frequency of the highest bin [Hz].
+     * @param[in] binsPerOctave Number of bins per octave.
+     * @param[in] magCutoff     The magnitude cutoff value.
+     */
+    CqAnalyser( IFrameObserver& observer, double minFreq, double maxFreq,
+                unsigned int binsPerOctave, double magCutoff );
+    /**
+     * @brief Releases acquired resources.
+     */
+    ~CqAnalyser();
+
+    /**
+     * @brief Obtains current magnitude cutoff value.
+     *
+     * @return Current magnitude cutoff value.
+     */
+    double magnitudeCutoff() const { return mMagnitudeCutoff; }
+    /**
+     * @brief Sets new magnitude cutoff value.
+     *
+     * @param[in] magCutoff New magnitude cutoff value.
+     */
+    void setMagnitudeCutoff( double magCutoff ) { mMagnitudeCutoff = magCutoff; }
+
+    // Capturing from a PCM ends up here as well.
+    using Analyser::init;
+
+    /**
+     * @brief Initializes the analyser.
+     *
+     * @param[in] rate        The sample rate to use.
+     * @param[in] bufferSize  The size of the sample buffer.
+     * @param[in] captureSize The sample capture size.
+     */
+    void init( unsigned int rate, unsigned int bufferSize,
+               unsigned int captureSize );
+    /**
+     * @brief Frees the analyser resources.
+     */
+    void free();
+
+    /**
+     * @brief Obtains group delay of the lowest bin.
+     *
+     * Kernels end with the newest sample, the lowest
+     * bin has the longest one and lags the most.
+     *
+     * @return The delay [samples].
+     */
+    unsigned int groupDelay() const;
+
+protected:
+    /**
+     * @brief Analyses the captured samples.
+     */
+    void analyse();
+
+    /**
+     * @brief Creates an analyser set up like this one.
+     */
+    Analyser* createTwin() const;
+    /**
+     * @brief Swaps the arrays and the kernel with a twin.
+     */
+    void adopt( Analyser& twin );
+    /**
+     * @brief Obtains number of constant-Q bins.
+     *
+     * @return The number of bins.
+     */
+    size_t binCount() const { return mBinCount; }
+    /**
+     * @brief Computes frequency of a (fractional) bin.
+     *
+     * @param[in] bin The bin.
+     *
+     * @return The frequency [Hz].
+     */
+    double binFrequency( double bin ) const;
+
+    /**
+     * @brief Precomputes the sparse spectral kernel.
+     */
+    void initKernel();
+
+    /**
+     * @brief Applies the kernel to the FFT output.
+     */
+    void processKernel();
+    /**
+     * @brief Processes output.
+     */
+    void processOutput();
+
+    /// Our FFTW plan, shared.
+    fftw_plan mPlan;
+
+    /// Frequency of the lowest bin.
+    const double       mMinFreq;
+    /// Frequency of the highest bin.
+    const double       mMaxFreq;
+    /// Number of bins per octave.
+    const unsigned int mBinsPerOctave;
+
+    /// The magnitude cutoff.
+    double mMagnitudeCutoff;
+
+    /// Number of bins.
+    size_t  mBinCount;
+    /// Result of the FFT.
+    double* mFftOutput;
+    /// Magnitude of each bin.
+    double* mMagnitudes;
+
+    /// Offset of first kernel entry of each bin (plus one past the last).
+    size_t*       mKernelStart;
+    /// FFT bin of each kernel entry.
+    unsigned int* mKernelIndex;
+    /// Real part of each kernel entry.
+    double*       mKernelReal;
+    /// Imaginary part of each kernel entry.
+    double*       mKernelImag;
+};
+
+}} // cgt::core
+
+#endif /* !__CGT__CORE__CQ_ANALYSER_H__INCL__ */
@@ -11,28 +11,52 @@
 #define __CGT__CORE__FFT_ANALYSER_H__INCL__
 
 #include "core/Analyser.h"
-#include "stats/AverageRing.h"
-#include "stats/Derivative.h"
-#include "stats/Periodic.h"
+#include "core/HarmonicProduct.h"
 
 namespace cgt { namespace core {
 
 /**
  * @brief Core class of FFT.
  *
+ * Each frequency has its own noise floor, which falls
+ * immediately and rises slowly, so it follows the minimum
+ * of recent (smoothed) magnitudes. Only frequencies which exceed both
+ * their floor by a margin and the global cutoff are tracked; the
+ * floor of a tracked frequency doesn't rise, so held notes stay.
+ *
+ * The fractional part of each tracked frequency is given by
+ * the average phase advance between hops. All of the phase
+ * state is kept in plain per-frequency arrays, so that it
+ * can be dropped in bulk whenever it gets stale.
+ *
  * @author Bloody.Rabbit
  */
 class FftAnalyser
 : public Analyser
 {
 public:
+    /// The lowest noise floor (-120 dB).
+    static const double MIN_FLOOR;
+    /// Number of phase advances averaged per frequency.
+    static const unsigned int AVERAGE_LIMIT;
+
     /**
      * @brief Performs basic initialization.
      *
-     * @param[in] observer   The observer.
-     * @param[in] magCutoff  The magnitude cutoff value.
+     * @param[in] observer       The observer.
+     * @param[in] magCutoff      The magnitude cutoff value.
+     * @param[in] floorMargin    Margin above the noise floor [dB].
+     * @param[in] floorRise      Rise rate of the noise floor [dB/s].
+     * @param[in] floorSmoothing Time constant of the magnitudes
+     *                           smoothed for the floor [s].
+     */
+    FftAnalyser( IFrameObserver& observer, double magCutoff,
+                 double floorMargin, double floorRise,
+                 double floorSmoothing );
+    /**
+     * @brief Releases acquired resources.
      */
-    FftAnalyser( IObserver& observer, double magCutoff );
+    ~FftAnalyser();
 
     /**
      * @brief Obtains current magnitude cutoff value.
@@ -48,110 +72,205 @@ public:
      */
     void setMagnitudeCutoff( double ampCutoff ) { mMagnitudeCutoff = ampCutoff; }
 
+    /**
+     * @brief Obtains margin above the noise floor.
+     *
+     * @return The margin [dB].
+     */
+    double floorMargin() const { return mFloorMargin; }
+    /**
+     * @brief Sets margin above the noise floor.
+     *
+     * @param[in] margin The margin [dB].
+     */
+    void setFloorMargin( double margin ) { mFloorMargin = margin; }
+
+    /**
+     * @brief Obtains rise rate of the noise floor.
+     *
+     * @return The rise rate [dB/s].
+     */
+    double floorRise() const { return mFloorRise; }
+    /**
+     * @brief Sets rise rate of the noise floor.
+     *
+     * @param[in] rise The rise rate [dB/s].
+     */
+    void setFloorRise( double rise ) { mFloorRise = rise; }
+
+    /**
+     * @brief Obtains time constant of the magnitudes smoothed for the floor.
+     *
+     * @return The time constant [s].
+     */
+    double floorSmoothing() const { return mFloorSmoothing; }
+    /**
+     * @brief Sets time constant of the magnitudes smoothed for the floor.
+     *
+     * @param[in] smoothing The time constant [s], 0 for none.
+     */
+    void setFloorSmoothing( double smoothing ) { mFloorSmoothing = smoothing; }
+
+    /**
+     * @brief Obtains number of harmonics used for pitch detection.
+     *
+     * @return Number of harmonics, 0 if pitch detection is disabled.
+     */
+    unsigned int pitchHarmonics() const { return mPitchHarmonics; }
+    /**
+     * @brief Sets number of harmonics used for pitch detection.
+     *
+     * Takes effect on next init().
+     *
+     * @param[in] harmonics Number of harmonics, 0 to disable.
+     */
+    void setPitchHarmonics( unsigned int harmonics ) { mPitchHarmonics = harmonics; }
+
+    /**
+     * @brief Checks whether the fundamentals are reported.
+     *
+     * @retval true  Pitch detection is enabled.
+     * @retval false It's disabled.
+     */
+    bool emitsPitches() const { return 0 < mPitchHarmonics; }
+
+    /**
+     * @brief Obtains maximal number of frequencies per frame.
+     *
+     * @return The number of frequencies, 0 if unlimited.
+     */
+    size_t maxPeaks() const { return mMaxPeaks; }
+    /**
+     * @brief Sets maximal number of frequencies per frame.
+     *
+     * Only the strongest local maxima are kept.
+     *
+     * @param[in] maxPeaks The number of frequencies, 0 if unlimited.
+     */
+    void setMaxPeaks( size_t maxPeaks ) { mMaxPeaks = maxPeaks; }
+
+    // Capturing from a PCM ends up here as well.
+    using Analyser::init;
+
     /**
      * @brief Initializes the analyser.
      *
-     * @param[in] name        Name of the PCM.
      * @param[in] rate        The sample rate to use.
      * @param[in] bufferSize  The size of the sample buffer.
      * @param[in] captureSize The sample capture size.
      */
-    void init( const char* name, unsigned int rate,
-               unsigned int bufferSize, unsigned int captureSize );
+    void init( unsigned int rate, unsigned int bufferSize,
+               unsigned int captureSize );
     /**
      * @brief Frees the analyser resources.
      */
     void free();
 
     /**
-     * @brief Runs a step in the process.
+     * @brief Obtains time it took to lock again after the last reset.
+     *
+     * Measured from the reset until the first frame
+     * with a tracked frequency.
+     *
+     * @return The time [s], 0 if none measured yet.
      */
-    void step();
+    double relockTime() const { return mRelockTime; }
+
     /**
      * @brief Resets the process.
+     *
+     * Drops all state of the frequencies, including
+     * the noise floors, and refills the buffer.
      */
     void reset();
 
 protected:
     /**
-     * @brief Helper class of FftAnalyser.
+     * @brief Analyses the captured samples.
+     */
+    void analyse();
+    /**
+     * @brief Drops the stale phases.
+     */
+    void relock();
+    /**
+     * @brief Drops the phases, like relock().
      *
-     * Holds information about a particular frequency.
+     * The advance across the lost samples is unknown,
+     * so the frequencies aren't ready until tracked again.
+     */
+    void gap();
+
+    /**
+     * @brief Creates an analyser set up like this one.
+     */
+    Analyser* createTwin() const;
+    /**
+     * @brief Swaps the arrays with a twin, tracking from scratch.
+     */
+    void adopt( Analyser& twin );
+    /**
+     * @brief Rescales the phase references to the new hop.
+     *
+     * The averaged advances are in bins, so they stay valid.
+     */
+    void rehop( unsigned int previous );
+    /**
+     * @brief Orders frequencies by descending compound magnitude.
      *
      * @author Bloody.Rabbit
      */
-    class Frequency
+    class CompareCompound
     {
     public:
         /**
-         * @brief Primary constructor.
-         *
-         * @param[in] limit Number of samples to average from.
-         */
-        Frequency( unsigned int limit = 64 );
-        /**
-         * @brief Destroys the counter.
-         */
-        ~Frequency();
-
-        /**
-         * @brief Checks if the object is ready.
+         * @brief Binds the compound magnitudes.
          *
-         * It basically means that calling frequency() will
-         * yield reasonable value, not division by zero.
-         *
-         * @retval true  Object is ready.
-         * @retval false Object is not ready.
-         */
-        bool ready() const;
-        /**
-         * @brief Obtains current magnitude.
-         *
-         * @return The magnitude.
-         */
-        double magnitude() const { return mMagnitude; }
-        /**
-         * @brief Computes approximate fractional frequency.
-         *
-         * @return The frequency.
+         * @param[in] compound The compound magnitudes.
          */
-        double frequency() const;
+        CompareCompound( const double* compound ) : mCompound( compound ) {}
 
         /**
-         * @brief Updates the magnitude with new data.
+         * @brief Compares two frequencies.
          *
-         * @param[in] real Real part of the FFT output.
-         * @param[in] img  Imaginary part of the FFT output.
-         */
-        void updateMagnitude( double real, double img ) { mMagnitude = ::sqrt( real * real + img * img ); }
-        /**
-         * @brief Updates the information with new data.
+         * @param[in] a Index of the first frequency.
+         * @param[in] b Index of the second frequency.
          *
-         * @param[in] angle Angle of the frequency.
+         * @retval true  The first one is stronger.
+         * @retval false The first one is not stronger.
          */
-        void updateFrequency( double angle );
-
-        /**
-         * @brief Resets all the information.
-         */
-        void reset();
+        bool operator()( size_t a, size_t b ) const { return mCompound[ b ] < mCompound[ a ]; }
 
     protected:
-        /// Current magnitude.
-        double mMagnitude;
-
-        /// The statistics counter for frequency correction.
-        stats::ICounter< double, double >* mCounter;
+        /// The compound magnitudes.
+        const double* mCompound;
     };
 
     /**
-     * @brief Obtains Frequency object of a frequency.
+     * @brief Checks if a frequency has its offset ready.
+     *
+     * @param[in] index Index of the frequency.
+     *
+     * @retval true  Calling offset() yields reasonable value.
+     * @retval false The frequency isn't ready.
+     */
+    bool ready( size_t index ) const { return 0 < mAdvanceCounts[ index ]; }
+    /**
+     * @brief Obtains current magnitude of a frequency.
+     *
+     * @param[in] index Index of the frequency.
+     *
+     * @return The magnitude.
+     */
+    double magnitude( size_t index ) const { return mMagnitudes[ index + 1 ]; }
+    /**
+     * @brief Computes approximate fractional offset of a frequency.
      *
      * @param[in] index Index of the frequency.
      *
-     * @return The Frequency object of the frequency.
+     * @return The offset [bins].
      */
-    Frequency& frequency( size_t index ) const { return mFreqs[ index ]; }
+    double offset( size_t index ) const;
     /**
      * @brief Obtains number of frequencies.
      *
@@ -168,41 +287,105 @@ protected:
      */
     double compoundMagnitude( size_t index );
     /**
-     * @brief Checks a frequency.
+     * @brief Adds a frequency to the frame.
      *
-     * @param[in] indexCur Index of current frequency.
-     * @param[in] indexOther Index of the other frequency.
+     * @param[in] index Index of the frequency.
+     */
+    void addFrequency( size_t index );
+
+    /**
+     * @brief Updates the phase of a frequency.
      *
-     * @retval true  Frequency OK.
-     * @retval false Frequency not OK.
+     * @param[in] index Index of the frequency.
+     * @param[in] angle The angle, in periods.
      */
-    bool checkFrequency( size_t indexCur, size_t indexOther );
+    void updatePhase( size_t index, double angle );
     /**
-     * @brief Adds a frequency to the observer.
+     * @brief Drops the phase state of a frequency.
      *
      * @param[in] index Index of the frequency.
      */
-    void addFrequency( size_t index );
+    void resetPhase( size_t index );
+    /**
+     * @brief Drops the phase state of all frequencies.
+     */
+    void resetPhases();
+    /**
+     * @brief Starts measuring the time to lock again.
+     */
+    void startRelock();
 
     /**
      * @brief Processes frequencies.
      */
     void processFreqs();
+    /**
+     * @brief Computes compound magnitudes of all frequencies.
+     */
+    void processCompound();
+    /**
+     * @brief Finds local maxima, keeping the strongest ones.
+     */
+    void processPeaks();
     /**
      * @brief Processes output.
      */
     void processOutput();
+    /**
+     * @brief Processes the fundamental frequency.
+     */
+    void processPitch();
 
-    /// Our FFTW plan.
+    /// Our FFTW plan, shared.
     fftw_plan mPlan;
 
     /// The magnitude cutoff.
     double mMagnitudeCutoff;
+    /// Margin above the noise floor.
+    double mFloorMargin;
+    /// Rise rate of the noise floor.
+    double mFloorRise;
+    /// Time constant of the magnitudes smoothed for the floor.
+    double mFloorSmoothing;
+    /// Number of harmonics for pitch detection.
+    unsigned int mPitchHarmonics;
+    /// Maximal number of frequencies per frame.
+    size_t       mMaxPeaks;
+
+    /// The pitch detector.
+    HarmonicProduct* mPitch;
 
     /// Result of the FFT.
-    double*    mFftOutput;
-    /// Information of each frequency.
-    Frequency* mFreqs;
+    double*       mFftOutput;
+    /// Magnitude of each frequency, indexed by FFT bin.
+    double*       mMagnitudes;
+    /// Smoothed magnitude of each frequency.
+    double*       mSmoothed;
+    /// Noise floor of each frequency.
+    double*       mFloors;
+    /// Last angle of each frequency.
+    double*       mAngles;
+    /// Whether the last angle of each frequency is valid.
+    bool*         mAngleValid;
+    /// Last AVERAGE_LIMIT phase advances of each frequency.
+    double*       mAdvances;
+    /// Sum of the phase advances of each frequency.
+    double*       mAdvanceSums;
+    /// Number of phase advances of each frequency, kept below 2 * AVERAGE_LIMIT.
+    unsigned int* mAdvanceCounts;
+    /// Compound magnitude of each frequency, -1 if not ready, padded at both ends.
+    double*       mCompound;
+    /// Indices of the local maxima.
+    size_t*       mPeaks;
+    /// Number of the local maxima.
+    size_t        mPeakCount;
+
+    /// Position of the last reset.
+    uint64 mRelockStart;
+    /// Whether we're waiting for a lock.
+    bool   mRelocking;
+    /// Time the last lock took.
+    double mRelockTime;
 };
 
 }} // cgt::core
@@ -0,0 +1,114 @@
+/**
+ * @file core/FftCache.h
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#ifndef __CGT__CORE__FFT_CACHE_H__INCL__
+#define __CGT__CORE__FFT_CACHE_H__INCL__
+
+namespace cgt { namespace core {
+
+/**
+ * @brief Shares FFTW plans among analysers.
+ *
+ * Plans are made once per size, kind, flags and placement,
+ * on scratch arrays, and kept until the process exits. Users
+ * run them by fftw_execute_r2r() on their own arrays, which
+ * must come from fftw_malloc() (so that the alignment matches)
+ * and be in place if and only if the plan is.
+ *
+ * Safe to use from several threads; FFTW's planner isn't,
+ * so all planning must go through here.
+ *
+ * @author Bloody.Rabbit
+ */
+class FftCache
+{
+public:
+    /**
+     * @brief Obtains the process-wide instance.
+     *
+     * @return The instance.
+     */
+    static FftCache& get();
+    /**
+     * @brief Destroys the plans.
+     */
+    ~FftCache();
+
+    /**
+     * @brief Obtains a plan of a real-to-real transform.
+     *
+     * @param[in] size    Size of the transform.
+     * @param[in] kind    Kind of the transform.
+     * @param[in] flags   The planner flags.
+     * @param[in] inPlace Whether the input and the output are the same array.
+     *
+     * @return The plan, never destroy it.
+     */
+    fftw_plan plan( size_t size, fftw_r2r_kind kind,
+                    unsigned int flags, bool inPlace = false );
+protected:
+    /**
+     * @brief What a plan is made for.
+     *
+     * @author Bloody.Rabbit
+     */
+    struct PlanKey
+    {
+        /// Size of the transform.
+        size_t        size;
+        /// Kind of the transform.
+        fftw_r2r_kind kind;
+        /// The planner flags.
+        unsigned int  flags;
+        /// Whether it's in place.
+        bool          inPlace;
+
+        /**
+         * @brief Orders the keys.
+         *
+         * @param[in] key The other key.
+         *
+         * @retval true  This key goes first.
+         * @retval false It doesn't.
+         */
+        bool operator<( const PlanKey& key ) const;
+    };
+
+    /**
+     * @brief Initializes an empty cache.
+     */
+    FftCache();
+    /**
+     * @brief Creates the instance.
+     */
+    static void create();
+
+    /// Guards the plans.
+    pthread_mutex_t mMutex;
+    /// The plans.
+    std::map< PlanKey, fftw_plan > mPlans;
+
+    /// The instance.
+    static std::auto_ptr< FftCache > mInstance;
+    /// Makes sure it's created once.
+    static pthread_once_t            mInstanceOnce;
+
+private:
+    /// Copying is not allowed.
+    FftCache( const FftCache& );
+    /// Copying is not allowed.
+    FftCache& operator=( const FftCache& );
+};
+
+}} // cgt::core
+
+/// Shortcut to the plan cache.
+#define sFftCache core::FftCache::get()
+
+#endif /* !__CGT__CORE__FFT_CACHE_H__INCL__ */
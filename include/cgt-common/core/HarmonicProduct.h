@@ -0,0 +1,112 @@
+/**
+ * @file core/HarmonicProduct.h
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#ifndef __CGT__CORE__HARMONIC_PRODUCT_H__INCL__
+#define __CGT__CORE__HARMONIC_PRODUCT_H__INCL__
+
+namespace cgt { namespace core {
+
+/**
+ * @brief A harmonic product spectrum pitch detector.
+ *
+ * For every candidate bin, multiplies magnitudes found at
+ * its first few harmonics; the candidate with the largest
+ * product is the estimated fundamental. Unlike grouping
+ * of individual peaks, a louder 2nd harmonic does not
+ * steal the fundamental.
+ *
+ * @author Bloody.Rabbit
+ */
+class HarmonicProduct
+{
+public:
+    /// Lowest detectable fundamental [Hz].
+    static const double MIN_FREQ;
+    /// Highest detectable fundamental [Hz].
+    static const double MAX_FREQ;
+
+    /**
+     * @brief The primary constructor.
+     *
+     * @param[in] harmonics Number of harmonics to multiply.
+     */
+    HarmonicProduct( unsigned int harmonics );
+    /**
+     * @brief Releases acquired resources.
+     */
+    ~HarmonicProduct();
+
+    /**
+     * @brief Obtains number of multiplied harmonics.
+     *
+     * @return Number of harmonics.
+     */
+    unsigned int harmonics() const { return mHarmonics; }
+
+    /**
+     * @brief Obtains bin of the last estimate.
+     *
+     * @return The bin, 0 if there is no estimate.
+     */
+    size_t bin() const { return mBin; }
+    /**
+     * @brief Obtains salience of the last estimate.
+     *
+     * Salience is the mean magnitude of all
+     * the multiplied harmonics, in dB.
+     *
+     * @return The salience [dB].
+     */
+    double salience() const { return mSalience; }
+
+    /**
+     * @brief Initializes the detector.
+     *
+     * @param[in] count   Number of magnitudes to expect.
+     * @param[in] binFreq Frequency step between two bins [Hz].
+     */
+    void init( size_t count, double binFreq );
+    /**
+     * @brief Frees the detector resources.
+     */
+    void free();
+
+    /**
+     * @brief Processes a magnitude spectrum.
+     *
+     * @param[in] mags Magnitudes, indexed by bin.
+     *
+     * @retval true  A fundamental has been found.
+     * @retval false No fundamental found.
+     */
+    bool process( const double* mags );
+
+protected:
+    /// Number of multiplied harmonics.
+    const unsigned int mHarmonics;
+
+    /// Number of magnitudes.
+    size_t mCount;
+    /// The lowest candidate bin.
+    size_t mFirst;
+    /// One past the highest candidate bin.
+    size_t mLast;
+
+    /// Products of harmonic magnitudes, for each candidate.
+    double* mProducts;
+
+    /// Bin of the last estimate.
+    size_t mBin;
+    /// Salience of the last estimate.
+    double mSalience;
+};
+
+}} // cgt::core
+
+#endif /* !__CGT__CORE__HARMONIC_PRODUCT_H__INCL__ */
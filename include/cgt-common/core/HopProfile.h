@@ -0,0 +1,128 @@
+/**
+ * @file core/HopProfile.h
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#ifndef __CGT__CORE__HOP_PROFILE_H__INCL__
+#define __CGT__CORE__HOP_PROFILE_H__INCL__
+
+#include "stats/Histogram.h"
+
+namespace cgt { namespace core {
+
+/**
+ * @brief Where an analyser spends the time of a hop.
+ *
+ * Keeps a histogram of durations per stage, in nanoseconds.
+ * Only the thread running the analyser records into it, so
+ * that no locking is needed; others take snapshots.
+ *
+ * Stages are recorded only if built with CGT_PROFILE; they
+ * go to the trace as well, if it's been started.
+ *
+ * @author Bloody.Rabbit
+ */
+class HopProfile
+{
+public:
+    /**
+     * @brief The stages of a hop.
+     *
+     * @author Bloody.Rabbit
+     */
+    enum Stage
+    {
+        STAGE_CAPTURE,   ///< Waiting for the capture.
+        STAGE_SHIFT,     ///< Shifting the samples.
+        STAGE_TRANSFORM, ///< Transforming the samples.
+        STAGE_PROCESS,   ///< Processing the transform.
+        STAGE_OUTPUT,    ///< Picking what's reported, the observer included.
+        STAGE_OBSERVER,  ///< Handing the frame to the observer.
+        STAGE_HOP,       ///< All of a captured hop.
+
+        STAGE_COUNT
+    };
+
+    /**
+     * @brief Times the rest of a scope.
+     *
+     * @author Bloody.Rabbit
+     */
+    class Timer
+    {
+    public:
+        /**
+         * @brief Starts the timer.
+         *
+         * @param[in] profile The profile to record into.
+         * @param[in] stage   The stage being timed.
+         */
+        Timer( HopProfile& profile, Stage stage );
+        /**
+         * @brief Records the time elapsed.
+         */
+        ~Timer();
+
+    protected:
+        /// The profile to record into.
+        HopProfile& mProfile;
+        /// The stage being timed.
+        Stage       mStage;
+        /// When it started [ns].
+        uint64      mStart;
+    };
+
+    /// Names of the stages.
+    static const char* const STAGE_NAMES[ STAGE_COUNT ];
+
+    /**
+     * @brief Records duration of a stage.
+     *
+     * @param[in] stage    The stage.
+     * @param[in] duration Its duration [ns].
+     */
+    void record( Stage stage, uint64 duration ) { mStages[ stage ].add( duration ); }
+
+    /**
+     * @brief Obtains durations of a stage.
+     *
+     * @param[in] stage The stage.
+     *
+     * @return The histogram [ns].
+     */
+    const stats::Histogram& stage( Stage stage ) const { return mStages[ stage ]; }
+
+    /**
+     * @brief Copies all the histograms.
+     *
+     * @param[out] copy Where to copy them.
+     */
+    void snapshot( HopProfile& copy ) const;
+    /**
+     * @brief Leaves only durations recorded after an earlier snapshot.
+     *
+     * @param[in] earlier The earlier snapshot.
+     */
+    void since( const HopProfile& earlier );
+
+protected:
+    /// Durations of the stages.
+    stats::Histogram mStages[ STAGE_COUNT ];
+};
+
+}} // cgt::core
+
+#ifdef CGT_PROFILE
+/// Records the rest of the scope as a stage into mProfile.
+#   define CGT_PROFILE_STAGE( stage ) \
+        const core::HopProfile::Timer profileTimer( mProfile, core::HopProfile::stage )
+#else /* CGT_PROFILE */
+/// Profiling is compiled out.
+#   define CGT_PROFILE_STAGE( stage )
+#endif /* CGT_PROFILE */
+
+#endif /* !__CGT__CORE__HOP_PROFILE_H__INCL__ */
@@ -0,0 +1,76 @@
+/**
+ * @file core/LatencyMeter.h
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#ifndef __CGT__CORE__LATENCY_METER_H__INCL__
+#define __CGT__CORE__LATENCY_METER_H__INCL__
+
+#include "stats/Histogram.h"
+
+namespace cgt { namespace core {
+
+/**
+ * @brief Measures how late frames are shown.
+ *
+ * Two latencies are kept for each frame shown: from the
+ * capture of its newest sample, which is what the pipeline
+ * adds, and from the middle of what's been analysed, which
+ * adds the group delay of the analysis and is what a player
+ * actually waits for. Only the second one tells apart
+ * buffer sizes; the hop size shows in both.
+ *
+ * Fed by the thread which shows the frames, read by others
+ * the same way as any histogram.
+ *
+ * @author Bloody.Rabbit
+ */
+class LatencyMeter
+{
+public:
+    /**
+     * @brief Records a frame being shown.
+     *
+     * Frames with unknown capture time are ignored.
+     *
+     * @param[in] captured When its newest sample was captured [ns].
+     * @param[in] delay    Group delay of the analysis [samples].
+     * @param[in] rate     The sample rate.
+     * @param[in] shown    When it's been shown [ns].
+     */
+    void add( uint64 captured, unsigned int delay, unsigned int rate, uint64 shown );
+
+    /**
+     * @brief Obtains latency from the capture.
+     *
+     * @return The histogram [ns].
+     */
+    const stats::Histogram& pipeline() const { return mPipeline; }
+    /**
+     * @brief Obtains latency from the middle of the analysis.
+     *
+     * @return The histogram [ns].
+     */
+    const stats::Histogram& total() const { return mTotal; }
+
+    /**
+     * @brief Describes the latencies.
+     *
+     * @return The description.
+     */
+    std::string summary() const;
+
+protected:
+    /// Latencies from the capture [ns].
+    stats::Histogram mPipeline;
+    /// Latencies from the middle of the analysis [ns].
+    stats::Histogram mTotal;
+};
+
+}} // cgt::core
+
+#endif /* !__CGT__CORE__LATENCY_METER_H__INCL__ */
@@ -0,0 +1,287 @@
+/**
+ * @file core/ObserverBus.h
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#ifndef __CGT__CORE__OBSERVER_BUS_H__INCL__
+#define __CGT__CORE__OBSERVER_BUS_H__INCL__
+
+#include "core/Analyser.h"
+#include "util/Thread.h"
+
+namespace cgt { namespace core {
+
+/**
+ * @brief Passes frames on to several observers.
+ *
+ * Each subscriber gets its own bounded queue and its own
+ * thread, so a slow subscriber never stalls the analysis
+ * nor the other subscribers (unless it asks for it by
+ * using POLICY_BLOCK).
+ *
+ * The queues are lock-free single-producer single-consumer
+ * rings. Slots have fixed capacity; each carries a sequence
+ * number, so a consumer detects slots overwritten while
+ * it was copying them.
+ *
+ * @author Bloody.Rabbit
+ */
+class ObserverBus
+: public Analyser::IFrameObserver
+{
+public:
+    /**
+     * @brief What to do when a queue is full.
+     *
+     * @author Bloody.Rabbit
+     */
+    enum Policy
+    {
+        POLICY_DROP_OLDEST, ///< Overwrite the oldest frame.
+        POLICY_BLOCK        ///< Wait for the subscriber.
+    };
+
+    /**
+     * @brief Initializes the bus.
+     *
+     * @param[in] maxPeaks Records kept per frame, the highest frequencies are cut.
+     */
+    ObserverBus( size_t maxPeaks );
+    /**
+     * @brief Stops and releases all subscribers.
+     */
+    ~ObserverBus();
+
+    /**
+     * @brief Obtains number of subscribers.
+     *
+     * @return The number of subscribers.
+     */
+    size_t subscriberCount() const { return mSubscribers.size(); }
+    /**
+     * @brief Obtains number of frames cut short.
+     *
+     * @return The number of truncated frames.
+     */
+    uint64 truncated() const { return mTruncated; }
+
+    /**
+     * @brief Adds a subscriber.
+     *
+     * The observer is called from a thread of its own.
+     * Must not be called after start().
+     *
+     * @param[in] observer The observer.
+     * @param[in] capacity Length of its queue [frames].
+     * @param[in] policy   What to do when its queue is full.
+     *
+     * @return Index of the subscriber.
+     */
+    size_t subscribe( Analyser::IFrameObserver& observer,
+                      size_t capacity, Policy policy );
+
+    /**
+     * @brief Obtains number of frames a subscriber got.
+     *
+     * @param[in] index Index of the subscriber.
+     *
+     * @return The number of delivered frames.
+     */
+    uint64 delivered( size_t index ) const;
+    /**
+     * @brief Obtains number of frames a subscriber lost.
+     *
+     * @param[in] index Index of the subscriber.
+     *
+     * @return The number of dropped frames.
+     */
+    uint64 dropped( size_t index ) const;
+    /**
+     * @brief Obtains number of frames waiting for a subscriber.
+     *
+     * @param[in] index Index of the subscriber.
+     *
+     * @return The number of queued frames.
+     */
+    uint64 lag( size_t index ) const;
+
+    /**
+     * @brief Starts the subscriber threads.
+     */
+    void start();
+    /**
+     * @brief Stops the subscriber threads.
+     *
+     * Queued frames are discarded. Rethrows
+     * an error raised by a subscriber, if any.
+     */
+    void stop();
+
+    /**
+     * @brief Publishes a frame to all subscribers.
+     *
+     * @param[in] frame The frame.
+     */
+    void addFrame( const Analyser::Frame& frame );
+
+protected:
+    /**
+     * @brief A queue slot.
+     *
+     * @author Bloody.Rabbit
+     */
+    struct Slot
+    {
+        /// Index of the frame plus one, WRITING while being written.
+        volatile uint64 sequence;
+
+        /// Position of the frame.
+        uint64       position;
+        /// Sample rate of the frame.
+        unsigned int rate;
+        /// When the newest sample was captured [ns].
+        uint64       captured;
+        /// Group delay of the analysis [samples].
+        unsigned int delay;
+
+        /// Number of fundamentals.
+        size_t pitchCount;
+        /// Number of frequencies.
+        size_t peakCount;
+        /// Storage of fundamentals, then frequencies.
+        Analyser::Peak* peaks;
+    };
+
+    /**
+     * @brief A subscriber with its queue.
+     *
+     * @author Bloody.Rabbit
+     */
+    class Subscriber
+    : public util::Thread::IRunnable
+    {
+    public:
+        /**
+         * @brief Allocates the queue.
+         *
+         * @param[in] observer The observer.
+         * @param[in] capacity Length of the queue.
+         * @param[in] policy   What to do when the queue is full.
+         * @param[in] maxPeaks Capacity of each slot.
+         */
+        Subscriber( Analyser::IFrameObserver& observer, size_t capacity,
+                    Policy policy, size_t maxPeaks );
+        /**
+         * @brief Releases the queue.
+         */
+        ~Subscriber();
+
+        /**
+         * @brief Obtains the thread running the subscriber.
+         *
+         * @return The thread.
+         */
+        util::Thread& thread() { return mThread; }
+
+        /**
+         * @brief Obtains number of frames delivered.
+         *
+         * @return The number of frames.
+         */
+        uint64 delivered() const { return mDelivered; }
+        /**
+         * @brief Obtains number of frames dropped.
+         *
+         * @return The number of frames.
+         */
+        uint64 dropped() const { return mDropped; }
+        /**
+         * @brief Obtains number of frames waiting.
+         *
+         * @return The number of frames.
+         */
+        uint64 lag() const { return std::min< uint64 >( mWrite - mRead, mCapacity ); }
+
+        /**
+         * @brief Queues a frame.
+         *
+         * @param[in] frame The frame.
+         * @param[in] count Number of frequencies to keep.
+         */
+        void push( const Analyser::Frame& frame, size_t count );
+        /**
+         * @brief Wakes up both sides.
+         */
+        void wake();
+
+        /**
+         * @brief Delivers the queued frames.
+         *
+         * @param[in] thread The running thread.
+         */
+        void run( util::Thread& thread );
+
+    protected:
+        /**
+         * @brief Copies the next frame out of the queue.
+         *
+         * @retval true  The frame has been copied.
+         * @retval false It has been overwritten meanwhile.
+         */
+        bool pop();
+
+        /// The observer.
+        Analyser::IFrameObserver& mObserver;
+        /// The policy.
+        const Policy              mPolicy;
+
+        /// Length of the queue.
+        const size_t mCapacity;
+        /// Capacity of each slot.
+        const size_t mMaxPeaks;
+        /// The slots.
+        Slot*        mSlots;
+
+        /// Index of the next frame to write, owned by the producer.
+        volatile uint64 mWrite;
+        /// Index of the next frame to read, owned by the consumer.
+        volatile uint64 mRead;
+
+        /// Posted whenever a frame is queued.
+        sem_t mFrames;
+        /// Posted whenever a frame is taken, for POLICY_BLOCK.
+        sem_t mSpace;
+
+        /// The frame being delivered.
+        Analyser::Frame             mFrame;
+        /// Storage of the frame being delivered.
+        std::vector< Analyser::Peak > mPeaks;
+
+        /// Number of frames delivered.
+        volatile uint64 mDelivered;
+        /// Number of frames dropped.
+        volatile uint64 mDropped;
+
+        /// The thread.
+        util::Thread mThread;
+    };
+
+    /// Marks a slot being written.
+    static const uint64 WRITING;
+
+    /// Capacity of the slots.
+    const size_t mMaxPeaks;
+    /// The subscribers.
+    std::vector< Subscriber* > mSubscribers;
+
+    /// Number of frames cut short.
+    uint64 mTruncated;
+};
+
+}} // cgt::core
+
+#endif /* !__CGT__CORE__OBSERVER_BUS_H__INCL__ */
@@ -0,0 +1,45 @@
+/**
+ * @file core/Probes.h
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#ifndef __CGT__CORE__PROBES_H__INCL__
+#define __CGT__CORE__PROBES_H__INCL__
+
+/*
+ * Static probes of the analysis, provider "cgt".
+ *
+ * With CGT_USDT they're SystemTap/DTrace markers, which
+ * perf, bpftrace and friends may attach to; each is a single
+ * nop until they do. Otherwise they compile to nothing.
+ *
+ *   hop__start( position, count )    A captured hop, before the gate.
+ *   hop__end( position, analysed )   The hop is done.
+ *   fft__transform__start( size )
+ *   fft__transform__end()
+ *   fft__freqs__start()
+ *   fft__freqs__end()
+ *   fft__output__start()
+ *   fft__output__end()
+ *   frame( position, pitches, peaks ) A frame goes to the observer.
+ *   xrun( code )                     Samples got lost.
+ *   reset( position )                The buffer is to be refilled.
+ *   relock( position )               Stale state is dropped.
+ */
+#if defined( CGT_USDT ) && defined( HAVE_SYS_SDT_H )
+#   define CGT_PROBE( name )                DTRACE_PROBE( cgt, name )
+#   define CGT_PROBE1( name, a1 )           DTRACE_PROBE1( cgt, name, a1 )
+#   define CGT_PROBE2( name, a1, a2 )       DTRACE_PROBE2( cgt, name, a1, a2 )
+#   define CGT_PROBE3( name, a1, a2, a3 )   DTRACE_PROBE3( cgt, name, a1, a2, a3 )
+#else /* CGT_USDT && HAVE_SYS_SDT_H */
+#   define CGT_PROBE( name )
+#   define CGT_PROBE1( name, a1 )
+#   define CGT_PROBE2( name, a1, a2 )
+#   define CGT_PROBE3( name, a1, a2, a3 )
+#endif /* CGT_USDT && HAVE_SYS_SDT_H */
+
+#endif /* !__CGT__CORE__PROBES_H__INCL__ */
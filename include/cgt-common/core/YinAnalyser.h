@@ -0,0 +1,161 @@
+/**
+ * @file core/YinAnalyser.h
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#ifndef __CGT__CORE__YIN_ANALYSER_H__INCL__
+#define __CGT__CORE__YIN_ANALYSER_H__INCL__
+
+#include "core/Analyser.h"
+
+namespace cgt { namespace core {
+
+/**
+ * @brief A time-domain YIN pitch analyser.
+ *
+ * Detects a single fundamental using the cumulative mean
+ * normalized difference function. The difference function
+ * is obtained from autocorrelation computed by FFT, so it
+ * works well with windows much smaller than FftAnalyser needs.
+ *
+ * @author Bloody.Rabbit
+ */
+class YinAnalyser
+: public Analyser
+{
+public:
+    /// Lowest detectable fundamental [Hz].
+    static const double MIN_FREQ;
+    /// Highest detectable fundamental [Hz].
+    static const double MAX_FREQ;
+
+    /**
+     * @brief Performs basic initialization.
+     *
+     * @param[in] observer  The observer.
+     * @param[in] threshold The absolute threshold of the difference function.
+     * @param[in] magCutoff The magnitude cutoff value.
+     */
+    YinAnalyser( IFrameObserver& observer, double threshold, double magCutoff );
+    /**
+     * @brief Releases acquired resources.
+     */
+    ~YinAnalyser();
+
+    /**
+     * @brief Obtains current absolute threshold.
+     *
+     * @return Current absolute threshold.
+     */
+    double threshold() const { return mThreshold; }
+    /**
+     * @brief Obtains current magnitude cutoff value.
+     *
+     * @return Current magnitude cutoff value.
+     */
+    double magnitudeCutoff() const { return mMagnitudeCutoff; }
+
+    /**
+     * @brief Sets new absolute threshold.
+     *
+     * @param[in] threshold New absolute threshold.
+     */
+    void setThreshold( double threshold ) { mThreshold = threshold; }
+    /**
+     * @brief Sets new magnitude cutoff value.
+     *
+     * @param[in] magCutoff New magnitude cutoff value.
+     */
+    void setMagnitudeCutoff( double magCutoff ) { mMagnitudeCutoff = magCutoff; }
+
+    // Capturing from a PCM ends up here as well.
+    using Analyser::init;
+
+    /**
+     * @brief Initializes the analyser.
+     *
+     * @param[in] rate        The sample rate to use.
+     * @param[in] bufferSize  The size of the sample buffer.
+     * @param[in] captureSize The sample capture size.
+     */
+    void init( unsigned int rate, unsigned int bufferSize,
+               unsigned int captureSize );
+    /**
+     * @brief Frees the analyser resources.
+     */
+    void free();
+
+    /**
+     * @brief Checks whether the fundamentals are reported.
+     *
+     * @retval true Always, the fundamental is all YIN finds.
+     */
+    bool emitsPitches() const { return true; }
+
+protected:
+    /**
+     * @brief Analyses the captured samples.
+     */
+    void analyse();
+
+    /**
+     * @brief Creates an analyser set up like this one.
+     */
+    Analyser* createTwin() const;
+    /**
+     * @brief Swaps the arrays with a twin.
+     */
+    void adopt( Analyser& twin );
+    /**
+     * @brief Obtains the shortest examined lag.
+     *
+     * @return The shortest lag.
+     */
+    size_t minLag() const { return std::max< size_t >( 2, sampleRate() / MAX_FREQ ); }
+    /**
+     * @brief Obtains one past the longest examined lag.
+     *
+     * @return The longest lag.
+     */
+    size_t maxLag() const { return std::min< size_t >( bufferSize() / 2, sampleRate() / MIN_FREQ ) + 1; }
+
+    /**
+     * @brief Computes autocorrelation of the samples.
+     */
+    void processCorrelation();
+    /**
+     * @brief Computes the normalized difference function.
+     */
+    void processDifference();
+    /**
+     * @brief Processes output.
+     */
+    void processOutput();
+
+    /// Our forward FFTW plan, shared.
+    fftw_plan mForward;
+    /// Our backward FFTW plan, shared.
+    fftw_plan mBackward;
+
+    /// The absolute threshold.
+    double mThreshold;
+    /// The magnitude cutoff.
+    double mMagnitudeCutoff;
+
+    /// Zero-padded samples.
+    double* mPadded;
+    /// Spectrum, later autocorrelation of the samples.
+    double* mCorrelation;
+    /// Cumulative energy of the samples.
+    double* mEnergy;
+    /// The normalized difference function.
+    double* mDifference;
+};
+
+}} // cgt::core
+
+#endif /* !__CGT__CORE__YIN_ANALYSER_H__INCL__ */
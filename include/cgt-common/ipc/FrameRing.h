@@ -0,0 +1,228 @@
+/**
+ * @file ipc/FrameRing.h
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#ifndef __CGT__IPC__FRAME_RING_H__INCL__
+#define __CGT__IPC__FRAME_RING_H__INCL__
+
+#include "core/Analyser.h"
+
+namespace cgt { namespace ipc {
+
+/**
+ * @brief A ring of frames shared with other processes.
+ *
+ * The ring lives in a POSIX shared memory object: a header
+ * followed by fixed-size slots, frame i in slot i % capacity.
+ * The writer never waits for the readers. Each slot carries
+ * a sequence number, WRITING while being written, so a reader
+ * detects slots overwritten while it was copying them; the
+ * header keeps the number of frames published.
+ *
+ * All fields are in host byte order, the ring is meant
+ * for processes on the same machine.
+ *
+ * @author Bloody.Rabbit
+ */
+class FrameRing
+: public core::Analyser::IFrameObserver
+{
+public:
+    /**
+     * @brief Creates the ring for writing.
+     *
+     * An object of the same name is replaced only if it's
+     * a ring whose writer is gone; otherwise this fails.
+     *
+     * @param[in] name     Name of the shared memory object, such as "/cgt".
+     * @param[in] capacity Number of slots.
+     * @param[in] maxPeaks Records kept per frame, the highest frequencies are cut.
+     */
+    FrameRing( const char* name, size_t capacity, size_t maxPeaks );
+    /**
+     * @brief Opens an existing ring for reading.
+     *
+     * @param[in] name Name of the shared memory object.
+     */
+    FrameRing( const char* name );
+    /**
+     * @brief Unmaps the ring, removes it if created.
+     */
+    ~FrameRing();
+
+    /**
+     * @brief Obtains number of slots.
+     *
+     * @return The number of slots.
+     */
+    size_t capacity() const { return mHeader->capacity; }
+    /**
+     * @brief Obtains number of records kept per frame.
+     *
+     * @return The number of records.
+     */
+    size_t maxPeaks() const { return mHeader->maxPeaks; }
+    /**
+     * @brief Obtains number of frames published.
+     *
+     * @return The number of frames; the newest one is head() - 1.
+     */
+    uint64 head() const { return mHeader->head; }
+    /**
+     * @brief Obtains number of frames cut short.
+     *
+     * @return The number of truncated frames.
+     */
+    uint64 truncated() const { return mTruncated; }
+
+    /**
+     * @brief Publishes a frame.
+     *
+     * @param[in] frame The frame.
+     */
+    void addFrame( const core::Analyser::Frame& frame );
+    /**
+     * @brief Copies a frame out of the ring.
+     *
+     * The frame stays valid until the next call.
+     *
+     * @param[in]  index Index of the frame.
+     * @param[out] frame Where to store the frame.
+     *
+     * @retval true  The frame has been copied.
+     * @retval false It hasn't been published yet or it's been overwritten.
+     */
+    bool read( uint64 index, core::Analyser::Frame& frame );
+
+protected:
+    /**
+     * @brief Header of the ring.
+     *
+     * Later versions may only append fields, so that
+     * the writer of a ring of any version can be told.
+     *
+     * @author Bloody.Rabbit
+     */
+    struct Header
+    {
+        /// MAGIC, set once the rest is valid.
+        volatile uint32 magic;
+        /// VERSION.
+        uint16 version;
+        /// Unused, zero.
+        uint16 reserved;
+        /// Number of slots.
+        uint32 capacity;
+        /// Records per slot.
+        uint32 maxPeaks;
+        /// Process ID of the writer.
+        int32  writer;
+        /// Unused, zero.
+        uint32 padding;
+        /// Number of frames published.
+        volatile uint64 head;
+    };
+
+    /**
+     * @brief A slot, followed by its records.
+     *
+     * @author Bloody.Rabbit
+     */
+    struct Slot
+    {
+        /// Index of the frame plus one, WRITING while being written.
+        volatile uint64 sequence;
+        /// Position of the frame.
+        uint64 position;
+        /// When the newest sample was captured [ns], monotonic clock.
+        uint64 captured;
+        /// Sample rate of the frame.
+        uint32 rate;
+        /// Number of fundamentals.
+        uint32 pitchCount;
+        /// Number of frequencies.
+        uint32 peakCount;
+        /// Group delay of the analysis [samples].
+        uint32 delay;
+    };
+
+    /**
+     * @brief A fundamental or a frequency.
+     *
+     * @author Bloody.Rabbit
+     */
+    struct Record
+    {
+        /// The frequency [Hz].
+        double freq;
+        /// Magnitude of the frequency.
+        double mag;
+    };
+
+    /**
+     * @brief Maps the object.
+     *
+     * @param[in] fd   The object.
+     * @param[in] size Size to map.
+     * @param[in] prot Protection of the mapping.
+     */
+    void map( int fd, size_t size, int prot );
+    /**
+     * @brief Checks if an object is a ring left by a dead writer.
+     *
+     * @param[in] name Name of the object.
+     *
+     * @retval true  The object is a stale ring.
+     * @retval false It's in use or not a ring at all.
+     */
+    static bool stale( const char* name );
+    /**
+     * @brief Obtains slot of a frame.
+     *
+     * @param[in] index Index of the frame.
+     *
+     * @return The slot.
+     */
+    Slot* slot( uint64 index ) const
+    {
+        return (Slot*)( mData + sizeof( Header ) + ( index % capacity() ) * slotSize( maxPeaks() ) );
+    }
+    /**
+     * @brief Obtains size of a slot with its records.
+     *
+     * @param[in] maxPeaks Records per slot.
+     *
+     * @return The size [bytes].
+     */
+    static size_t slotSize( size_t maxPeaks ) { return sizeof( Slot ) + maxPeaks * sizeof( Record ); }
+
+    /// Identifies the ring.
+    static const uint32 MAGIC;
+    /// Version of the layout.
+    static const uint16 VERSION;
+    /// Marks a slot being written.
+    static const uint64 WRITING;
+
+    /// Name of the object, empty unless we've created it.
+    std::string mName;
+    /// The mapping.
+    uint8*      mData;
+    /// Size of the mapping.
+    size_t      mSize;
+    /// The header.
+    Header*     mHeader;
+
+    /// Storage of the frame being read.
+    std::vector< core::Analyser::Peak > mPeaks;
+    /// Number of frames cut short.
+    uint64 mTruncated;
+};
+
+}} // cgt::ipc
+
+#endif /* !__CGT__IPC__FRAME_RING_H__INCL__ */
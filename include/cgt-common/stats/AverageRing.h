@@ -17,7 +17,8 @@ namespace cgt { namespace stats {
 /**
  * @brief Keeps a running average of last N samples.
  *
- * @todo Could probably be improved by using an actual ring buffer.
+ * The samples are kept in a ring allocated up front,
+ * so adding a sample never allocates.
  *
  * @author Bloody.Rabbit
  */
@@ -40,6 +41,10 @@ public:
      * @param[in] limit The limit of averaged samples.
      */
     AverageRing( unsigned int limit );
+    /**
+     * @brief Releases the ring.
+     */
+    ~AverageRing();
 
     /**
      * @brief Checks if the counter is ready.
@@ -64,9 +69,19 @@ protected:
     const unsigned int mLimit;
 
     /// A sum of last mLimit samples.
-    Result               mSampleSum;
-    /// A queue of last mLimit samples.
-    std::queue< Sample > mLastSamples;
+    Result       mSampleSum;
+    /// A ring of last mLimit samples.
+    Sample*      mLastSamples;
+    /// Number of samples in the ring.
+    unsigned int mCount;
+    /// Where the next sample goes.
+    unsigned int mNext;
+
+private:
+    /// Copying is not allowed.
+    AverageRing( const AverageRing& );
+    /// Copying is not allowed.
+    AverageRing& operator=( const AverageRing& );
 };
 
 // Include the template code.
@@ -1,5 +1,5 @@
 /**
- * @file stats/AverageRing.h
+ * @file stats/AverageRing.inl
  *
  * Console Guitar Tuner (CGT)
  * Copyright (c) 2011 by Bloody.Rabbit
@@ -13,44 +13,58 @@
 template< typename S, typename R >
 AverageRing< S, R >::AverageRing( unsigned int limit )
 : mLimit( limit ),
-  mSampleSum( 0 )
+  mSampleSum( 0 ),
+  mLastSamples( NULL ),
+  mCount( 0 ),
+  mNext( 0 )
 {
+    // Make sure the limit is sane.
+    if( 0 == limit )
+        throw except::InvalidArgument( "Invalid average limit (0)" );
+
+    mLastSamples = new Sample[ mLimit ];
+}
+
+template< typename S, typename R >
+AverageRing< S, R >::~AverageRing()
+{
+    util::safeDeleteArray( mLastSamples );
 }
 
 template< typename S, typename R >
 bool AverageRing< S, R >::ready() const
 {
-    return 0 < mLastSamples.size();
+    return 0 < mCount;
 }
 
 template< typename S, typename R >
 typename AverageRing< S, R >::Result AverageRing< S, R >::result() const
 {
-    return mSampleSum / mLastSamples.size();
+    return mSampleSum / mCount;
 }
 
 template< typename S, typename R >
 void AverageRing< S, R >::add( Sample sample )
 {
-    // Update the sample sum and the sample queue.
+    // If the ring is full, drop oldest sample.
+    if( mLimit == mCount )
+        mSampleSum -= mLastSamples[ mNext ];
+    else
+        ++mCount;
+
+    // Update the sample sum and the sample ring.
     mSampleSum += sample;
-    mLastSamples.push( sample );
-
-    // If the queue has grown over limit, drop oldest sample.
-    if( mLimit < mLastSamples.size() )
-    {
-        mSampleSum -= mLastSamples.front();
-        mLastSamples.pop();
-    }
+    mLastSamples[ mNext ] = sample;
+
+    if( mLimit == ++mNext )
+        mNext = 0;
 }
 
 template< typename S, typename R >
 void AverageRing< S, R >::reset()
 {
-    // Zero the sum.
+    // Zero the sum, empty the ring.
     mSampleSum = 0;
-
-    // Empty the queue.
-    while( 0 < mLastSamples.size() )
-        mLastSamples.pop();
+    mCount     = 0;
+    mNext      = 0;
 }
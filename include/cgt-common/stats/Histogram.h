@@ -0,0 +1,123 @@
+/**
+ * @file stats/Histogram.h
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#ifndef __CGT__STATS__HISTOGRAM_H__INCL__
+#define __CGT__STATS__HISTOGRAM_H__INCL__
+
+namespace cgt { namespace stats {
+
+/**
+ * @brief A log-linear histogram of integer values.
+ *
+ * Each power of two is split into SUB_COUNT equal buckets,
+ * so that any value is known within 1/SUB_COUNT of itself;
+ * values beyond 2^MAX_BITS share the last bucket.
+ *
+ * Meant to have a single writer, which only increments
+ * plain counters; others may read it at any time, taking
+ * a snapshot first, and see it at most a few counts behind.
+ *
+ * @author Bloody.Rabbit
+ */
+class Histogram
+{
+public:
+    /// Number of bits of a value kept exactly.
+    static const unsigned int SUB_BITS     = 4;
+    /// Number of buckets per power of two.
+    static const unsigned int SUB_COUNT    = 1 << SUB_BITS;
+    /// Number of bits of the largest value told apart.
+    static const unsigned int MAX_BITS     = 40;
+    /// Number of buckets.
+    static const unsigned int BUCKET_COUNT = ( MAX_BITS - SUB_BITS + 1 ) * SUB_COUNT;
+
+    /**
+     * @brief Initializes an empty histogram.
+     */
+    Histogram();
+
+    /**
+     * @brief Counts a value.
+     *
+     * @param[in] value The value.
+     */
+    void add( uint64 value );
+    /**
+     * @brief Forgets all values, only for the writer.
+     */
+    void clear();
+
+    /**
+     * @brief Copies the counts.
+     *
+     * @param[out] copy Where to copy them.
+     */
+    void snapshot( Histogram& copy ) const;
+    /**
+     * @brief Leaves only values counted after an earlier snapshot.
+     *
+     * @param[in] earlier The earlier snapshot.
+     */
+    void since( const Histogram& earlier );
+
+    /**
+     * @brief Obtains number of values counted.
+     *
+     * @return The number of values.
+     */
+    uint64 count() const;
+    /**
+     * @brief Obtains a percentile.
+     *
+     * @param[in] percent The percentile, between 0 and 100.
+     *
+     * @return The highest value equivalent to the percentile, 0 if empty.
+     */
+    uint64 percentile( double percent ) const;
+    /**
+     * @brief Obtains the maximal value.
+     *
+     * @return The highest value equivalent to the maximum, 0 if empty.
+     */
+    uint64 max() const;
+
+protected:
+    /**
+     * @brief Obtains the bucket of a value.
+     *
+     * @param[in] value The value.
+     *
+     * @return Index of the bucket.
+     */
+    static unsigned int bucket( uint64 value );
+    /**
+     * @brief Obtains the highest value of a bucket.
+     *
+     * @param[in] bucket Index of the bucket.
+     *
+     * @return The value.
+     */
+    static uint64 highest( unsigned int bucket );
+
+    /// Counts of the buckets.
+    volatile uint64 mCounts[ BUCKET_COUNT ];
+
+private:
+    /// Copying is not allowed, use snapshot().
+    Histogram( const Histogram& );
+    /// Copying is not allowed, use snapshot().
+    Histogram& operator=( const Histogram& );
+};
+
+// Include the inline code.
+#include "stats/Histogram.inl"
+
+}} // cgt::stats
+
+#endif /* !__CGT__STATS__HISTOGRAM_H__INCL__ */
@@ -0,0 +1,33 @@
+/**
+ * @file stats/Histogram.inl
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+/*************************************************************************/
+/* cgt::stats::Histogram                                                 */
+/*************************************************************************/
+inline void Histogram::add( uint64 value )
+{
+    // Only the writer touches it, no need to lock the bus.
+    ++mCounts[ bucket( value ) ];
+}
+
+inline unsigned int Histogram::bucket( uint64 value )
+{
+    // Small values have a bucket each.
+    if( value < SUB_COUNT )
+        return (unsigned int)value;
+
+    // Saturate what's too large.
+    if( ( uint64( 1 ) << MAX_BITS ) <= value )
+        return BUCKET_COUNT - 1;
+
+    // The top bit picks the range, the next SUB_BITS the bucket in it.
+    const unsigned int top = 63 - __builtin_clzll( value );
+    return ( top - SUB_BITS + 1 ) * SUB_COUNT
+        + (unsigned int)( value >> ( top - SUB_BITS ) ) - SUB_COUNT;
+}
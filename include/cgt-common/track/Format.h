@@ -0,0 +1,191 @@
+/**
+ * @file track/Format.h
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#ifndef __CGT__TRACK__FORMAT_H__INCL__
+#define __CGT__TRACK__FORMAT_H__INCL__
+
+namespace cgt {
+/**
+ * @brief Recording of analysis frames.
+ *
+ * @author Bloody.Rabbit
+ */
+namespace track {
+
+/**
+ * @brief Layout of the pitch-track files.
+ *
+ * A track is a sequence of BLOCK_SIZE blocks. The first one
+ * holds the file header (magic, version and sample rate), all
+ * the others hold frames. Every frame block starts with a header
+ * carrying its magic, number of frames, number of bytes used
+ * and absolute position of its first frame, so any block can be
+ * decoded on its own and a position can be found by bisection.
+ *
+ * Each frame is stored as varints of its position delta, pitch
+ * count and peak count, followed by its records. A record is a
+ * zigzag varint of its delta to the previous record of the same
+ * list in tenths of a cent above MIDI note 0, followed by its
+ * magnitude in hundredths of dB as int16. Frames never span blocks.
+ * All fixed-width values are little-endian.
+ *
+ * An index may accompany the track. After a 16-byte header
+ * (magic, version, number of notes and sample rate) it has one
+ * INDEX_ENTRY_SIZE entry per frame block: positions of the first
+ * and the last frame, followed by the lowest and the highest
+ * deviation of each MIDI note in the block in whole cents, as int8.
+ * Notes absent from the block have the lowest deviation above the
+ * highest one. Entries have fixed size, so the index is used mapped
+ * in memory, as is.
+ *
+ * @author Bloody.Rabbit
+ */
+class Format
+{
+public:
+    /// Size of every block.
+    static const size_t BLOCK_SIZE        = 4096;
+    /// Size of the frame block header.
+    static const size_t BLOCK_HEADER_SIZE = 16;
+    /// The largest record.
+    static const size_t MAX_RECORD_SIZE   = 7;
+    /// The largest frame header.
+    static const size_t MAX_FRAME_SIZE    = 30;
+
+    /// Number of notes summarized by the index.
+    static const size_t NOTE_COUNT        = 128;
+    /// Size of the index header.
+    static const size_t INDEX_HEADER_SIZE = 16;
+    /// Size of each index entry.
+    static const size_t INDEX_ENTRY_SIZE  = 16 + 2 * NOTE_COUNT;
+
+    /// Magic of the file header ("CGTT").
+    static const uint32 FILE_MAGIC;
+    /// Magic of each frame block ("CGTB").
+    static const uint32 BLOCK_MAGIC;
+    /// Magic of the index header ("CGTI").
+    static const uint32 INDEX_MAGIC;
+    /// Version of the format.
+    static const uint16 VERSION;
+
+    /// Quantization steps per cent.
+    static const double CENTS_SCALE;
+    /// Quantization steps per dB.
+    static const double DB_SCALE;
+
+    /**
+     * @brief Quantizes a frequency.
+     *
+     * @param[in] freq The frequency [Hz].
+     *
+     * @return The quantized pitch.
+     */
+    static int32 encodeFreq( double freq );
+    /**
+     * @brief Restores a quantized frequency.
+     *
+     * @param[in] pitch The quantized pitch.
+     *
+     * @return The frequency [Hz].
+     */
+    static double decodeFreq( int32 pitch );
+    /**
+     * @brief Obtains the nearest MIDI note of a quantized pitch.
+     *
+     * @param[in] pitch The quantized pitch.
+     *
+     * @return The note.
+     */
+    static int32 noteOf( int32 pitch );
+    /**
+     * @brief Obtains deviation of a quantized pitch from its nearest note.
+     *
+     * @param[in] pitch The quantized pitch.
+     *
+     * @return The deviation, from -50 to 50 [cents].
+     */
+    static double deviationOf( int32 pitch );
+    /**
+     * @brief Quantizes a magnitude.
+     *
+     * @param[in] mag The magnitude.
+     *
+     * @return The quantized magnitude.
+     */
+    static int16 encodeMag( double mag );
+    /**
+     * @brief Restores a quantized magnitude.
+     *
+     * @param[in] level The quantized magnitude.
+     *
+     * @return The magnitude.
+     */
+    static double decodeMag( int16 level );
+
+    /**
+     * @brief Stores a little-endian value.
+     *
+     * @param[out] buf   Where to store the value.
+     * @param[in]  value The value.
+     * @param[in]  size  Number of bytes.
+     *
+     * @return Pointer past the stored value.
+     */
+    static uint8* putFixed( uint8* buf, uint64 value, size_t size );
+    /**
+     * @brief Loads a little-endian value.
+     *
+     * @param[in] buf  Where to load the value from.
+     * @param[in] size Number of bytes.
+     *
+     * @return The value.
+     */
+    static uint64 getFixed( const uint8* buf, size_t size );
+
+    /**
+     * @brief Stores a varint.
+     *
+     * @param[out] buf   Where to store the value, at least 10 bytes.
+     * @param[in]  value The value.
+     *
+     * @return Pointer past the stored value.
+     */
+    static uint8* putVarint( uint8* buf, uint64 value );
+    /**
+     * @brief Loads a varint.
+     *
+     * @param[in]  buf   Where to load the value from.
+     * @param[in]  end   End of the buffer.
+     * @param[out] value The value.
+     *
+     * @return Pointer past the loaded value, NULL if truncated.
+     */
+    static const uint8* getVarint( const uint8* buf, const uint8* end, uint64& value );
+
+    /**
+     * @brief Maps a signed value to an unsigned one.
+     *
+     * @param[in] value The signed value.
+     *
+     * @return The unsigned value, small for small magnitudes.
+     */
+    static uint64 zigzag( int64 value ) { return ( uint64( value ) << 1 ) ^ uint64( value >> 63 ); }
+    /**
+     * @brief Inverse of zigzag().
+     *
+     * @param[in] value The unsigned value.
+     *
+     * @return The signed value.
+     */
+    static int64 unzigzag( uint64 value ) { return int64( value >> 1 ) ^ -int64( value & 1 ); }
+};
+
+}} // cgt::track
+
+#endif /* !__CGT__TRACK__FORMAT_H__INCL__ */
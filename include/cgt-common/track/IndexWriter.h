@@ -0,0 +1,92 @@
+/**
+ * @file track/IndexWriter.h
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#ifndef __CGT__TRACK__INDEX_WRITER_H__INCL__
+#define __CGT__TRACK__INDEX_WRITER_H__INCL__
+
+#include "core/Analyser.h"
+#include "track/Format.h"
+
+namespace cgt { namespace track {
+
+/**
+ * @brief Summarizes blocks of a track into an index.
+ *
+ * Frames are added as they go into a block; the
+ * summary is appended once the block is complete.
+ *
+ * @author Bloody.Rabbit
+ */
+class IndexWriter
+{
+public:
+    /**
+     * @brief Creates the index file.
+     *
+     * @param[in] path Path of the file.
+     */
+    IndexWriter( const char* path );
+    /**
+     * @brief Closes the file.
+     */
+    ~IndexWriter();
+
+    /**
+     * @brief Adds a frame to the current block.
+     *
+     * @param[in] frame The frame.
+     */
+    void add( const core::Analyser::Frame& frame );
+    /**
+     * @brief Appends summary of the current block.
+     */
+    void endBlock();
+    /**
+     * @brief Closes the file.
+     */
+    void close();
+
+protected:
+    /**
+     * @brief Adds a list of records to the current summary.
+     *
+     * @param[in] peaks The records.
+     * @param[in] count Number of the records.
+     */
+    void addRecords( const core::Analyser::Peak* peaks, size_t count );
+    /**
+     * @brief Empties the current summary.
+     */
+    void clear();
+    /**
+     * @brief Writes data to the file.
+     *
+     * @param[in] data The data.
+     * @param[in] size Size of the data.
+     */
+    void write( const uint8* data, size_t size );
+
+    /// The file.
+    FILE* mFile;
+    /// Sample rate of the track, 0 until the first frame.
+    unsigned int mRate;
+
+    /// Number of frames in the current block.
+    size_t mFrames;
+    /// Positions of the first and the last frame.
+    uint64 mFirst, mLast;
+    /// Lowest deviation of each note.
+    int8   mLow[ Format::NOTE_COUNT ];
+    /// Highest deviation of each note.
+    int8   mHigh[ Format::NOTE_COUNT ];
+};
+
+}} // cgt::track
+
+#endif /* !__CGT__TRACK__INDEX_WRITER_H__INCL__ */
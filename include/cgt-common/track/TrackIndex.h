@@ -0,0 +1,117 @@
+/**
+ * @file track/TrackIndex.h
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#ifndef __CGT__TRACK__TRACK_INDEX_H__INCL__
+#define __CGT__TRACK__TRACK_INDEX_H__INCL__
+
+#include "track/Format.h"
+
+namespace cgt { namespace track {
+
+/**
+ * @brief An index of a track, mapped in memory.
+ *
+ * Entry i summarizes frame block i of the track. Only
+ * the pages of the entries actually examined are read
+ * from the disk.
+ *
+ * @author Bloody.Rabbit
+ */
+class TrackIndex
+{
+public:
+    /**
+     * @brief Maps the index file.
+     *
+     * @param[in] path Path of the file.
+     */
+    TrackIndex( const char* path );
+    /**
+     * @brief Unmaps the file.
+     */
+    ~TrackIndex();
+
+    /**
+     * @brief Obtains sample rate of the track.
+     *
+     * @return The sample rate.
+     */
+    unsigned int rate() const { return mRate; }
+    /**
+     * @brief Obtains number of entries.
+     *
+     * @return The number of entries.
+     */
+    uint64 entryCount() const { return mEntryCount; }
+
+    /**
+     * @brief Obtains position of the first frame of a block.
+     *
+     * @param[in] index Index of the entry.
+     *
+     * @return The position.
+     */
+    uint64 firstPosition( uint64 index ) const { return Format::getFixed( entry( index ), 8 ); }
+    /**
+     * @brief Obtains position of the last frame of a block.
+     *
+     * @param[in] index Index of the entry.
+     *
+     * @return The position.
+     */
+    uint64 lastPosition( uint64 index ) const { return Format::getFixed( entry( index ) + 8, 8 ); }
+
+    /**
+     * @brief Checks if a block may have a note within a deviation range.
+     *
+     * @param[in] index Index of the entry.
+     * @param[in] note  The MIDI note.
+     * @param[in] low   The lowest deviation [cents].
+     * @param[in] high  The highest deviation [cents].
+     *
+     * @retval true  The block may have such records.
+     * @retval false The block has no such records.
+     */
+    bool contains( uint64 index, size_t note, double low, double high ) const;
+    /**
+     * @brief Finds the first block which ends at a position or later.
+     *
+     * @param[in] position The position.
+     *
+     * @return Index of the entry, entryCount() if none.
+     */
+    uint64 find( uint64 position ) const;
+
+protected:
+    /**
+     * @brief Obtains an entry.
+     *
+     * @param[in] index Index of the entry.
+     *
+     * @return The entry.
+     */
+    const uint8* entry( uint64 index ) const
+    {
+        return mData + Format::INDEX_HEADER_SIZE + index * Format::INDEX_ENTRY_SIZE;
+    }
+
+    /// The mapped file.
+    const uint8* mData;
+    /// Size of the mapping.
+    size_t       mSize;
+
+    /// Sample rate of the track.
+    unsigned int mRate;
+    /// Number of entries.
+    uint64       mEntryCount;
+};
+
+}} // cgt::track
+
+#endif /* !__CGT__TRACK__TRACK_INDEX_H__INCL__ */
@@ -0,0 +1,157 @@
+/**
+ * @file track/TrackReader.h
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#ifndef __CGT__TRACK__TRACK_READER_H__INCL__
+#define __CGT__TRACK__TRACK_READER_H__INCL__
+
+#include "core/Analyser.h"
+#include "track/Format.h"
+
+namespace cgt { namespace track {
+
+/**
+ * @brief Reads frames back from a pitch-track file.
+ *
+ * Only a single block is held in memory. Frames come
+ * back as analysis frames, so any frame observer can
+ * replay them; bins are 0 and confidences are 1.
+ *
+ * @author Bloody.Rabbit
+ */
+class TrackReader
+{
+public:
+    /**
+     * @brief Opens the track file.
+     *
+     * @param[in] path Path of the file.
+     */
+    TrackReader( const char* path );
+    /**
+     * @brief Closes the file.
+     */
+    ~TrackReader();
+
+    /**
+     * @brief Obtains sample rate of the track.
+     *
+     * @return The sample rate.
+     */
+    unsigned int rate() const { return mRate; }
+    /**
+     * @brief Obtains number of frame blocks.
+     *
+     * @return The number of blocks.
+     */
+    uint64 blockCount() const { return mBlockCount; }
+    /**
+     * @brief Obtains index of the current block.
+     *
+     * @return The index of the block.
+     */
+    uint64 block() const { return mBlockIndex; }
+    /**
+     * @brief Obtains number of frames left in the current block.
+     *
+     * @return The number of frames.
+     */
+    size_t framesLeft() const { return mFramesLeft + mPending; }
+
+    /**
+     * @brief Reads the next frame.
+     *
+     * @param[out] frame The frame, valid until the next call.
+     *
+     * @retval true  The frame has been read.
+     * @retval false There are no more frames.
+     */
+    bool next( core::Analyser::Frame& frame );
+    /**
+     * @brief Moves to the first frame at a position or later.
+     *
+     * @param[in] position The position [samples].
+     */
+    void seek( uint64 position );
+    /**
+     * @brief Moves to the first frame of a block.
+     *
+     * @param[in] index Index of the block.
+     */
+    void seekBlock( uint64 index );
+
+protected:
+    /**
+     * @brief Reads a block of the file.
+     *
+     * @param[in]  index Index of the block, 0 being the file header.
+     * @param[out] block Where to store the block.
+     */
+    void readBlock( uint64 index, uint8* block );
+    /**
+     * @brief Reads position of the first frame of a block.
+     *
+     * @param[in] index Index of the block.
+     *
+     * @return The position.
+     */
+    uint64 blockPosition( uint64 index );
+    /**
+     * @brief Loads a block for decoding.
+     *
+     * @param[in] index Index of the block.
+     */
+    void loadBlock( uint64 index );
+    /**
+     * @brief Decodes the next frame of the current block.
+     *
+     * @param[out] frame The frame.
+     */
+    void decode( core::Analyser::Frame& frame );
+    /**
+     * @brief Decodes a list of records.
+     *
+     * @param[in]  count Number of the records.
+     * @param[out] peaks Where to store the records.
+     */
+    void getRecords( size_t count, std::vector< core::Analyser::Peak >& peaks );
+
+    /// The file.
+    FILE* mFile;
+    /// Sample rate of the track.
+    unsigned int mRate;
+    /// Number of frame blocks.
+    uint64 mBlockCount;
+
+    /// The current block.
+    uint8        mBlock[ Format::BLOCK_SIZE ];
+    /// Index of the current block.
+    uint64       mBlockIndex;
+    /// The next frame in the current block.
+    const uint8* mCursor;
+    /// End of the used part of the current block.
+    const uint8* mEnd;
+    /// Frames left in the current block.
+    size_t       mFramesLeft;
+    /// Position of the last frame.
+    uint64       mPosition;
+
+    /// Whether a frame has been decoded ahead by seek().
+    bool mPending;
+    /// The frame decoded ahead.
+    core::Analyser::Frame mFrame;
+
+    /// Fundamentals of the last frame.
+    std::vector< core::Analyser::Peak > mPitches;
+    /// Frequencies of the last frame.
+    std::vector< core::Analyser::Peak > mPeaks;
+};
+
+}} // cgt::track
+
+#endif /* !__CGT__TRACK__TRACK_READER_H__INCL__ */
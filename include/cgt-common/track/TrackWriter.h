@@ -0,0 +1,124 @@
+/**
+ * @file track/TrackWriter.h
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#ifndef __CGT__TRACK__TRACK_WRITER_H__INCL__
+#define __CGT__TRACK__TRACK_WRITER_H__INCL__
+
+#include "core/Analyser.h"
+#include "track/IndexWriter.h"
+
+namespace cgt { namespace track {
+
+/**
+ * @brief Records frames into a pitch-track file.
+ *
+ * Frames are encoded into an in-memory block, which
+ * is appended to the file once full, so the cost per
+ * frame is a few varints and one write per block.
+ * If requested, the index is written alongside.
+ *
+ * @author Bloody.Rabbit
+ */
+class TrackWriter
+: public core::Analyser::IFrameObserver
+{
+public:
+    /**
+     * @brief Creates the track file.
+     *
+     * @param[in] path      Path of the file.
+     * @param[in] indexPath Path of the index, NULL if none.
+     */
+    TrackWriter( const char* path, const char* indexPath = NULL );
+    /**
+     * @brief Writes the pending frames and closes the file.
+     */
+    ~TrackWriter();
+
+    /**
+     * @brief Obtains number of frames recorded.
+     *
+     * @return The number of frames.
+     */
+    uint64 frames() const { return mFrames; }
+    /**
+     * @brief Obtains number of records cut to fit a block.
+     *
+     * @return The number of records.
+     */
+    uint64 truncated() const { return mTruncated; }
+
+    /**
+     * @brief Records a frame.
+     *
+     * @param[in] frame The frame.
+     */
+    void addFrame( const core::Analyser::Frame& frame );
+
+    /**
+     * @brief Writes the pending frames.
+     *
+     * The current block is written padded,
+     * following frames start a new one.
+     */
+    void flush();
+    /**
+     * @brief Writes the pending frames and closes the file.
+     */
+    void close();
+
+protected:
+    /**
+     * @brief Writes the file header.
+     *
+     * @param[in] rate The sample rate.
+     */
+    void writeHeader( unsigned int rate );
+    /**
+     * @brief Appends a block to the file.
+     *
+     * @param[in] block The block.
+     */
+    void writeBlock( const uint8* block );
+    /**
+     * @brief Encodes a list of records.
+     *
+     * @param[out] buf   Where to store the records.
+     * @param[in]  peaks The records.
+     * @param[in]  count Number of the records.
+     *
+     * @return Pointer past the stored records.
+     */
+    static uint8* putRecords( uint8* buf, const core::Analyser::Peak* peaks, size_t count );
+
+    /// The file.
+    FILE*        mFile;
+    /// The index, NULL if none.
+    IndexWriter* mIndex;
+    /// Sample rate of the track, 0 until the first frame.
+    unsigned int mRate;
+
+    /// The current block.
+    uint8  mBlock[ Format::BLOCK_SIZE ];
+    /// Bytes used in the current block.
+    size_t mUsed;
+    /// Frames in the current block.
+    size_t mBlockFrames;
+    /// Position of the last frame.
+    uint64 mPosition;
+
+    /// Number of frames recorded.
+    uint64 mFrames;
+    /// Number of records cut.
+    uint64 mTruncated;
+};
+
+}} // cgt::track
+
+#endif /* !__CGT__TRACK__TRACK_WRITER_H__INCL__ */
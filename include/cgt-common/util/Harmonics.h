@@ -15,6 +15,10 @@ namespace cgt { namespace util {
 /**
  * @brief A helper class for analyzing harmonics.
  *
+ * Fundamentals are kept sorted by frequency, so a frequency
+ * is classified by looking up only the fundamentals which
+ * lie within tolerance of one of its integer ratios.
+ *
  * @author Bloody.Rabbit
  */
 class Harmonics
@@ -36,11 +40,15 @@ public:
      *
      * @param[in] tol The new value.
      */
-    void setTolerance( double tol ) { mTolerance = tol; }
+    void setTolerance( double tol );
 
     /**
      * @brief Obtains harmonic index of a frequency.
      *
+     * If there are several candidates, the lowest
+     * fundamental wins. If there are none, the frequency
+     * becomes a new fundamental.
+     *
      * @param[in] freq The frequency.
      *
      * @return The harmonic index.
@@ -52,10 +60,31 @@ public:
     void clear();
 
 protected:
-    /// A vector of fundamentals.
+    /**
+     * @brief Searches for a fundamental using binary search.
+     *
+     * @param[in] freq  The frequency.
+     * @param[in] first The lowest harmonic ratio to try.
+     * @param[in] last  The highest harmonic ratio to try.
+     *
+     * @return The harmonic index, -1 if none matches.
+     */
+    int search( double freq, int first, int last ) const;
+    /**
+     * @brief Searches for a fundamental using linear scan.
+     *
+     * @param[in] freq The frequency.
+     *
+     * @return The harmonic index, -1 if none matches.
+     */
+    int scan( double freq ) const;
+
+    /// A vector of fundamentals, sorted by frequency.
     std::vector< double > mFundamentals;
-    /// A harmonic tolerance.
+    /// A harmonic tolerance [dB].
     double mTolerance;
+    /// The harmonic tolerance as a plain ratio error.
+    double mSpread;
 };
 
 }} // cgt::util
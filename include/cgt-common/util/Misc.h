@@ -25,6 +25,13 @@ namespace cgt { namespace util {
  */
 double normalize( double value, double period );
 
+/**
+ * @brief Obtains the monotonic time.
+ *
+ * @return The time [ns].
+ */
+uint64 monotonicTime();
+
 }} // cgt::util
 
 #endif /* !__CGT__UTIL__MISC_H__INCL__ */
@@ -0,0 +1,126 @@
+/**
+ * @file util/Thread.h
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#ifndef __CGT__UTIL__THREAD_H__INCL__
+#define __CGT__UTIL__THREAD_H__INCL__
+
+namespace cgt { namespace util {
+
+/**
+ * @brief A thin wrapper around a POSIX thread.
+ *
+ * An exception escaping the runnable terminates
+ * the thread; it's rethrown by stop().
+ *
+ * @author Bloody.Rabbit
+ */
+class Thread
+{
+public:
+    /**
+     * @brief Code to be run by a thread.
+     *
+     * @author Bloody.Rabbit
+     */
+    class IRunnable
+    {
+    public:
+        /**
+         * @brief Runs the code.
+         *
+         * Should return as soon as possible
+         * once stop has been requested.
+         *
+         * @param[in] thread The thread running the code.
+         */
+        virtual void run( Thread& thread ) = 0;
+    };
+
+    /**
+     * @brief Binds the runnable.
+     *
+     * @param[in] runnable The runnable.
+     */
+    Thread( IRunnable& runnable );
+    /**
+     * @brief Stops the thread, ignoring any errors.
+     */
+    ~Thread();
+
+    /**
+     * @brief Checks if the runnable is still running.
+     *
+     * @retval true  The runnable is running.
+     * @retval false The runnable has returned or hasn't been started.
+     */
+    bool running() const { return mRunning; }
+    /**
+     * @brief Checks if stop has been requested.
+     *
+     * @retval true  Stop has been requested.
+     * @retval false Stop hasn't been requested.
+     */
+    bool stopRequested() const { return mStopRequested; }
+
+    /**
+     * @brief Starts the thread.
+     */
+    void start();
+    /**
+     * @brief Requests stop, but doesn't wait.
+     *
+     * Useful to wake up a blocked runnable
+     * before waiting for it.
+     */
+    void requestStop() { mStopRequested = true; }
+    /**
+     * @brief Requests stop and waits for the thread.
+     *
+     * Rethrows an error raised by the runnable, if any.
+     */
+    void stop();
+
+protected:
+    /**
+     * @brief The thread entry point.
+     *
+     * @param[in] arg The thread.
+     *
+     * @return Always NULL.
+     */
+    static void* routine( void* arg );
+
+    /// The bound runnable.
+    IRunnable& mRunnable;
+
+    /// The thread.
+    pthread_t mThread;
+    /// True if the thread has been started and not joined yet.
+    bool      mStarted;
+
+    /// True while the runnable runs.
+    volatile bool mRunning;
+    /// True if stop has been requested.
+    volatile bool mStopRequested;
+
+    /// True if the runnable raised an error.
+    bool        mFailed;
+    /// Description of the error.
+    std::string mError;
+
+private:
+    /// Not copyable.
+    Thread( const Thread& );
+    /// Not copyable.
+    Thread& operator=( const Thread& );
+};
+
+}} // cgt::util
+
+#endif /* !__CGT__UTIL__THREAD_H__INCL__ */
@@ -56,17 +56,19 @@ public:
     /**
      * @brief Creates a tone based on its frequency.
      *
-     * @param[in] freq The frequency of the tone.
+     * @param[in] freq   The frequency of the tone.
+     * @param[in] a4Freq The reference frequency of note A4.
      */
-    Tone( double freq );
+    Tone( double freq, double a4Freq = A4_FREQ );
     /**
      * @brief Creates a tone based on its musical properties.
      *
      * @param[in] note   Base note of the tone.
      * @param[in] cents  Musical cents of the tone.
      * @param[in] octave Octave of the tone.
+     * @param[in] a4Freq The reference frequency of note A4.
      */
-    Tone( Note note, double cents, int octave );
+    Tone( Note note, double cents, int octave, double a4Freq = A4_FREQ );
 
     /**
      * @brief Obtains frequency of the tone.
@@ -103,6 +105,14 @@ public:
     void getName( char* name, size_t len ) const;
 
 protected:
+    /// ToneTable fills in the members directly.
+    friend class ToneTable;
+
+    /**
+     * @brief Creates an uninitialized tone.
+     */
+    Tone() {}
+
     // Frequency of the tone.
     double mFrequency;
 
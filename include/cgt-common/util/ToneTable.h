@@ -0,0 +1,94 @@
+/**
+ * @file util/ToneTable.h
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#ifndef __CGT__UTIL__TONE_TABLE_H__INCL__
+#define __CGT__UTIL__TONE_TABLE_H__INCL__
+
+#include "util/Tone.h"
+
+namespace cgt { namespace util {
+
+/**
+ * @brief A precomputed frequency-to-tone mapping.
+ *
+ * Logarithm of the frequency is looked up in a table indexed
+ * by the upper mantissa bits and linearly interpolated, so
+ * no math library calls are needed per tone. Names of all
+ * notes within the usual octave range are cached as well.
+ *
+ * @author Bloody.Rabbit
+ */
+class ToneTable
+{
+public:
+    /// Number of table entries per octave.
+    static const size_t LOG_TABLE_SIZE;
+
+    /// Lowest octave with cached names.
+    static const int MIN_OCTAVE;
+    /// Highest octave with cached names.
+    static const int MAX_OCTAVE;
+
+    /**
+     * @brief Precomputes the table.
+     *
+     * @param[in] a4Freq The reference frequency of note A4.
+     */
+    ToneTable( double a4Freq = Tone::A4_FREQ );
+
+    /**
+     * @brief Obtains the reference frequency.
+     *
+     * @return The reference frequency of note A4.
+     */
+    double reference() const { return mReference; }
+
+    /**
+     * @brief Creates a tone based on its frequency.
+     *
+     * @param[in] freq The frequency of the tone.
+     *
+     * @return The tone.
+     */
+    Tone get( double freq ) const;
+    /**
+     * @brief Obtains name of a tone.
+     *
+     * Produces the same output as Tone::getName().
+     *
+     * @param[in]  tone The tone.
+     * @param[out] name The name buffer.
+     * @param[out] len  Length of the name buffer.
+     */
+    void getName( const Tone& tone, char* name, size_t len ) const;
+
+protected:
+    /**
+     * @brief Computes binary logarithm using the table.
+     *
+     * @param[in] x A positive number.
+     *
+     * @return Binary logarithm of the number.
+     */
+    double log2( double x ) const;
+
+    /// The reference frequency.
+    double mReference;
+    /// Note index of 1 Hz.
+    double mOffset;
+
+    /// Binary logarithm of the mantissa, one extra entry for interpolation.
+    std::vector< double >      mLog2;
+    /// Cached name prefixes, indexed by octave and note.
+    std::vector< std::string > mNames;
+};
+
+}} // cgt::util
+
+#endif /* !__CGT__UTIL__TONE_TABLE_H__INCL__ */
@@ -0,0 +1,238 @@
+/**
+ * @file util/Tracer.h
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#ifndef __CGT__UTIL__TRACER_H__INCL__
+#define __CGT__UTIL__TRACER_H__INCL__
+
+#include "config/Settings.h"
+
+namespace cgt { namespace util {
+
+/**
+ * @brief Records a timeline of events, saved as a Chrome trace.
+ *
+ * Each thread records begin and end events into a ring of its
+ * own, allocated on its first event; once it has one, recording
+ * takes no locks and overwrites the oldest events when full.
+ *
+ * The rings are saved either as a snapshot, replacing the file
+ * each time, or as a stream, appending whatever's new. Streamed
+ * files use the array format of the trace, which may be left
+ * unterminated.
+ *
+ * Does nothing until started.
+ *
+ * @author Bloody.Rabbit
+ */
+class Tracer
+{
+public:
+    /**
+     * @brief Records the rest of a scope.
+     *
+     * @author Bloody.Rabbit
+     */
+    class Scope
+    {
+    public:
+        /**
+         * @brief Records the beginning.
+         *
+         * @param[in] name Name of the scope, must be a literal.
+         */
+        Scope( const char* name );
+        /**
+         * @brief Records the end.
+         */
+        ~Scope();
+
+    protected:
+        /// Name of the scope.
+        const char* mName;
+    };
+
+    /**
+     * @brief Obtains the process-wide instance.
+     *
+     * @return The instance.
+     */
+    static Tracer& get();
+    /**
+     * @brief Saves the stream and frees the rings.
+     */
+    ~Tracer();
+
+    /**
+     * @brief Checks if the tracer records.
+     *
+     * @retval true  It records.
+     * @retval false It doesn't.
+     */
+    bool enabled() const { return mEnabled; }
+    /**
+     * @brief Checks if the events are streamed.
+     *
+     * @retval true  They're streamed, save them regularly.
+     * @retval false Each save takes a snapshot.
+     */
+    bool streaming() const { return NULL != mStream; }
+
+    /**
+     * @brief Starts recording.
+     *
+     * @param[in] path     Path of the file to save to.
+     * @param[in] ringSize Number of events kept per thread.
+     * @param[in] stream   Whether to stream rather than snapshot.
+     */
+    void start( const char* path, size_t ringSize, bool stream );
+    /**
+     * @brief Starts recording as configured.
+     *
+     * Does nothing unless "cgt.trace.path" is set; throws if it
+     * is, but the build can't trace.
+     *
+     * @param[in] settings The settings to follow.
+     */
+    void startFromSettings( const config::Settings& settings );
+    /**
+     * @brief Saves the events.
+     *
+     * Not to be called by several threads at once.
+     */
+    void save();
+
+    /**
+     * @brief Records an event of the calling thread.
+     *
+     * @param[in] phase 'B' for a beginning, 'E' for an end.
+     * @param[in] name  Name of the event, must be a literal.
+     * @param[in] time  Time of the event [ns].
+     */
+    void record( char phase, const char* name, uint64 time );
+    /**
+     * @brief Names the calling thread in the trace.
+     *
+     * Also allocates its ring if recording, so that
+     * the thread's first event doesn't have to.
+     *
+     * @param[in] name The name, must be a literal.
+     */
+    void nameThread( const char* name );
+
+protected:
+    /**
+     * @brief A recorded event.
+     *
+     * @author Bloody.Rabbit
+     */
+    struct Event
+    {
+        /// Time of the event [ns].
+        uint64      time;
+        /// Name of the event.
+        const char* name;
+        /// 'B' or 'E'.
+        char        phase;
+    };
+
+    /**
+     * @brief Events of a thread.
+     *
+     * @author Bloody.Rabbit
+     */
+    struct Ring
+    {
+        /// Name of the thread.
+        const char*     name;
+        /// Whether the name has been streamed.
+        bool            announced;
+        /// Id of the thread in the trace.
+        unsigned int    id;
+        /// The events.
+        Event*          events;
+        /// Number of events ever recorded.
+        volatile uint64 head;
+        /// Number of events streamed so far.
+        uint64          saved;
+    };
+
+    /**
+     * @brief Initializes a stopped tracer.
+     */
+    Tracer();
+    /**
+     * @brief Creates the instance.
+     */
+    static void create();
+
+    /**
+     * @brief Allocates a ring for the calling thread.
+     *
+     * @return The ring.
+     */
+    Ring* attach();
+    /**
+     * @brief Writes events of a ring.
+     *
+     * @param[in] file  The file to write to.
+     * @param[in] ring  The ring.
+     * @param[in] start Index of the first event wanted.
+     *
+     * @return Index past the last event written.
+     */
+    uint64 write( FILE* file, const Ring& ring, uint64 start );
+
+    /// Guards the rings, not taken when recording.
+    pthread_mutex_t       mMutex;
+    /// The rings.
+    std::vector< Ring* >  mRings;
+    /// Scratch copy of a ring being written.
+    std::vector< Event >  mScratch;
+    /// Number of events kept per thread.
+    size_t                mRingSize;
+    /// Whether it records.
+    volatile bool         mEnabled;
+
+    /// Path of the file.
+    std::string mPath;
+    /// The stream, if streaming.
+    FILE*       mStream;
+
+    /// Ring of the calling thread.
+    static __thread Ring*       mThreadRing;
+    /// Name of the calling thread.
+    static __thread const char* mThreadName;
+
+    /// The instance.
+    static std::auto_ptr< Tracer > mInstance;
+    /// Makes sure it's created once.
+    static pthread_once_t          mInstanceOnce;
+
+private:
+    /// Copying is not allowed.
+    Tracer( const Tracer& );
+    /// Copying is not allowed.
+    Tracer& operator=( const Tracer& );
+};
+
+}} // cgt::util
+
+/// Shortcut to the tracer.
+#define sTracer util::Tracer::get()
+
+#ifdef CGT_PROFILE
+/// Records the rest of the scope in the trace.
+#   define CGT_TRACE_SCOPE( name ) \
+        const util::Tracer::Scope traceScope( name )
+#else /* CGT_PROFILE */
+/// Tracing is compiled out.
+#   define CGT_TRACE_SCOPE( name )
+#endif /* CGT_PROFILE */
+
+#endif /* !__CGT__UTIL__TRACER_H__INCL__ */
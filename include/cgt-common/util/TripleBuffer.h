@@ -0,0 +1,94 @@
+/**
+ * @file util/TripleBuffer.h
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#ifndef __CGT__UTIL__TRIPLE_BUFFER_H__INCL__
+#define __CGT__UTIL__TRIPLE_BUFFER_H__INCL__
+
+namespace cgt { namespace util {
+
+/**
+ * @brief A lock-free latest-value snapshot.
+ *
+ * A single writer fills the back buffer and publishes it,
+ * a single reader picks up the most recently published
+ * one. Neither side ever waits for the other; snapshots
+ * the reader doesn't pick up in time are overwritten.
+ *
+ * @author Bloody.Rabbit
+ */
+template< typename T >
+class TripleBuffer
+{
+public:
+    /**
+     * @brief Initializes the buffers.
+     *
+     * @param[in] value Initial value of all buffers.
+     */
+    TripleBuffer( const T& value = T() );
+
+    /**
+     * @brief Obtains the back buffer.
+     *
+     * Only to be used by the writer.
+     *
+     * @return The back buffer.
+     */
+    T& back() { return mBuffers[ mBack ]; }
+    /**
+     * @brief Publishes the back buffer.
+     *
+     * The writer gets a new back buffer, its
+     * content is left over from an older snapshot.
+     */
+    void publish();
+
+    /**
+     * @brief Obtains the front buffer.
+     *
+     * Only to be used by the reader.
+     *
+     * @return The front buffer.
+     */
+    const T& front() const { return mBuffers[ mFront ]; }
+    /**
+     * @brief Picks up the latest snapshot, if any.
+     *
+     * @retval true  The front buffer has been updated.
+     * @retval false Nothing new has been published.
+     */
+    bool update();
+
+protected:
+    /// Set in mMiddle if it holds an unread snapshot.
+    static const int FRESH = 0x4;
+
+    /// The buffers.
+    T mBuffers[ 3 ];
+
+    /// Index of the buffer owned by the writer.
+    int          mBack;
+    /// Index of the buffer in between, plus the fresh flag.
+    volatile int mMiddle;
+    /// Index of the buffer owned by the reader.
+    int          mFront;
+
+private:
+    /// Not copyable.
+    TripleBuffer( const TripleBuffer& );
+    /// Not copyable.
+    TripleBuffer& operator=( const TripleBuffer& );
+};
+
+// Include the template code.
+#include "util/TripleBuffer.inl"
+
+}} // cgt::util
+
+#endif /* !__CGT__UTIL__TRIPLE_BUFFER_H__INCL__ */
@@ -0,0 +1,51 @@
+/**
+ * @file util/TripleBuffer.inl
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+/*************************************************************************/
+/* cgt::util::TripleBuffer                                               */
+/*************************************************************************/
+template< typename T >
+TripleBuffer< T >::TripleBuffer( const T& value )
+: mBack( 0 ),
+  mMiddle( 1 ),
+  mFront( 2 )
+{
+    // Fill all the buffers.
+    std::fill( mBuffers, mBuffers + 3, value );
+}
+
+template< typename T >
+void TripleBuffer< T >::publish()
+{
+    int middle;
+
+    // Swap back and middle, marking it fresh (full barrier).
+    do
+        middle = mMiddle;
+    while( middle != __sync_val_compare_and_swap( &mMiddle, middle, mBack | FRESH ) );
+
+    mBack = middle & ~FRESH;
+}
+
+template< typename T >
+bool TripleBuffer< T >::update()
+{
+    int middle;
+
+    // Swap front and middle, but only if fresh (full barrier).
+    do
+    {
+        middle = mMiddle;
+        if( !( middle & FRESH ) )
+            return false;
+    } while( middle != __sync_val_compare_and_swap( &mMiddle, middle, mFront ) );
+
+    mFront = middle & ~FRESH;
+    return true;
+}
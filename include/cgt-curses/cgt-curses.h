@@ -18,10 +18,20 @@
 #include "alsa/Pcm.h"
 #include "config/ArgvParser.h"
 #include "config/ConfigMgr.h"
+#include "config/Settings.h"
+#include "core/AnalyserFactory.h"
 #include "core/FftAnalyser.h"
+#include "core/LatencyMeter.h"
+#include "core/ObserverBus.h"
 #include "stats/Maximum.h"
+#include "track/TrackWriter.h"
 #include "util/Harmonics.h"
+#include "util/Misc.h"
+#include "util/Thread.h"
+#include "util/Tracer.h"
 #include "util/Tone.h"
+#include "util/ToneTable.h"
+#include "util/TripleBuffer.h"
 
 /*************************************************************************/
 /* cgt-curses                                                            */
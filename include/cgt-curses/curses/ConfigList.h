@@ -26,12 +26,14 @@ public:
     /**
      * @brief Initializes the config list.
      *
-     * @param[in] xpos   Position in X-axis.
-     * @param[in] ypos   Position in Y-axis.
-     * @param[in] width  Size in X-axis.
-     * @param[in] height Size in Y-axis.
+     * @param[in] settings The settings to follow.
+     * @param[in] xpos     Position in X-axis.
+     * @param[in] ypos     Position in Y-axis.
+     * @param[in] width    Size in X-axis.
+     * @param[in] height   Size in Y-axis.
      */
-    ConfigList( int xpos, int ypos, int width, int height );
+    ConfigList( const config::Settings& settings,
+                int xpos, int ypos, int width, int height );
 
     /**
      * @brief Prints the config list.
@@ -47,6 +49,9 @@ protected:
      * @param[in] value Value of the parameter.
      */
     void addLine( int line, const char* title, const char* value );
+
+    /// The settings to follow.
+    const config::Settings& mSettings;
 };
 
 }} // cgt::curses
@@ -26,12 +26,14 @@ public:
     /**
      * @brief Initializes the magnitude bar.
      *
-     * @param[in] xpos   Position in X-axis.
-     * @param[in] ypos   Position in Y-axis.
-     * @param[in] width  Size in X-axis.
-     * @param[in] height Size in Y-axis.
+     * @param[in] settings The settings to follow.
+     * @param[in] xpos     Position in X-axis.
+     * @param[in] ypos     Position in Y-axis.
+     * @param[in] width    Size in X-axis.
+     * @param[in] height   Size in Y-axis.
      */
-    MagnitudeBar( int xpos, int ypos, int width, int height );
+    MagnitudeBar( const config::Settings& settings,
+                  int xpos, int ypos, int width, int height );
 
     /**
      * @brief Add a magnitude to the list.
@@ -36,10 +36,11 @@ public:
     /**
      * @brief Adds a note to the list.
      *
-     * @param[in] tone The tone.
-     * @param[in] harm Harmonic index of the tone.
+     * @param[in] tones The tone table to name the tone with.
+     * @param[in] tone  The tone.
+     * @param[in] harm  Harmonic index of the tone.
      */
-    void print( const util::Tone& tone, unsigned int harm );
+    void print( const util::ToneTable& tones, const util::Tone& tone, unsigned int harm );
     /**
      * @brief Prints the note list.
      */
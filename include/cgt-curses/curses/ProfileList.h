@@ -0,0 +1,91 @@
+/**
+ * @file curses/ProfileList.h
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#ifndef __CGT__CURSES__PROFILE_LIST_H__INCL__
+#define __CGT__CURSES__PROFILE_LIST_H__INCL__
+
+#include "curses/Window.h"
+
+namespace cgt { namespace curses {
+
+#ifdef CGT_PROFILE
+/**
+ * @brief A list of durations of the hop stages.
+ *
+ * Shows the median, 99th percentile and maximum of each stage
+ * over the last second, how much of the time of a hop
+ * the analysis took, the gaps in the capture and how long
+ * the last relock took.
+ *
+ * @author Bloody.Rabbit
+ */
+class ProfileList
+: protected Window
+{
+public:
+    /// Nanoseconds between updates.
+    static const uint64 UPDATE_PERIOD;
+
+    /**
+     * @brief Initializes the profile list.
+     *
+     * @param[in] settings The settings to follow.
+     * @param[in] xpos     Position in X-axis.
+     * @param[in] ypos     Position in Y-axis.
+     * @param[in] width    Size in X-axis.
+     * @param[in] height   Size in Y-axis.
+     */
+    ProfileList( const config::Settings& settings,
+                 int xpos, int ypos, int width, int height );
+
+    /**
+     * @brief Prints the profile list, if it's time to.
+     *
+     * @param[in] analyser The analyser whose profile to print.
+     * @param[in] force    Whether to print it right away.
+     *
+     * @retval true  The list has been printed.
+     * @retval false It's not time yet.
+     */
+    bool refresh( const core::Analyser& analyser, bool force = false );
+
+protected:
+    /**
+     * @brief Prints a line of values.
+     *
+     * @param[in] line  Line at which to print.
+     * @param[in] title Title of the line.
+     * @param[in] p50   The median.
+     * @param[in] p99   The 99th percentile.
+     * @param[in] max   The maximum.
+     */
+    void addLine( int line, const char* title, double p50, double p99, double max );
+    /**
+     * @brief Prints a line with a single value.
+     *
+     * @param[in] line  Line at which to print.
+     * @param[in] title Title of the line.
+     * @param[in] value The value.
+     */
+    void addLine( int line, const char* title, const char* value );
+
+    /// Duration of a hop [ns].
+    double           mBudget;
+    /// The profile as of the last update.
+    core::HopProfile mLast;
+    /// The profile since the last update.
+    core::HopProfile mRecent;
+    /// Time of the last update [ns].
+    uint64           mLastTime;
+};
+#endif /* CGT_PROFILE */
+
+}} // cgt::curses
+
+#endif /* !__CGT__CURSES__PROFILE_LIST_H__INCL__ */
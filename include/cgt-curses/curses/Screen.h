@@ -13,6 +13,7 @@
 #include "curses/ConfigList.h"
 #include "curses/MagnitudeBar.h"
 #include "curses/NoteList.h"
+#include "curses/ProfileList.h"
 #include "curses/TunerBar.h"
 
 namespace cgt { namespace curses {
@@ -20,38 +21,119 @@ namespace cgt { namespace curses {
 /**
  * @brief An observer based on curses.
  *
+ * The observer interface only records frames, it never
+ * touches the terminal, so it may be called by the analysis
+ * thread. Recorded frames are drawn by render(), called
+ * by the thread owning curses at its own pace.
+ *
  * @author Bloody.Rabbit
  */
 class Screen
-: public core::Analyser::IObserver
+: public core::Analyser::IFrameObserver
 {
 public:
     /**
      * @brief Initializes the observer.
      *
-     * @param[in] xpos   Position in X-axis.
-     * @param[in] ypos   Position in Y-axis.
-     * @param[in] width  Size in X-axis.
-     * @param[in] height Size in Y-axis.
+     * @param[in] settings The settings to follow.
+     * @param[in] xpos     Position in X-axis.
+     * @param[in] ypos     Position in Y-axis.
+     * @param[in] width    Size in X-axis.
+     * @param[in] height   Size in Y-axis.
+     */
+    Screen( const config::Settings& settings,
+            int xpos, int ypos, int width, int height );
+
+    /**
+     * @brief Records an analysis frame.
+     *
+     * @param[in] frame The frame.
+     */
+    void addFrame( const core::Analyser::Frame& frame );
+
+    /**
+     * @brief Follows an analyser.
+     *
+     * The fundamentals go to the tuner from the pitches,
+     * if the analyser reports them, or from the frequencies.
+     *
+     * @param[in] analyser The analyser.
      */
-    Screen( int xpos, int ypos, int width, int height );
+    void follow( const core::Analyser& analyser ) { mAnalyser = &analyser; }
 
     /**
-     * @brief Starts analysis frame.
+     * @brief Draws the latest frame, if there's a new one.
      */
-    void start();
+    void render();
     /**
-     * @brief Adds a frequency within analysis frame.
+     * @brief Shows the settings again, after they've changed.
+     */
+    void reload();
+
+    /**
+     * @brief Obtains latency of the frames drawn.
+     *
+     * @return The latency meter.
      */
-    void add( double freq, double mag );
+    const core::LatencyMeter& latency() const { return mLatency; }
+
+#ifdef CGT_PROFILE
     /**
-     * @brief Ends analysis frame.
+     * @brief Shows or hides the profile in place of the config.
+     *
+     * @param[in] analyser The analyser whose profile to show.
      */
-    void end();
+    void toggleProfile( const core::Analyser& analyser );
+#endif /* CGT_PROFILE */
 
 protected:
+    /// Readability typedef of a detected frequency.
+    typedef core::Analyser::Peak Peak;
+
+    /**
+     * @brief A recorded analysis frame.
+     *
+     * @author Bloody.Rabbit
+     */
+    struct Frame
+    {
+        /**
+         * @brief Initializes an empty frame.
+         */
+        Frame() : captured( 0 ), delay( 0 ), rate( 0 ) {}
+
+        /// When its newest sample was captured [ns].
+        uint64              captured;
+        /// Group delay of the analysis [samples].
+        unsigned int        delay;
+        /// The sample rate.
+        unsigned int        rate;
+        /// Detected fundamentals.
+        std::vector< Peak > pitches;
+        /// Detected frequencies.
+        std::vector< Peak > peaks;
+    };
+
+    /**
+     * @brief Draws a frame.
+     *
+     * @param[in] frame The frame.
+     */
+    void draw( const Frame& frame );
+
+    /// Frames passed from analysis to rendering.
+    util::TripleBuffer< Frame > mFrames;
+    /// Latency of the frames drawn.
+    core::LatencyMeter          mLatency;
+
+    /// Tone mapping.
+    util::ToneTable           mTones;
     /// Harmonics analyser.
-    util::Harmonics mHarmonics;
+    util::Harmonics           mHarmonics;
+    /// The analyser followed, if any.
+    const core::Analyser*     mAnalyser;
+    /// Fundamentals put on the tuner by the last draw.
+    std::vector< util::Tone > mTuned;
 
     /// Configuration list.
     ConfigList   mConfig;
@@ -61,6 +143,13 @@ protected:
     NoteList     mNotes;
     /// Tuner bar.
     TunerBar     mTuner;
+
+#ifdef CGT_PROFILE
+    /// Profile list.
+    ProfileList             mProfileList;
+    /// The analyser whose profile is shown, if any.
+    const core::Analyser* mProfile;
+#endif /* CGT_PROFILE */
 };
 
 }} // cgt::curses
@@ -26,19 +26,22 @@ public:
     /**
      * @brief Initializes the tuner bar.
      *
-     * @param[in] xpos    Position in X-axis.
-     * @param[in] ypos    Position in Y-axis.
-     * @param[in] width   Size in X-axis.
-     * @param[in] height  Size in Y-axis.
+     * @param[in] settings The settings to follow.
+     * @param[in] xpos     Position in X-axis.
+     * @param[in] ypos     Position in Y-axis.
+     * @param[in] width    Size in X-axis.
+     * @param[in] height   Size in Y-axis.
      */
-    TunerBar( int xpos, int ypos, int width, int height );
+    TunerBar( const config::Settings& settings,
+              int xpos, int ypos, int width, int height );
 
     /**
      * @brief Add a fundamental tone.
      *
-     * @param[in] tone The tone.
+     * @param[in] tones The tone table to name the tone with.
+     * @param[in] tone  The tone.
      */
-    void add( const util::Tone& tone );
+    void add( const util::ToneTable& tones, const util::Tone& tone );
     /**
      * @brief Reprints the magnitude bar.
      */
@@ -123,6 +123,12 @@ public:
      * Implemented by <code>werase</code>.
      */
     void erase();
+    /**
+     * @brief Marks the whole window as changed.
+     *
+     * Implemented by <code>touchwin</code>.
+     */
+    void touch();
 
 protected:
     /// The wrapped window.
@@ -82,3 +82,8 @@ inline void Window::erase()
 {
     ::werase( mWindow );
 }
+
+inline void Window::touch()
+{
+    ::touchwin( mWindow );
+}
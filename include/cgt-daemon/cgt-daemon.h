@@ -0,0 +1,42 @@
+/**
+ * @file cgt-daemon.h
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#ifndef __CGT_DAEMON_H__INCL__
+#define __CGT_DAEMON_H__INCL__
+
+/*************************************************************************/
+/* cgt-common                                                            */
+/*************************************************************************/
+#include "cgt-common.h"
+
+#include "config/ArgvParser.h"
+#include "config/ConfigMgr.h"
+#include "config/Settings.h"
+#include "core/AnalyserFactory.h"
+#include "core/FftAnalyser.h"
+#include "core/LatencyMeter.h"
+#include "core/ObserverBus.h"
+#include "ipc/FrameRing.h"
+#include "track/TrackWriter.h"
+#include "util/Misc.h"
+#include "util/Thread.h"
+#include "util/Tracer.h"
+
+/*************************************************************************/
+/* cgt-daemon                                                            */
+/*************************************************************************/
+// POSIX signals
+#include <csignal>
+// UNIX domain sockets
+#include <sys/socket.h>
+#include <sys/un.h>
+
+using namespace cgt;
+
+#endif /* !__CGT_DAEMON_H__INCL__ */
@@ -0,0 +1,110 @@
+/**
+ * @file server/StreamServer.h
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#ifndef __CGT__SERVER__STREAM_SERVER_H__INCL__
+#define __CGT__SERVER__STREAM_SERVER_H__INCL__
+
+namespace cgt { namespace server {
+
+/**
+ * @brief Publishes frames to local clients.
+ *
+ * The frames themselves go to the shared frame ring; each
+ * client connected to the UNIX socket (SOCK_SEQPACKET) only
+ * gets a message per frame, carrying its index (uint64,
+ * host byte order). The server never waits for a client:
+ * one lagging behind misses the messages, but it can
+ * catch up by FrameRing::head().
+ *
+ * @author Bloody.Rabbit
+ */
+class StreamServer
+: public core::Analyser::IFrameObserver
+{
+public:
+    /**
+     * @brief Starts listening.
+     *
+     * A socket of the same path is replaced only if
+     * nobody listens on it; otherwise this fails.
+     *
+     * @param[in] path Path of the socket.
+     * @param[in] ring Where to publish the frames.
+     */
+    StreamServer( const char* path, ipc::FrameRing& ring );
+    /**
+     * @brief Disconnects the clients and removes the socket.
+     */
+    ~StreamServer();
+
+    /**
+     * @brief Obtains number of connected clients.
+     *
+     * @return The number of clients.
+     */
+    size_t clientCount() const { return mClients.size(); }
+    /**
+     * @brief Obtains number of messages clients missed.
+     *
+     * @return The number of messages.
+     */
+    uint64 missed() const { return mMissed; }
+    /**
+     * @brief Obtains latency of the frames published.
+     *
+     * @return The latency meter.
+     */
+    const core::LatencyMeter& latency() const { return mLatency; }
+
+    /**
+     * @brief Publishes a frame and notifies the clients.
+     *
+     * @param[in] frame The frame.
+     */
+    void addFrame( const core::Analyser::Frame& frame );
+
+protected:
+    /**
+     * @brief Accepts the pending connections.
+     */
+    void acceptClients();
+    /**
+     * @brief Notifies the clients of a frame.
+     *
+     * @param[in] index Index of the frame.
+     */
+    void notifyClients( uint64 index );
+    /**
+     * @brief Checks if nobody listens on a socket.
+     *
+     * @param[in] addr Address of the socket.
+     *
+     * @retval true  The socket is stale, or there's none.
+     * @retval false It's in use or not a socket at all.
+     */
+    static bool stale( const struct sockaddr_un& addr );
+
+    /// Path of the socket.
+    std::string        mPath;
+    /// The listening socket.
+    int                mListener;
+    /// The connected clients.
+    std::vector< int > mClients;
+    /// Where the frames go.
+    ipc::FrameRing&    mRing;
+
+    /// Number of messages missed.
+    uint64             mMissed;
+    /// Latency of the frames published.
+    core::LatencyMeter mLatency;
+};
+
+}} // cgt::server
+
+#endif /* !__CGT__SERVER__STREAM_SERVER_H__INCL__ */
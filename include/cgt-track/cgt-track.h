@@ -0,0 +1,29 @@
+/**
+ * @file cgt-track.h
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#ifndef __CGT_TRACK_H__INCL__
+#define __CGT_TRACK_H__INCL__
+
+/*************************************************************************/
+/* cgt-common                                                            */
+/*************************************************************************/
+#include "cgt-common.h"
+
+#include "config/ArgvParser.h"
+#include "config/ConfigMgr.h"
+#include "config/Settings.h"
+#include "track/Format.h"
+#include "track/IndexWriter.h"
+#include "track/TrackIndex.h"
+#include "track/TrackReader.h"
+#include "util/Tone.h"
+
+using namespace cgt;
+
+#endif /* !__CGT_TRACK_H__INCL__ */
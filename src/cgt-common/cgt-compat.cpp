@@ -72,8 +72,11 @@ void vssprintf( std::string& str, const char* fmt, va_list ap )
         // Resize the buffer
         str.resize( off + size );
 
-        // Print to the buffer
-        code = ::vsnprintf( &str[off], str.length() - off, fmt, ap );
+        // Print to the buffer, the list is spent afterwards
+        va_list copy;
+        va_copy( copy, ap );
+        code = ::vsnprintf( &str[off], str.length() - off, fmt, copy );
+        va_end( copy );
         // Check for truncation
         if( str.length() <= off + code )
             // Output truncated
@@ -10,7 +10,6 @@
 #include "cgt-common.h"
 
 #include "config/ArgvParser.h"
-#include "config/ConfigMgr.h"
 
 using namespace cgt;
 using namespace cgt::config;
@@ -46,18 +45,18 @@ void ArgvParser::addFlag( char shortKey, const char* longKey,
                           const char* configKey, const char* description,
                           bool value )
 {
-    add( new FlagOption( shortKey, longKey, configKey, description, value ) );
+    add( new FlagOption( mConfigMgr, shortKey, longKey, configKey, description, value ) );
 }
 
 void ArgvParser::addValue( char shortKey, const char* longKey,
                            const char* configKey, const char* description )
 {
-    add( new ValueOption( shortKey, longKey, configKey, description ) );
+    add( new ValueOption( mConfigMgr, shortKey, longKey, configKey, description ) );
 }
 
 void ArgvParser::addConfig()
 {
-    add( new ConfigOption() );
+    add( new ConfigOption( mConfigMgr ) );
 }
 
 void ArgvParser::addHelp()
@@ -233,8 +232,9 @@ ArgvParser::Option::Option( char shortKey, const char* longKey,
 /*************************************************************************/
 /* cgt::config::ArgvParser::ConfigOption                                 */
 /*************************************************************************/
-ArgvParser::ConfigOption::ConfigOption()
-: ArgvParser::Option( 'c', "config", "Loads an XML-based configuration file" )
+ArgvParser::ConfigOption::ConfigOption( ConfigMgr& config )
+: ArgvParser::Option( 'c', "config", "Loads an XML-based configuration file" ),
+  mParser( config )
 {
 }
 
@@ -269,10 +269,11 @@ unsigned int ArgvParser::ConfigOption::parse( unsigned int argc, char* argv[] )
 /*************************************************************************/
 /* cgt::config::ArgvParser::FlagOption                                   */
 /*************************************************************************/
-ArgvParser::FlagOption::FlagOption( char shortKey, const char* longKey,
+ArgvParser::FlagOption::FlagOption( ConfigMgr& config, char shortKey, const char* longKey,
                                     const char* configKey, const char* description,
                                     bool value )
 : ArgvParser::Option( shortKey, longKey, description ),
+  mConfigMgr( config ),
   mConfigKey( configKey ),
   mValue( value )
 {
@@ -281,7 +282,7 @@ ArgvParser::FlagOption::FlagOption( char shortKey, const char* longKey,
 unsigned int ArgvParser::FlagOption::parse( unsigned int, char*[] )
 {
     // Set the flag
-    sConfigMgr[ mConfigKey ] = mValue;
+    mConfigMgr[ mConfigKey ] = mValue;
 
     // No arguments to consume
     return 0;
@@ -330,9 +331,10 @@ unsigned int ArgvParser::HelpOption::parse( unsigned int, char*[] )
 /*************************************************************************/
 /* cgt::config::ArgvParser::ValueOption                                  */
 /*************************************************************************/
-ArgvParser::ValueOption::ValueOption( char shortKey, const char* longKey,
+ArgvParser::ValueOption::ValueOption( ConfigMgr& config, char shortKey, const char* longKey,
                                       const char* configKey, const char* description )
 : ArgvParser::Option( shortKey, longKey, description ),
+  mConfigMgr( config ),
   mConfigKey( configKey )
 {
 }
@@ -360,7 +362,7 @@ unsigned int ArgvParser::ValueOption::parse( unsigned int argc, char* argv[] )
     }
 
     // Use the argument as a value
-    sConfigMgr[ mConfigKey ] = *argv;
+    mConfigMgr[ mConfigKey ] = *argv;
 
     // 1 argument consumed
     return 1;
@@ -0,0 +1,38 @@
+/**
+ * @file config/ConfigMgr.cpp
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#include "cgt-common.h"
+
+#include "config/ConfigMgr.h"
+
+using namespace cgt;
+using namespace cgt::config;
+
+/*************************************************************************/
+/* cgt::config::ConfigMgr                                                */
+/*************************************************************************/
+std::auto_ptr< ConfigMgr > ConfigMgr::mInstance( NULL );
+pthread_once_t             ConfigMgr::mInstanceOnce = PTHREAD_ONCE_INIT;
+
+ConfigMgr& ConfigMgr::get()
+{
+    ::pthread_once( &mInstanceOnce, &ConfigMgr::create );
+    return *mInstance;
+}
+
+const db::TextValue* ConfigMgr::find( const std::string& key ) const
+{
+    std::map< std::string, db::TextValue >::const_iterator itr = mValues.find( key );
+    return mValues.end() != itr ? &itr->second : NULL;
+}
+
+void ConfigMgr::create()
+{
+    mInstance.reset( new ConfigMgr );
+}
@@ -0,0 +1,67 @@
+/**
+ * @file config/Settings.cpp
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#include "cgt-common.h"
+
+#include "config/Settings.h"
+
+using namespace cgt;
+using namespace cgt::config;
+
+/**
+ * @brief Parses a numeric value.
+ *
+ * @param[in]  value The text value.
+ * @param[out] field Where to store it.
+ */
+template< typename T >
+static void parse( const db::TextValue& value, T& field )
+{
+    field = value.as< T >();
+}
+
+/**
+ * @brief Parses a text value.
+ *
+ * @param[in]  value The text value.
+ * @param[out] field Where to store it.
+ */
+static void parse( const db::TextValue& value, std::string& field )
+{
+    field = value.as< const char* >();
+}
+
+/*************************************************************************/
+/* cgt::config::Settings                                                 */
+/*************************************************************************/
+volatile uint64 Settings::mLastVersion = 0;
+
+Settings::Settings()
+: version( 0 )
+{
+#define CGT_SETTING( type, name, key, value ) \
+    name = value;
+#include "config/Settings.def"
+#undef CGT_SETTING
+}
+
+Settings::Settings( const ConfigMgr& config )
+: version( __sync_add_and_fetch( &mLastVersion, 1 ) )
+{
+    const db::TextValue* text;
+
+#define CGT_SETTING( type, name, key, value )                           \
+    if( NULL != ( text = config.find( key ) )                           \
+        && NULL != text->as< const char* >() )                          \
+        parse( *text, name );                                           \
+    else                                                                \
+        name = value;
+#include "config/Settings.def"
+#undef CGT_SETTING
+}
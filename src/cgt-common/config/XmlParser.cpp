@@ -9,7 +9,6 @@
 
 #include "cgt-common.h"
 
-#include "config/ConfigMgr.h"
 #include "config/XmlParser.h"
 
 using namespace cgt;
@@ -18,6 +17,11 @@ using namespace cgt::config;
 /*************************************************************************/
 /* cgt::config::XmlParser                                                */
 /*************************************************************************/
+XmlParser::XmlParser( ConfigMgr& config )
+: mConfigMgr( config )
+{
+}
+
 bool XmlParser::VisitEnter( const TiXmlElement& element,
                             const TiXmlAttribute* attribute )
 {
@@ -31,7 +35,7 @@ bool XmlParser::VisitEnter( const TiXmlElement& element,
     // Iterate over all attributes
     for(; NULL != attribute; attribute = attribute->Next() )
         // Import the config value
-        sConfigMgr[ mConfigKey + '.' + attribute->NameTStr() ] =
+        mConfigMgr[ mConfigKey + '.' + attribute->NameTStr() ] =
             attribute->ValueStr();
 
     // Visit children
@@ -55,7 +59,7 @@ bool XmlParser::VisitExit( const TiXmlElement& element )
 bool XmlParser::Visit( const TiXmlText& text )
 {
     // Import the config value
-    sConfigMgr[ mConfigKey ] = text.ValueStr();
+    mConfigMgr[ mConfigKey ] = text.ValueStr();
     // No error occurred
     return true;
 }
@@ -10,30 +10,139 @@
 #include "cgt-common.h"
 
 #include "core/Analyser.h"
+#include "core/Probes.h"
+#include "util/Misc.h"
+#include "util/Tracer.h"
 
 using namespace cgt;
 using namespace cgt::core;
 
+/*************************************************************************/
+/* cgt::core::Analyser::CaptureSizeChange                                */
+/*************************************************************************/
+class Analyser::CaptureSizeChange
+: public Analyser::Change
+{
+public:
+    CaptureSizeChange( unsigned int captureSize )
+    : mCaptureSize( captureSize )
+    {
+    }
+
+    void apply( Analyser& analyser )
+    {
+        // A resize posted before may have made it invalid.
+        if( analyser.bufferSize() < mCaptureSize )
+            return;
+
+        const unsigned int previous = analyser.mCaptureSize;
+        analyser.mCaptureSize = mCaptureSize;
+
+        analyser.rehop( previous );
+    }
+
+protected:
+    /// The new capture size.
+    unsigned int mCaptureSize;
+};
+
+/*************************************************************************/
+/* cgt::core::Analyser::ResizeChange                                     */
+/*************************************************************************/
+class Analyser::ResizeChange
+: public Analyser::Change
+{
+public:
+    ResizeChange( Analyser* twin )
+    : mTwin( twin )
+    {
+    }
+
+    ~ResizeChange()
+    {
+        // Once applied, it holds the old buffers.
+        util::safeDelete( mTwin );
+    }
+
+    void apply( Analyser& analyser )
+    {
+        analyser.adopt( *mTwin );
+    }
+
+protected:
+    /// The prepared twin.
+    Analyser* mTwin;
+};
+
+/*************************************************************************/
+/* cgt::core::Analyser::ReopenChange                                     */
+/*************************************************************************/
+class Analyser::ReopenChange
+: public Analyser::Change
+{
+public:
+    ReopenChange( alsa::Pcm* pcm )
+    : mPcm( pcm )
+    {
+    }
+
+    ~ReopenChange()
+    {
+        // Once applied, it holds the old PCM.
+        util::safeDelete( mPcm );
+    }
+
+    void apply( Analyser& analyser )
+    {
+        std::swap( analyser.mPcm, mPcm );
+
+        // The samples aren't continuous anymore.
+        analyser.lose();
+    }
+
+protected:
+    /// The opened PCM.
+    alsa::Pcm* mPcm;
+};
+
 /*************************************************************************/
 /* cgt::core::Analyser                                                   */
 /*************************************************************************/
-void ( Analyser::* Analyser::CAPTURE_ROUTINES[] )() =
+const double Analyser::GATE_HYSTERESIS = 3.0;
+
+bool ( Analyser::* Analyser::CAPTURE_ROUTINES[] )() =
 {
     &Analyser::captureFull, // CAPTURE_FULL
     &Analyser::captureStep  // CAPTURE_STEP
 };
 
-Analyser::Analyser( IObserver& observer )
+Analyser::Analyser( IFrameObserver& observer )
 : mObserver( &observer ),
   mPcm( NULL ),
+  mStatus( NULL ),
 #ifdef CGT_DEBUG_ANALYSIS_FREQ
   mPhase( 0 ),
 #endif /* CGT_DEBUG_ANALYSIS_FREQ */
   mCapture( CAPTURE_FULL ),
+  mGateThreshold( -HUGE_VAL ),
+  mGateOpen( 0 ),
+  mGateClose( 0 ),
+  mGateHold( 0 ),
+  mGateHoldLeft( 0 ),
+  mGateOpened( false ),
+  mHopsAnalysed( 0 ),
+  mHopsSkipped( 0 ),
+  mGaps( 0 ),
+  mShortReads( 0 ),
   mSampleRate( 0 ),
   mBufferSize( 0 ),
   mCaptureSize( 0 ),
-  mSamples( NULL )
+  mSamples( NULL ),
+  mPosition( 0 ),
+  mPushed( 0 ),
+  mCaptured( 0 ),
+  mPending( NULL ),
+  mApplied( NULL )
 {
 }
 
@@ -45,36 +154,64 @@ Analyser::~Analyser()
 
 void Analyser::init( const char* name, unsigned int rate,
                      unsigned int bufferSize, unsigned int captureSize )
+{
+    // Setup the buffers first, it frees everything.
+    init( rate, bufferSize, captureSize );
+
+    // Create the PCM object.
+    mPcm = openPcm( name, rate );
+
+    // Its status tells when the samples were captured.
+    const int code = ::snd_pcm_status_malloc( &mStatus );
+    // Check for error
+    if( 0 > code )
+        throw except::RuntimeError(
+            ::ssprintf( "Failed to allocate PCM status: %s",
+                        ::snd_strerror( code ) ) );
+}
+
+void Analyser::init( unsigned int rate, unsigned int bufferSize,
+                     unsigned int captureSize )
 {
     // Make sure the sizes are valid.
-    if( bufferSize < captureSize )
+    if( 0 == captureSize || bufferSize < captureSize )
         throw except::InvalidArgument(
-            ::ssprintf( "Capture size (%u) larger than buffer size (%u)",
+            ::ssprintf( "Invalid capture size (%u) for buffer size (%u)",
                         captureSize, bufferSize ) );
 
     // Make sure all resources are freed first.
     free();
 
-    // Create the PCM object.
-    mPcm = new alsa::Pcm( name, SND_PCM_STREAM_CAPTURE, 0 );
-
-    // We want doubles of one channel at the given rate.
-    mPcm->setParams( SND_PCM_FORMAT_FLOAT64,
-                     SND_PCM_ACCESS_RW_NONINTERLEAVED,
-                     1, rate, 0, -1 );
-
     // Setup the buffers.
     mSampleRate  = rate;
     mBufferSize  = bufferSize;
     mCaptureSize = captureSize;
 
-    mSamples = new double[ this->bufferSize() ];
+    // Aligned for the shared FFTW plans.
+    mSamples  = (double*)::fftw_malloc( sizeof( double ) * this->bufferSize() );
+    mPosition = 0;
+    mPushed   = 0;
+    mCaptured = 0;
+
+    // Frames never have more peaks than half the bins,
+    // so that they're never reallocated while processing.
+    mPitches.reserve( this->bufferSize() / 2 + 1 );
+    mPeaks.reserve( this->bufferSize() / 2 + 1 );
+
+    // Start with the gate closed.
+    mGateHoldLeft = 0;
+    mGateOpened   = false;
+
+    mHopsAnalysed = 0;
+    mHopsSkipped  = 0;
+    mGaps         = 0;
+    mShortReads   = 0;
 }
 
 void Analyser::free()
 {
     // Release the buffers.
-    util::safeDeleteArray( mSamples );
+    util::safeRelease( mSamples, ::fftw_free );
 
     mSampleRate  = 0;
     mBufferSize  = 0;
@@ -86,58 +223,264 @@ void Analyser::free()
 
     // Reset the state to default
     mCapture = CAPTURE_FULL;
+    mPushed  = 0;
+
+    // Changes made for these buffers are useless now.
+    deleteChanges( __sync_lock_test_and_set( &mPending, (Change*)NULL ) );
+    deleteChanges( __sync_lock_test_and_set( &mApplied, (Change*)NULL ) );
 
     // Free the PCM.
+    util::safeRelease( mStatus, ::snd_pcm_status_free );
     util::safeDelete( mPcm );
 }
 
+void Analyser::setGateThreshold( double threshold )
+{
+    mGateThreshold = threshold;
+
+    // The levels are mean squares, threshold is RMS in the same
+    // dB scale as the magnitude cutoffs.
+    mGateOpen  = ::pow( 10, threshold / 5 );
+    mGateClose = ::pow( 10, ( threshold - GATE_HYSTERESIS ) / 5 );
+}
+
+void Analyser::post( Change* change )
+{
+    // Delete what's been applied so far.
+    reclaim();
+
+    // Push it to the front of the pending list.
+    Change* head;
+    do
+    {
+        head = mPending;
+        change->mNext = head;
+    } while( !__sync_bool_compare_and_swap( &mPending, head, change ) );
+}
+
+void Analyser::reclaim()
+{
+    deleteChanges( __sync_lock_test_and_set( &mApplied, (Change*)NULL ) );
+}
+
+Analyser::Change* Analyser::prepareCaptureSize( unsigned int captureSize ) const
+{
+    // Make sure the size is valid.
+    if( 0 == captureSize || bufferSize() < captureSize )
+        throw except::InvalidArgument(
+            ::ssprintf( "Invalid capture size (%u) for buffer size (%u)",
+                        captureSize, bufferSize() ) );
+
+    return new CaptureSizeChange( captureSize );
+}
+
+Analyser::Change* Analyser::prepareResize( unsigned int bufferSize, unsigned int captureSize ) const
+{
+    // Nothing to resize yet?
+    if( NULL == mSamples )
+        throw except::LogicError( "Analyser not initialized" );
+
+    // Prepare the buffers and plans here ...
+    std::auto_ptr< Analyser > twin( createTwin() );
+    twin->init( sampleRate(), bufferSize, captureSize );
+
+    // ... and only swap them between hops.
+    return new ResizeChange( twin.release() );
+}
+
+Analyser::Change* Analyser::prepareReopen( const char* name ) const
+{
+    // Pushed samples have no PCM.
+    if( NULL == mPcm )
+        throw except::LogicError( "No PCM to capture from" );
+
+    // Open it here, the same way as in init().
+    std::auto_ptr< alsa::Pcm > pcm( openPcm( name, sampleRate() ) );
+
+    return new ReopenChange( pcm.release() );
+}
+
+void Analyser::setCaptureSize( unsigned int captureSize )
+{
+    post( prepareCaptureSize( captureSize ) );
+}
+
+void Analyser::resize( unsigned int bufferSize, unsigned int captureSize )
+{
+    post( prepareResize( bufferSize, captureSize ) );
+}
+
+void Analyser::reopen( const char* name )
+{
+    post( prepareReopen( name ) );
+}
+
+void Analyser::step()
+{
+    // Between hops, apply what's been posted.
+    applyChanges();
+
+    // Check how much we're going to capture.
+    const size_t count = CAPTURE_FULL == mCapture ? bufferSize() : captureSize();
+
+    // Capture the samples; if some got lost, start over next time.
+    if( ( this->* ( CAPTURE_ROUTINES[ mCapture ] ) )() )
+        processHop( count );
+}
+
+void Analyser::process( const float* samples, size_t count )
+{
+    // Not initialized yet?
+    if( NULL == mSamples )
+        return;
+
+    while( 0 < count )
+    {
+        // Between hops, apply what's been posted.
+        if( 0 == mPushed )
+            applyChanges();
+
+        // A full buffer first, then hops.
+        const size_t hop   = CAPTURE_FULL == mCapture ? bufferSize() : captureSize();
+        const size_t start = bufferSize() - hop;
+
+        // Make room for a new hop.
+        if( 0 == mPushed && CAPTURE_STEP == mCapture )
+            shift();
+
+        // Take as much as the hop needs.
+        const size_t n = std::min( hop - mPushed, count );
+        std::copy( samples, samples + n, &mSamples[ start + mPushed ] );
+
+        mPushed += n;
+        samples += n;
+        count   -= n;
+
+        // Is the hop complete?
+        if( hop == mPushed )
+        {
+            // Pushed samples have no timestamps, take the arrival.
+            mCaptured  = util::monotonicTime();
+            mPosition += hop;
+            mPushed    = 0;
+            mCapture   = CAPTURE_STEP;
+
+            processHop( hop );
+        }
+    }
+}
+
+void Analyser::run( util::Thread& thread )
+{
+    // Tell it apart in the trace.
+    sTracer.nameThread( "Analysis" );
+
+    // Keep stepping until told otherwise.
+    while( !thread.stopRequested() )
+        step();
+}
+
 void Analyser::reset()
 {
+    CGT_PROBE1( reset, mPosition );
+
     // Refill the buffer entirely
     mCapture = CAPTURE_FULL;
+    mPushed  = 0;
+}
+
+void Analyser::applyChanges()
+{
+    // Anything posted?
+    if( NULL == mPending )
+        return;
+
+    Change* changes = __sync_lock_test_and_set( &mPending, (Change*)NULL );
+
+    // Restore the order they were posted in.
+    Change* first = NULL;
+    Change* last  = changes;
+    while( NULL != changes )
+    {
+        Change* next = changes->mNext;
+        changes->mNext = first;
+        first   = changes;
+        changes = next;
+    }
+
+    for( Change* change = first; NULL != change; change = change->mNext )
+        change->apply( *this );
+
+    // Leave the deleting to reclaim(), it may lock.
+    Change* head;
+    do
+    {
+        head = mApplied;
+        last->mNext = head;
+    } while( !__sync_bool_compare_and_swap( &mApplied, head, first ) );
 }
 
-void Analyser::captureFull()
+void Analyser::adopt( Analyser& twin )
+{
+    // Keep the latest samples, silence before them.
+    const size_t kept    = std::min( bufferSize(), twin.bufferSize() );
+    const size_t missing = twin.bufferSize() - kept;
+
+    ::memset( &twin.mSamples[ 0 ], 0, sizeof( double ) * missing );
+    ::memcpy( &twin.mSamples[ missing ], &mSamples[ bufferSize() - kept ],
+              sizeof( double ) * kept );
+
+    std::swap( mSamples,     twin.mSamples );
+    std::swap( mBufferSize,  twin.mBufferSize );
+    std::swap( mCaptureSize, twin.mCaptureSize );
+
+    // The twin reserved the frames for its size.
+    mPitches.swap( twin.mPitches );
+    mPeaks.swap( twin.mPeaks );
+}
+
+void Analyser::deleteChanges( Change* changes )
+{
+    while( NULL != changes )
+    {
+        Change* next = changes->mNext;
+        delete changes;
+        changes = next;
+    }
+}
+
+bool Analyser::captureFull()
 {
 #ifndef CGT_DEBUG_ANALYSIS_FREQ
     // Fill the buffer entirely.
-    void* buf[] = { &mSamples[ 0 ] };
-    snd_pcm_sframes_t code = mPcm->readNonint( buf, bufferSize() );
-
-    // Have we read too little?
-    if( code < bufferSize() )
-        // Throw an error message
-        throw except::UnderflowError(
-            ::ssprintf( "Read only %ld non-interleaved samples (expected %u)",
-                        code, bufferSize() ) );
+    if( !read( &mSamples[ 0 ], bufferSize() ) )
+        return false;
 #else /* CGT_DEBUG_ANALYSIS_FREQ */
     for( size_t i = 0;
          i < bufferSize();
          ++i, mPhase += 2.0 * M_PI / sampleRate() )
         mSamples[ i ] = ::cos( CGT_DEBUG_ANALYSIS_FREQ * mPhase );
+
+    mCaptured = util::monotonicTime();
 #endif /* CGT_DEBUG_ANALYSIS_FREQ */
 
+    // Count the samples
+    mPosition += bufferSize();
+
     // Next time, run only a step capture
     mCapture = CAPTURE_STEP;
+    return true;
 }
 
-void Analyser::captureStep()
+bool Analyser::captureStep()
 {
     // We want to get only the capture size, shift the buffer first.
-    ::memmove( &mSamples[ 0 ], &mSamples[ captureSize() ],
-               sizeof( double ) * ( bufferSize() - captureSize() ) );
+    shift();
 
 #ifndef CGT_DEBUG_ANALYSIS_FREQ
     // Capture only the capture size.
-    void* buf[] = { &mSamples[ bufferSize() - captureSize() ] };
-    snd_pcm_sframes_t code = mPcm->readNonint( buf, captureSize() );
-
-    // Have we read too little?
-    if( code < captureSize() )
-        // Throw an error message
-        throw except::UnderflowError(
-            ::ssprintf( "Read only %ld non-interleaved samples (expected %u)",
-                        code, captureSize() ) );
+    if( !read( &mSamples[ bufferSize() - captureSize() ], captureSize() ) )
+        return false;
 #else /* CGT_DEBUG_ANALYSIS_FREQ */
     for( size_t i = bufferSize() - captureSize();
          i < bufferSize();
@@ -145,5 +488,254 @@ void Analyser::captureStep()
         mSamples[ i ] = ::cos( CGT_DEBUG_ANALYSIS_FREQ * mPhase );
 
     ::usleep( 1000lu * 1000lu * captureSize() / sampleRate() );
+    mCaptured = util::monotonicTime();
 #endif /* CGT_DEBUG_ANALYSIS_FREQ */
+
+    // Count the samples
+    mPosition += captureSize();
+    return true;
+}
+
+void Analyser::shift()
+{
+    CGT_PROFILE_STAGE( STAGE_SHIFT );
+
+    ::memmove( &mSamples[ 0 ], &mSamples[ captureSize() ],
+               sizeof( double ) * ( bufferSize() - captureSize() ) );
+}
+
+bool Analyser::read( double* samples, unsigned int count )
+{
+    // Pushed samples have no PCM.
+    if( NULL == mPcm )
+        throw except::LogicError( "No PCM to capture from" );
+
+    CGT_PROFILE_STAGE( STAGE_CAPTURE );
+
+    while( 0 < count )
+    {
+        void* buf[] = { samples };
+        const snd_pcm_sframes_t code = mPcm->readNonintRecover( buf, count );
+
+        // Samples got lost, the PCM is recovered already.
+        if( 0 > code )
+        {
+            CGT_PROBE1( xrun, code );
+
+            lose();
+            return false;
+        }
+
+        // Nothing at all? Don't spin, give up as a gap.
+        if( 0 == code )
+        {
+            ++mShortReads;
+
+            lose();
+            return false;
+        }
+
+        // Have we read too little? Read the rest.
+        if( code < count )
+            ++mShortReads;
+
+        samples += code;
+        count   -= code;
+    }
+
+    // Note when the last of them was captured.
+    mCaptured = captureTime();
+    return true;
+}
+
+void Analyser::lose()
+{
+    ++mGaps;
+    gap();
+
+    // What's buffered doesn't connect to what comes next.
+    mCapture = CAPTURE_FULL;
+}
+
+uint64 Analyser::captureTime()
+{
+    if( NULL != mStatus && 0 <= mPcm->status( mStatus ) )
+    {
+        snd_htimestamp_t stamp;
+        ::snd_pcm_status_get_htstamp( mStatus, &stamp );
+
+        // Zero unless the PCM has timestamps.
+        if( 0 != stamp.tv_sec || 0 != stamp.tv_nsec )
+        {
+            // The samples still waiting were captured after ours.
+            const snd_pcm_sframes_t waiting = std::max< snd_pcm_sframes_t >(
+                0, ::snd_pcm_status_get_delay( mStatus ) );
+
+            return uint64( stamp.tv_sec ) * 1000000000 + stamp.tv_nsec
+                - uint64( waiting ) * 1000000000 / sampleRate();
+        }
+    }
+
+    // The time of reading has to do.
+    return util::monotonicTime();
+}
+
+alsa::Pcm* Analyser::openPcm( const char* name, unsigned int rate )
+{
+    std::auto_ptr< alsa::Pcm > pcm( new alsa::Pcm( name, SND_PCM_STREAM_CAPTURE, 0 ) );
+
+    // We want doubles of one channel at the given rate.
+    pcm->setParams( SND_PCM_FORMAT_FLOAT64,
+                    SND_PCM_ACCESS_RW_NONINTERLEAVED,
+                    1, rate, 0, -1 );
+
+    // Timestamps on the clock everyone else uses, if there are any.
+    try
+    {
+        pcm->setTimestamps( SND_PCM_TSTAMP_TYPE_MONOTONIC );
+    }
+    catch( const except::RuntimeError& )
+    {
+        // Without them, the time of reading has to do.
+    }
+
+    return pcm.release();
+}
+
+void Analyser::processHop( size_t count )
+{
+    CGT_PROFILE_STAGE( STAGE_HOP );
+    CGT_PROBE2( hop__start, mPosition, count );
+
+    // Analyse the samples only if they're loud enough.
+    const bool analysed = processGate( &mSamples[ bufferSize() - count ], count );
+    if( analysed )
+    {
+        ++mHopsAnalysed;
+        analyse();
+    }
+    else
+    {
+        // Let the observer know there's nothing.
+        ++mHopsSkipped;
+        startFrame();
+        endFrame();
+    }
+
+    CGT_PROBE2( hop__end, mPosition, analysed );
+}
+
+bool Analyser::processGate( const double* samples, size_t count )
+{
+    const double level = meanSquare( samples, count );
+
+    if( mGateOpen <= level )
+    {
+        // An onset, drop whatever got stale.
+        if( !mGateOpened )
+        {
+            CGT_PROBE1( relock, mPosition );
+            relock();
+        }
+
+        mGateOpened   = true;
+        mGateHoldLeft = mGateHold;
+    }
+    else if( mGateOpened && mGateClose > level )
+    {
+        // Hold it open for a while.
+        if( 0 < mGateHoldLeft )
+            --mGateHoldLeft;
+        else
+            mGateOpened = false;
+    }
+
+    return mGateOpened;
+}
+
+double Analyser::meanSquare( const double* samples, size_t count )
+{
+    // Independent accumulators, so that the loop vectorizes.
+    double sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+
+    size_t i = 0;
+    for(; i + 4 <= count; i += 4 )
+    {
+        sum0 += samples[ i + 0 ] * samples[ i + 0 ];
+        sum1 += samples[ i + 1 ] * samples[ i + 1 ];
+        sum2 += samples[ i + 2 ] * samples[ i + 2 ];
+        sum3 += samples[ i + 3 ] * samples[ i + 3 ];
+    }
+    for(; i < count; ++i )
+        sum0 += samples[ i ] * samples[ i ];
+
+    return 0 < count ? ( sum0 + sum1 + sum2 + sum3 ) / count : 0;
+}
+
+void Analyser::startFrame()
+{
+    // Reuse the arrays.
+    mPitches.clear();
+    mPeaks.clear();
+}
+
+void Analyser::addPitch( double freq, double mag, unsigned int bin, double confidence )
+{
+    const Peak pitch = { freq, mag, bin, confidence };
+    mPitches.push_back( pitch );
+}
+
+void Analyser::addPeak( double freq, double mag, unsigned int bin, double confidence )
+{
+    const Peak peak = { freq, mag, bin, confidence };
+    mPeaks.push_back( peak );
+}
+
+void Analyser::endFrame()
+{
+    Frame frame;
+    frame.position   = mPosition;
+    frame.rate       = sampleRate();
+    frame.captured   = mCaptured;
+    frame.delay      = groupDelay();
+    frame.pitches    = mPitches.empty() ? NULL : &mPitches[ 0 ];
+    frame.pitchCount = mPitches.size();
+    frame.peaks      = mPeaks.empty() ? NULL : &mPeaks[ 0 ];
+    frame.peakCount  = mPeaks.size();
+
+    CGT_PROFILE_STAGE( STAGE_OBSERVER );
+    CGT_PROBE3( frame, frame.position, frame.pitchCount, frame.peakCount );
+
+    // Pass it to observer.
+    observer().addFrame( frame );
+}
+
+/*************************************************************************/
+/* cgt::core::Analyser::ObserverAdapter                                  */
+/*************************************************************************/
+Analyser::ObserverAdapter::ObserverAdapter( IObserver& observer, IPitchObserver* pitchObserver )
+: mObserver( observer ),
+  mPitchObserver( pitchObserver )
+{
+}
+
+void Analyser::ObserverAdapter::addFrame( const Frame& frame )
+{
+    // Start the observer.
+    mObserver.start();
+
+    // Fundamentals go first.
+    if( NULL != mPitchObserver )
+    {
+        for( size_t i = 0; i < frame.pitchCount; ++i )
+            mPitchObserver->addPitch( frame.pitches[ i ].freq,
+                                      10 * ::log10( frame.pitches[ i ].mag ) );
+    }
+
+    // Then all the frequencies.
+    for( size_t i = 0; i < frame.peakCount; ++i )
+        mObserver.add( frame.peaks[ i ].freq, frame.peaks[ i ].mag );
+
+    // End observer.
+    mObserver.end( frame.captured );
 }
@@ -0,0 +1,156 @@
+/**
+ * @file core/AnalyserFactory.cpp
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#include "cgt-common.h"
+
+#include "core/AnalyserFactory.h"
+#include "core/CqAnalyser.h"
+#include "core/FftAnalyser.h"
+#include "core/YinAnalyser.h"
+
+using namespace cgt;
+using namespace cgt::core;
+
+/*************************************************************************/
+/* cgt::core::AnalyserFactory::Parameters                                */
+/*************************************************************************/
+class AnalyserFactory::Parameters
+: public Analyser::Change
+{
+public:
+    Parameters( Analyser& analyser, const config::Settings& settings )
+      // Find out what it is here, not between hops.
+    : mFft( dynamic_cast< FftAnalyser* >( &analyser ) ),
+      mYin( dynamic_cast< YinAnalyser* >( &analyser ) ),
+      mCq( dynamic_cast< CqAnalyser* >( &analyser ) ),
+      mSettings( settings )
+    {
+    }
+
+    void apply( Analyser& analyser )
+    {
+        if( NULL != mFft )
+        {
+            mFft->setMagnitudeCutoff( mSettings.fftMagnitudeCutoff );
+            mFft->setFloorMargin( mSettings.fftFloorMargin );
+            mFft->setFloorRise( mSettings.fftFloorRise );
+            mFft->setFloorSmoothing( mSettings.fftFloorSmoothing );
+            mFft->setMaxPeaks( mSettings.fftMaxPeaks );
+        }
+        if( NULL != mYin )
+        {
+            mYin->setThreshold( mSettings.yinThreshold );
+            mYin->setMagnitudeCutoff( mSettings.fftMagnitudeCutoff );
+        }
+        if( NULL != mCq )
+            mCq->setMagnitudeCutoff( mSettings.fftMagnitudeCutoff );
+
+        // Skip the silence
+        analyser.setGateThreshold( mSettings.gateThreshold );
+        analyser.setGateHold( mSettings.gateHold );
+    }
+
+protected:
+    /// The analyser if it's FFT.
+    FftAnalyser* mFft;
+    /// The analyser if it's YIN.
+    YinAnalyser* mYin;
+    /// The analyser if it's constant-Q.
+    CqAnalyser*  mCq;
+
+    /// The settings to apply, copied.
+    const config::Settings mSettings;
+};
+
+/*************************************************************************/
+/* cgt::core::AnalyserFactory                                            */
+/*************************************************************************/
+AnalyserFactory::AnalyserFactory( const config::Settings& settings )
+: mSettings( settings )
+{
+}
+
+Analyser* AnalyserFactory::create( Analyser::IFrameObserver& observer ) const
+{
+    std::auto_ptr< Analyser > analyser;
+
+    // Pick the requested analyser
+    const std::string& type = mSettings.analyser;
+    if( "fft" == type )
+    {
+        FftAnalyser* fft = new FftAnalyser(
+            observer, mSettings.fftMagnitudeCutoff,
+            mSettings.fftFloorMargin, mSettings.fftFloorRise,
+            mSettings.fftFloorSmoothing );
+        analyser.reset( fft );
+
+        fft->setPitchHarmonics( mSettings.fftPitchHarmonics );
+    }
+    else if( "yin" == type )
+        analyser.reset( new YinAnalyser(
+            observer, mSettings.yinThreshold,
+            mSettings.fftMagnitudeCutoff ) );
+    else if( "cq" == type )
+        analyser.reset( new CqAnalyser(
+            observer, mSettings.cqMinFreq,
+            mSettings.cqMaxFreq,
+            mSettings.cqBinsPerOctave,
+            mSettings.fftMagnitudeCutoff ) );
+    else
+        throw except::InvalidArgument(
+            ::ssprintf( "Unknown analyser '%s'", type.c_str() ) );
+
+    // Nothing runs yet, set the rest right away.
+    Parameters( *analyser, mSettings ).apply( *analyser );
+
+    return analyser.release();
+}
+
+void AnalyserFactory::reconfigure( Analyser& analyser, const config::Settings& previous ) const
+{
+    // Check everything before preparing anything.
+    const char* fixed = NULL;
+    if( previous.analyser != mSettings.analyser )
+        fixed = "cgt.analyser";
+    else if( previous.pcmRate != mSettings.pcmRate )
+        fixed = "cgt.pcm.rate";
+    else if( previous.fftPitchHarmonics != mSettings.fftPitchHarmonics )
+        fixed = "cgt.fft.pitchHarmonics";
+    else if( previous.cqMinFreq != mSettings.cqMinFreq
+             || previous.cqMaxFreq != mSettings.cqMaxFreq
+             || previous.cqBinsPerOctave != mSettings.cqBinsPerOctave )
+        fixed = "cgt.cq";
+
+    if( NULL != fixed )
+        throw except::InvalidArgument(
+            ::ssprintf( "Can't change '%s' while running", fixed ) );
+
+    // Prepare whatever may fail first ...
+    std::auto_ptr< Analyser::Change > size, pcm;
+
+    // New buffers and plans only if the size changes.
+    if( mSettings.bufferSize != analyser.bufferSize() )
+        size.reset( analyser.prepareResize( mSettings.bufferSize, mSettings.captureSize ) );
+    else if( mSettings.captureSize != analyser.captureSize() )
+        size.reset( analyser.prepareCaptureSize( mSettings.captureSize ) );
+
+    if( previous.pcmDevice != mSettings.pcmDevice )
+        pcm.reset( analyser.prepareReopen( mSettings.pcmDevice.c_str() ) );
+
+    // The cheap ones all at once.
+    std::auto_ptr< Analyser::Change > parameters( new Parameters( analyser, mSettings ) );
+
+    // ... and post it all only once nothing else can.
+    if( NULL != size.get() )
+        analyser.post( size.release() );
+    if( NULL != pcm.get() )
+        analyser.post( pcm.release() );
+
+    analyser.post( parameters.release() );
+}
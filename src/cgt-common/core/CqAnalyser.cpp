@@ -0,0 +1,313 @@
+/**
+ * @file core/CqAnalyser.cpp
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#include "cgt-common.h"
+
+#include "core/CqAnalyser.h"
+#include "core/FftCache.h"
+
+using namespace cgt;
+using namespace cgt::core;
+
+/*************************************************************************/
+/* cgt::core::CqAnalyser                                                 */
+/*************************************************************************/
+const double CqAnalyser::KERNEL_THRESHOLD = 0.0054;
+
+CqAnalyser::CqAnalyser( IFrameObserver& observer, double minFreq, double maxFreq,
+                        unsigned int binsPerOctave, double magCutoff )
+: core::Analyser( observer ),
+  mPlan( NULL ),
+  mMinFreq( minFreq ),
+  mMaxFreq( maxFreq ),
+  mBinsPerOctave( binsPerOctave ),
+  mMagnitudeCutoff( magCutoff ),
+  mBinCount( 0 ),
+  mFftOutput( NULL ),
+  mMagnitudes( NULL ),
+  mKernelStart( NULL ),
+  mKernelIndex( NULL ),
+  mKernelReal( NULL ),
+  mKernelImag( NULL )
+{
+    // Make sure the range is valid.
+    if( !( 0 < minFreq && minFreq < maxFreq ) || 0 == binsPerOctave )
+        throw except::InvalidArgument(
+            ::ssprintf( "Invalid constant-Q range (%f-%f Hz, %u bins per octave)",
+                        minFreq, maxFreq, binsPerOctave ) );
+}
+
+CqAnalyser::~CqAnalyser()
+{
+    // Free our resources, parent won't call us.
+    free();
+}
+
+void CqAnalyser::init( unsigned int rate, unsigned int bufferSize,
+                       unsigned int captureSize )
+{
+    // Initialize parent first.
+    Analyser::init( rate, bufferSize, captureSize );
+
+    // Stay safely below Nyquist frequency.
+    const double maxFreq = std::min( mMaxFreq, 0.45 * sampleRate() );
+    if( maxFreq <= mMinFreq )
+        throw except::InvalidArgument(
+            ::ssprintf( "Constant-Q range empty at %u Hz", rate ) );
+
+    mBinCount = 1 + size_t( mBinsPerOctave * ::log2( maxFreq / mMinFreq ) );
+
+    // Allocate the arrays.
+    mFftOutput  = (double*)::fftw_malloc( sizeof( double ) * this->bufferSize() );
+    mMagnitudes = new double[ binCount() ];
+
+    // Every bin may turn out a peak.
+    mPeaks.reserve( binCount() );
+
+    // Share the plan with analysers of the same size.
+    mPlan = sFftCache.plan( this->bufferSize(), FFTW_R2HC, FFTW_MEASURE );
+
+    // Precompute the kernel.
+    initKernel();
+}
+
+void CqAnalyser::free()
+{
+    // The plan is shared, just drop it.
+    mPlan = NULL;
+    util::safeRelease( mFftOutput, ::fftw_free );
+
+    util::safeDeleteArray( mMagnitudes );
+
+    util::safeDeleteArray( mKernelStart );
+    util::safeDeleteArray( mKernelIndex );
+    util::safeDeleteArray( mKernelReal );
+    util::safeDeleteArray( mKernelImag );
+
+    mBinCount = 0;
+
+    // Let the parent free too.
+    Analyser::free();
+}
+
+unsigned int CqAnalyser::groupDelay() const
+{
+    const double q      = 1.0 / ( ::pow( 2, 1.0 / mBinsPerOctave ) - 1 );
+    const size_t length = std::min< size_t >( bufferSize(), ::ceil( q * sampleRate() / binFrequency( 0 ) ) );
+
+    return 0 < length ? ( length - 1 ) / 2 : 0;
+}
+
+void CqAnalyser::analyse()
+{
+    {
+        CGT_PROFILE_STAGE( STAGE_TRANSFORM );
+
+        // Execute the plan
+        ::fftw_execute_r2r( mPlan, mSamples, mFftOutput );
+    }
+
+    // Process the bins
+    processKernel();
+    processOutput();
+}
+
+Analyser* CqAnalyser::createTwin() const
+{
+    return new CqAnalyser( observer(), mMinFreq, mMaxFreq,
+                           mBinsPerOctave, magnitudeCutoff() );
+}
+
+void CqAnalyser::adopt( Analyser& twin )
+{
+    CqAnalyser& other = static_cast< CqAnalyser& >( twin );
+
+    std::swap( mPlan,        other.mPlan );
+    std::swap( mBinCount,    other.mBinCount );
+    std::swap( mFftOutput,   other.mFftOutput );
+    std::swap( mMagnitudes,  other.mMagnitudes );
+    std::swap( mKernelStart, other.mKernelStart );
+    std::swap( mKernelIndex, other.mKernelIndex );
+    std::swap( mKernelReal,  other.mKernelReal );
+    std::swap( mKernelImag,  other.mKernelImag );
+
+    // Let the parent swap too.
+    Analyser::adopt( twin );
+}
+
+double CqAnalyser::binFrequency( double bin ) const
+{
+    return mMinFreq * ::pow( 2, bin / mBinsPerOctave );
+}
+
+void CqAnalyser::initKernel()
+{
+    const size_t size = bufferSize();
+
+    // Quality factor given by the bin spacing.
+    const double q = 1.0 / ( ::pow( 2, 1.0 / mBinsPerOctave ) - 1 );
+
+    // Temporal kernels and their spectra.
+    double* real     = (double*)::fftw_malloc( sizeof( double ) * size );
+    double* img      = (double*)::fftw_malloc( sizeof( double ) * size );
+    double* realSpec = (double*)::fftw_malloc( sizeof( double ) * size );
+    double* imgSpec  = (double*)::fftw_malloc( sizeof( double ) * size );
+    // The window of the current kernel.
+    std::vector< double > hamming( size );
+
+    // Used only here, no need to measure.
+    fftw_plan plan = sFftCache.plan( size, FFTW_R2HC, FFTW_ESTIMATE );
+
+    // The sparse kernel, in growable form.
+    std::vector< size_t >       start;
+    std::vector< unsigned int > index;
+    std::vector< double >       kernelReal;
+    std::vector< double >       kernelImag;
+
+    for( size_t bin = 0; bin < binCount(); ++bin )
+    {
+        const double freq = binFrequency( bin );
+
+        // Long enough for the Q, but no longer than the buffer.
+        const size_t length = std::min< size_t >( size, ::ceil( q * sampleRate() / freq ) );
+        // Align to the end, so that the newest samples are used.
+        const size_t offset = size - length;
+
+        ::memset( real, 0, sizeof( double ) * size );
+        ::memset( img,  0, sizeof( double ) * size );
+
+        // A single sample is all the window there is.
+        for( size_t n = 0; n < length; ++n )
+            hamming[ n ] = 1 < length ? 0.54 - 0.46 * ::cos( 2 * M_PI * n / ( length - 1 ) ) : 1;
+
+        // Sum of the window, for normalization.
+        const double sum = std::accumulate( hamming.begin(), hamming.begin() + length, 0.0 );
+
+        // Hamming-windowed complex exponential.
+        for( size_t n = 0; n < length; ++n )
+        {
+            const double window = hamming[ n ] / sum;
+            const double phase  = 2 * M_PI * freq * n / sampleRate();
+
+            real[ offset + n ] = window * ::cos( phase );
+            img[ offset + n ]  = window * ::sin( phase );
+        }
+
+        ::fftw_execute_r2r( plan, real, realSpec );
+        ::fftw_execute_r2r( plan, img,  imgSpec );
+
+        start.push_back( index.size() );
+
+        // Combine the two halfcomplex spectra, ignoring DC and Nyquist.
+        for( size_t j = 1; j < ( size + 1 ) / 2; ++j )
+        {
+            const double kr = realSpec[ j ] - imgSpec[ size - j ];
+            const double ki = realSpec[ size - j ] + imgSpec[ j ];
+
+            // Keep only significant entries.
+            if( KERNEL_THRESHOLD < ::sqrt( kr * kr + ki * ki ) )
+            {
+                index.push_back( j );
+                kernelReal.push_back( kr / size );
+                kernelImag.push_back( ki / size );
+            }
+        }
+    }
+
+    start.push_back( index.size() );
+
+    // Release the temporaries.
+    ::fftw_free( real );
+    ::fftw_free( img );
+    ::fftw_free( realSpec );
+    ::fftw_free( imgSpec );
+
+    // Store the kernel in compact arrays.
+    mKernelStart = new size_t[ start.size() ];
+    mKernelIndex = new unsigned int[ index.size() ];
+    mKernelReal  = new double[ kernelReal.size() ];
+    mKernelImag  = new double[ kernelImag.size() ];
+
+    std::copy( start.begin(),      start.end(),      mKernelStart );
+    std::copy( index.begin(),      index.end(),      mKernelIndex );
+    std::copy( kernelReal.begin(), kernelReal.end(), mKernelReal );
+    std::copy( kernelImag.begin(), kernelImag.end(), mKernelImag );
+}
+
+void CqAnalyser::processKernel()
+{
+    CGT_PROFILE_STAGE( STAGE_PROCESS );
+
+    const size_t size = bufferSize();
+
+    for( size_t bin = 0; bin < binCount(); ++bin )
+    {
+        double real = 0;
+        double img  = 0;
+
+        // Multiply the spectrum by the conjugated kernel.
+        for( size_t e = mKernelStart[ bin ]; e < mKernelStart[ bin + 1 ]; ++e )
+        {
+            const double xr = mFftOutput[ mKernelIndex[ e ] ];
+            const double xi = mFftOutput[ size - mKernelIndex[ e ] ];
+
+            real += xr * mKernelReal[ e ] + xi * mKernelImag[ e ];
+            img  += xi * mKernelReal[ e ] - xr * mKernelImag[ e ];
+        }
+
+        mMagnitudes[ bin ] = ::sqrt( real * real + img * img );
+    }
+}
+
+void CqAnalyser::processOutput()
+{
+    CGT_PROFILE_STAGE( STAGE_OUTPUT );
+
+    const size_t count = binCount();
+
+    // Convert the cutoff to plain magnitude.
+    const double cutoff = ::pow( 10, magnitudeCutoff() / 10 );
+
+    // Start a new frame.
+    startFrame();
+
+    // Find local maxes.
+    for( size_t bin = 0; bin < count; ++bin )
+    {
+        const double mag = mMagnitudes[ bin ];
+
+        // Check if the magnitude is large enough.
+        if( mag < cutoff )
+            continue;
+        // Check the neighbours.
+        if( ( 0 < bin && mag <= mMagnitudes[ bin - 1 ] )
+            || ( bin + 1 < count && mag < mMagnitudes[ bin + 1 ] ) )
+            continue;
+
+        // Refine the bin by parabolic interpolation of log-magnitudes.
+        double shift = 0;
+        if( 0 < bin && bin + 1 < count
+            && 0 < mMagnitudes[ bin - 1 ] && 0 < mMagnitudes[ bin + 1 ] )
+        {
+            const double prev = ::log( mMagnitudes[ bin - 1 ] );
+            const double cur  = ::log( mag );
+            const double next = ::log( mMagnitudes[ bin + 1 ] );
+
+            const double den = prev - 2 * cur + next;
+            if( 0 > den )
+                shift = 0.5 * ( prev - next ) / den;
+        }
+
+        // Add it to the frame
+        addPeak( binFrequency( bin + shift ), mag, bin, 1 );
+    }
+
+    // Pass it to observer.
+    endFrame();
+}
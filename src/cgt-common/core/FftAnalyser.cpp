@@ -10,6 +10,8 @@
 #include "cgt-common.h"
 
 #include "core/FftAnalyser.h"
+#include "core/FftCache.h"
+#include "core/Probes.h"
 #include "util/Misc.h"
 
 using namespace cgt;
@@ -18,134 +20,314 @@ using namespace cgt::core;
 /*************************************************************************/
 /* cgt::core::FftAnalyser                                                */
 /*************************************************************************/
-FftAnalyser::FftAnalyser( IObserver& observer, double magCutoff )
+const double FftAnalyser::MIN_FLOOR = 1e-12;
+
+const unsigned int FftAnalyser::AVERAGE_LIMIT = 64;
+
+FftAnalyser::FftAnalyser( IFrameObserver& observer, double magCutoff,
+                          double floorMargin, double floorRise,
+                          double floorSmoothing )
 : core::Analyser( observer ),
   mPlan( NULL ),
   mMagnitudeCutoff( magCutoff ),
+  mFloorMargin( floorMargin ),
+  mFloorRise( floorRise ),
+  mFloorSmoothing( floorSmoothing ),
+  mPitchHarmonics( 0 ),
+  mMaxPeaks( 0 ),
+  mPitch( NULL ),
   mFftOutput( NULL ),
-  mFreqs( NULL )
+  mMagnitudes( NULL ),
+  mSmoothed( NULL ),
+  mFloors( NULL ),
+  mAngles( NULL ),
+  mAngleValid( NULL ),
+  mAdvances( NULL ),
+  mAdvanceSums( NULL ),
+  mAdvanceCounts( NULL ),
+  mCompound( NULL ),
+  mPeaks( NULL ),
+  mPeakCount( 0 ),
+  mRelockStart( 0 ),
+  mRelocking( false ),
+  mRelockTime( 0 )
+{
+}
+
+FftAnalyser::~FftAnalyser()
 {
+    // Free our resources, parent won't call us.
+    free();
 }
 
-void FftAnalyser::init( const char* name, unsigned int rate,
-                        unsigned int bufferSize, unsigned int captureSize )
+void FftAnalyser::init( unsigned int rate, unsigned int bufferSize,
+                        unsigned int captureSize )
 {
     // Initialize parent first.
-    Analyser::init( name, rate, bufferSize, captureSize );
+    Analyser::init( rate, bufferSize, captureSize );
 
     // Allocate the array for frequencies.
     mFftOutput = (double*)::fftw_malloc( sizeof( double ) * this->bufferSize() );
 
-    // We ignore DC and Nyqist frequency.
-    mFreqs = new Frequency[ frequencyCount() ];
+    // Magnitudes include DC, so that bins map directly.
+    mMagnitudes = util::safeAllocArray< double >( frequencyCount() + 1 );
+    // Floors start high, so that they fall to the first magnitude.
+    mFloors = new double[ frequencyCount() ];
+    std::fill( mFloors, mFloors + frequencyCount(), HUGE_VAL );
+    mSmoothed = util::safeAllocArray< double >( frequencyCount() );
+    // Phase state starts empty, the rings are valid only up to the counts.
+    mAngles        = new double[ frequencyCount() ];
+    mAngleValid    = util::safeAllocArray< bool >( frequencyCount() );
+    mAdvances      = new double[ frequencyCount() * AVERAGE_LIMIT ];
+    mAdvanceSums   = util::safeAllocArray< double >( frequencyCount() );
+    mAdvanceCounts = util::safeAllocArray< unsigned int >( frequencyCount() );
+    // Compound magnitudes have a sentinel at each end.
+    mCompound = util::safeAllocArray< double >( frequencyCount() + 2 );
+    mCompound[ 0 ] = mCompound[ frequencyCount() + 1 ] = -1;
+    // Picking the maxes writes one past the last one.
+    mPeaks = new size_t[ frequencyCount() + 1 ];
+
+    // Setup the pitch detector if requested.
+    if( 0 < pitchHarmonics() )
+    {
+        mPitch = new HarmonicProduct( pitchHarmonics() );
+        mPitch->init( frequencyCount() + 1,
+                      double( sampleRate() ) / this->bufferSize() );
+    }
 
-    // Setup the plan.
-    mPlan = ::fftw_plan_r2r_1d( this->bufferSize(), mSamples, mFftOutput,
-                                FFTW_R2HC, FFTW_MEASURE );
-    // Check for error
-    if( NULL == mPlan )
-        throw except::RuntimeError( "Failed to prepare FFTW plan" );
+    // Share the plan with analysers of the same size.
+    mPlan = sFftCache.plan( this->bufferSize(), FFTW_R2HC, FFTW_MEASURE );
 }
 
 void FftAnalyser::free()
 {
-    // Release the plan.
-    util::safeRelease( mPlan,      ::fftw_destroy_plan );
+    // The plan is shared, just drop it.
+    mPlan = NULL;
     util::safeRelease( mFftOutput, ::fftw_free );
 
-    util::safeDeleteArray( mFreqs );
+    util::safeDeleteArray( mMagnitudes );
+    util::safeDeleteArray( mFloors );
+    util::safeDeleteArray( mSmoothed );
+    util::safeDeleteArray( mAngles );
+    util::safeDeleteArray( mAngleValid );
+    util::safeDeleteArray( mAdvances );
+    util::safeDeleteArray( mAdvanceSums );
+    util::safeDeleteArray( mAdvanceCounts );
+    util::safeDeleteArray( mCompound );
+    util::safeDeleteArray( mPeaks );
+    mPeakCount = 0;
+
+    util::safeDelete( mPitch );
+
+    mRelocking  = false;
+    mRelockTime = 0;
 
     // Let the parent free too.
     Analyser::free();
 }
 
-void FftAnalyser::step()
+void FftAnalyser::analyse()
 {
-    // Let parent process first
-    Analyser::step();
+    {
+        CGT_PROFILE_STAGE( STAGE_TRANSFORM );
 
-    // Execute the plan
-    ::fftw_execute( mPlan );
+        // Execute the plan
+        CGT_PROBE1( fft__transform__start, bufferSize() );
+        ::fftw_execute_r2r( mPlan, mSamples, mFftOutput );
+        CGT_PROBE( fft__transform__end );
+    }
 
     // Process the frequencies
+    CGT_PROBE( fft__freqs__start );
     processFreqs();
+    CGT_PROBE( fft__freqs__end );
+
+    CGT_PROBE( fft__output__start );
     processOutput();
+    CGT_PROBE( fft__output__end );
+}
+
+void FftAnalyser::relock()
+{
+    // Phases are stale, track from scratch.
+    resetPhases();
+    startRelock();
+}
+
+void FftAnalyser::gap()
+{
+    // The advances span the lost samples, track from scratch.
+    resetPhases();
+    startRelock();
+}
+
+Analyser* FftAnalyser::createTwin() const
+{
+    std::auto_ptr< FftAnalyser > twin( new FftAnalyser(
+        observer(), magnitudeCutoff(), floorMargin(), floorRise(),
+        floorSmoothing() ) );
+    twin->setPitchHarmonics( pitchHarmonics() );
+    twin->setMaxPeaks( maxPeaks() );
+
+    return twin.release();
+}
+
+void FftAnalyser::adopt( Analyser& twin )
+{
+    FftAnalyser& other = static_cast< FftAnalyser& >( twin );
+
+    std::swap( mPlan,          other.mPlan );
+    std::swap( mPitch,         other.mPitch );
+    std::swap( mFftOutput,     other.mFftOutput );
+    std::swap( mMagnitudes,    other.mMagnitudes );
+    std::swap( mSmoothed,      other.mSmoothed );
+    std::swap( mFloors,        other.mFloors );
+    std::swap( mAngles,        other.mAngles );
+    std::swap( mAngleValid,    other.mAngleValid );
+    std::swap( mAdvances,      other.mAdvances );
+    std::swap( mAdvanceSums,   other.mAdvanceSums );
+    std::swap( mAdvanceCounts, other.mAdvanceCounts );
+    std::swap( mCompound,      other.mCompound );
+    std::swap( mPeaks,         other.mPeaks );
+    mPeakCount = 0;
+
+    // Let the parent swap too.
+    Analyser::adopt( twin );
+
+    // The bins are different, the new state is fresh.
+    startRelock();
+}
+
+void FftAnalyser::rehop( unsigned int previous )
+{
+    // The angles are scaled by the hop.
+    const double scale = double( previous ) / captureSize();
+    for( size_t index = 0; index < frequencyCount(); ++index )
+        mAngles[ index ] *= scale;
 }
 
 void FftAnalyser::reset()
 {
-    // TODO: reset all angles.
+    // Refill the buffer.
+    Analyser::reset();
+
+    // Drop everything we know about the frequencies.
+    resetPhases();
+
+    ::memset( mSmoothed, 0, sizeof( double ) * frequencyCount() );
+    std::fill( mFloors, mFloors + frequencyCount(), HUGE_VAL );
+
+    startRelock();
+}
+
+double FftAnalyser::offset( size_t index ) const
+{
+    return mAdvanceSums[ index ]
+        / std::min( mAdvanceCounts[ index ], AVERAGE_LIMIT );
 }
 
 double FftAnalyser::compoundMagnitude( size_t index )
 {
-    Frequency& cur = frequency( index );
+    const double curMag = magnitude( index );
 
-    if( !cur.ready() )
-        return cur.magnitude();
+    if( !ready( index ) )
+        return curMag;
 
     // Ignore DC and Nyquist frequency.
     const size_t size = frequencyCount();
     // Obtain cur frequency
-    double curFreq = cur.frequency();
+    double curFreq = offset( index );
 
     if( 0 == index )
     {
         if( 0 > curFreq )
-            return cur.magnitude();
+            return curMag;
         else
-            return ( 1 - curFreq ) * cur.magnitude()
-                + curFreq * frequency( 1 ).magnitude();
+            return ( 1 - curFreq ) * curMag
+                + curFreq * magnitude( 1 );
     }
     else if( index == size - 1 )
     {
         if( 0 > curFreq )
-            return ( 1 + curFreq ) * cur.magnitude()
-                - curFreq * frequency( size - 2 ).magnitude();
+            return ( 1 + curFreq ) * curMag
+                - curFreq * magnitude( size - 2 );
         else
-            return cur.magnitude();
+            return curMag;
     }
     else
     {
         if( 0 > curFreq )
-            return ( 1 + curFreq ) * cur.magnitude()
-                - curFreq * frequency( index - 1 ).magnitude();
+            return ( 1 + curFreq ) * curMag
+                - curFreq * magnitude( index - 1 );
         else
-            return ( 1 - curFreq ) * cur.magnitude()
-                + curFreq * frequency( index + 1 ).magnitude();
+            return ( 1 - curFreq ) * curMag
+                + curFreq * magnitude( index + 1 );
     }
 }
 
-bool FftAnalyser::checkFrequency( size_t indexCur, size_t indexOther )
+void FftAnalyser::addFrequency( size_t index )
 {
-    // Obtain the frequencies
-    Frequency& cur   = frequency( indexCur );
-    Frequency& other = frequency( indexOther );
+    // Add it to the frame
+    addPeak( ( index + offset( index ) + 1 )
+             * sampleRate() / bufferSize(),
+             magnitude( index ), index + 1, 1 );
+}
 
-    // Check readiness of cur
-    if( !cur.ready() )
-        return false;
-    // Check readiness of other
-    else if( !other.ready() )
-        return true;
-    // Compare by compound magnitudes
-    else
-        return compoundMagnitude( indexOther ) < compoundMagnitude( indexCur );
+void FftAnalyser::updatePhase( size_t index, double angle )
+{
+    // Nothing to compare with yet.
+    if( !mAngleValid[ index ] )
+    {
+        mAngles[ index ]     = angle;
+        mAngleValid[ index ] = true;
+        return;
+    }
+
+    // The advance since the last hop.
+    const double advance = util::normalize( angle - mAngles[ index ], 1.0 );
+    mAngles[ index ] = angle;
+
+    unsigned int& count = mAdvanceCounts[ index ];
+    double&       slot  = mAdvances[ index * AVERAGE_LIMIT + count % AVERAGE_LIMIT ];
+
+    // Replace the oldest one once the ring is full.
+    mAdvanceSums[ index ] += advance;
+    if( AVERAGE_LIMIT <= count )
+        mAdvanceSums[ index ] -= slot;
+    slot = advance;
+
+    // Keep the count bounded without moving in the ring.
+    if( 2 * AVERAGE_LIMIT <= ++count )
+        count -= AVERAGE_LIMIT;
 }
 
-void FftAnalyser::addFrequency( size_t index )
+void FftAnalyser::resetPhase( size_t index )
 {
-    // Obtain the frequency
-    Frequency& freq = frequency( index );
+    mAngleValid[ index ]    = false;
+    mAdvanceSums[ index ]   = 0;
+    mAdvanceCounts[ index ] = 0;
+}
+
+void FftAnalyser::resetPhases()
+{
+    const size_t size = frequencyCount();
 
-    // Pass it to observer
-    observer().add( ( index + freq.frequency() + 1 )
-                    * sampleRate() / bufferSize(),
-                    freq.magnitude() );
+    // The rings are valid only up to the counts.
+    ::memset( mAngleValid,    0, sizeof( bool )         * size );
+    ::memset( mAdvanceSums,   0, sizeof( double )       * size );
+    ::memset( mAdvanceCounts, 0, sizeof( unsigned int ) * size );
+}
+
+void FftAnalyser::startRelock()
+{
+    mRelockStart = mPosition;
+    mRelocking   = true;
 }
 
 void FftAnalyser::processFreqs()
 {
+    CGT_PROFILE_STAGE( STAGE_PROCESS );
+
     // Ignore DC and Nyquist frequency.
     const size_t size = frequencyCount();
 
@@ -154,92 +336,138 @@ void FftAnalyser::processFreqs()
     const double scaleAng = 1.0 / ( 2 * M_PI )
                             * bufferSize() / captureSize();
 
+    // Compare in plain magnitudes, not dB.
+    const double cutoff = ::pow( 10, magnitudeCutoff() / 10 );
+    const double margin = ::pow( 10, floorMargin() / 10 );
+    // Rise of the floors per step.
+    const double hop    = double( captureSize() ) / sampleRate();
+    const double rise   = ::pow( 10, floorRise() * hop / 10 );
+    // Weight of the history when smoothing, per step.
+    const double keep   = 0 < floorSmoothing() ? ::exp( -hop / floorSmoothing() ) : 0;
+
     // Compute magnitude for each frequency.
     for( size_t index = 0; index < size; ++index )
     {
-        Frequency& freq = frequency( index );
-
         // Obtain FFT output.
         double real = scaleMag * mFftOutput[ index + 1 ];
         double img  = scaleMag * mFftOutput[ mBufferSize - index - 1 ];
 
         // Update the magnitude.
-        freq.updateMagnitude( real, img );
+        const double mag = ::sqrt( real * real + img * img );
+        mMagnitudes[ index + 1 ] = mag;
+
+        // Smooth the magnitude first, so that the floor isn't biased by dips.
+        double& smooth = mSmoothed[ index ];
+        smooth = 0 < smooth ? keep * smooth + ( 1 - keep ) * mag : mag;
+
+        // Fall at once, rise slowly; not at all under a tracked
+        // frequency, or a held note would sink into its own floor.
+        double& noise = mFloors[ index ];
+        const bool tracked = cutoff <= mag && noise * margin <= mag;
+        noise = std::min( smooth, tracked ? noise : std::max( noise * rise, MIN_FLOOR ) );
 
         // Check if the magnitude is large enough.
-        if( magnitudeCutoff() <= 10 * ::log10( freq.magnitude() ) )
+        if( cutoff <= mag && noise * margin <= mag )
             // Update the angle.
-            freq.updateFrequency( scaleAng * ::atan2( img, real ) );
+            updatePhase( index, scaleAng * ::atan2( img, real ) );
+        // Doesn't fulfill the requirements, reset.
         else
-            // Doesn't fulfill the requirements.
-            freq.reset();
+            resetPhase( index );
     }
 }
 
-void FftAnalyser::processOutput()
+void FftAnalyser::processCompound()
 {
     // Ignore DC and Nyquist frequency.
     const size_t size = frequencyCount();
 
-    // Start the observer.
-    observer().start();
+    // Skip the leading sentinel.
+    double* compound = mCompound + 1;
 
-    // Handle special case of first frequency.
-    {
-        if( checkFrequency( 0, 1 ) )
-            addFrequency( 0 );
-    }
+    // Frequencies not ready lose against everything.
+    for( size_t index = 0; index < size; ++index )
+        compound[ index ] = ready( index ) ? compoundMagnitude( index ) : -1;
+}
+
+void FftAnalyser::processPeaks()
+{
+    // Ignore DC and Nyquist frequency.
+    const size_t size = frequencyCount();
+
+    // Skip the leading sentinel.
+    const double* compound = mCompound + 1;
 
-    // Find local maxes.
-    for( size_t index = 1; index < ( size - 1 ); ++index )
+    // Find local maxes, sentinels handle both ends.
+    size_t count = 0;
+    for( size_t index = 0; index < size; ++index )
     {
-        if( checkFrequency( index, index - 1 ) && checkFrequency( index, index + 1 ) )
-            addFrequency( index );
+        const double cur = compound[ index ];
+
+        mPeaks[ count ] = index;
+        count += ( 0 <= cur ) & ( compound[ index - 1 ] < cur ) & ( compound[ index + 1 ] < cur );
     }
 
-    // Handle special case of last frequency.
+    // Keep only the strongest ones, in the original order.
+    if( 0 < maxPeaks() && maxPeaks() < count )
     {
-        if( checkFrequency( size - 1, size - 2 ) )
-            addFrequency( size - 1 );
+        std::nth_element( mPeaks, mPeaks + maxPeaks(), mPeaks + count,
+                          CompareCompound( compound ) );
+
+        count = maxPeaks();
+        std::sort( mPeaks, mPeaks + count );
     }
 
-    // End observer.
-    observer().end();
+    mPeakCount = count;
 }
 
-/*************************************************************************/
-/* core::FftAnalyser::Frequency                                          */
-/*************************************************************************/
-FftAnalyser::Frequency::Frequency( unsigned int limit )
-: mMagnitude( 0 ),
-  mCounter( new stats::Derivative< double, double >(
-                new stats::Periodic< double, double >(
-                    new stats::AverageRing< double, double >( limit ),
-                    1.0 ) ) )
+void FftAnalyser::processOutput()
 {
-}
+    CGT_PROFILE_STAGE( STAGE_OUTPUT );
 
-FftAnalyser::Frequency::~Frequency()
-{
-    util::safeDelete( mCounter );
-}
+    // Start a new frame.
+    startFrame();
 
-bool FftAnalyser::Frequency::ready() const
-{
-    return mCounter->ready();
-}
+    // Estimate the fundamental first.
+    processPitch();
 
-double FftAnalyser::Frequency::frequency() const
-{
-    return mCounter->result();
-}
+    // Pick the frequencies.
+    processCompound();
+    processPeaks();
 
-void FftAnalyser::Frequency::updateFrequency( double angle )
-{
-    mCounter->add( angle );
+    // Add them to the frame.
+    for( size_t i = 0; i < mPeakCount; ++i )
+        addFrequency( mPeaks[ i ] );
+
+    // Measure how long it took to lock again.
+    if( mRelocking && 0 < mPeakCount )
+    {
+        mRelockTime = double( mPosition - mRelockStart ) / sampleRate();
+        mRelocking  = false;
+    }
+
+    // Pass it to observer.
+    endFrame();
 }
 
-void FftAnalyser::Frequency::reset()
+void FftAnalyser::processPitch()
 {
-    mCounter->reset();
+    // Check if pitch detection is enabled at all.
+    if( NULL == mPitch )
+        return;
+
+    // Run the detector.
+    if( !mPitch->process( mMagnitudes ) )
+        return;
+    // Check if the estimate is strong enough.
+    if( magnitudeCutoff() > mPitch->salience() )
+        return;
+
+    // Refine the bin using its phase, if possible.
+    const size_t index = mPitch->bin() - 1;
+
+    const double shift = ready( index ) ? offset( index ) : 0;
+
+    // Add it to the frame, salience is in dB.
+    addPitch( ( index + shift + 1 ) * sampleRate() / bufferSize(),
+              ::pow( 10, mPitch->salience() / 10 ), mPitch->bin(), 1 );
 }
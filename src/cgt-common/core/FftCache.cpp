@@ -0,0 +1,105 @@
+/**
+ * @file core/FftCache.cpp
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#include "cgt-common.h"
+
+#include "core/FftCache.h"
+
+using namespace cgt;
+using namespace cgt::core;
+
+/*************************************************************************/
+/* cgt::core::FftCache                                                   */
+/*************************************************************************/
+std::auto_ptr< FftCache > FftCache::mInstance( NULL );
+pthread_once_t            FftCache::mInstanceOnce = PTHREAD_ONCE_INIT;
+
+FftCache& FftCache::get()
+{
+    ::pthread_once( &mInstanceOnce, &FftCache::create );
+    return *mInstance;
+}
+
+FftCache::FftCache()
+{
+    ::pthread_mutex_init( &mMutex, NULL );
+}
+
+FftCache::~FftCache()
+{
+    // Destroy the plans.
+    std::map< PlanKey, fftw_plan >::iterator curPlan, endPlan;
+    curPlan = mPlans.begin();
+    endPlan = mPlans.end();
+    for(; curPlan != endPlan; ++curPlan )
+        ::fftw_destroy_plan( curPlan->second );
+
+    ::pthread_mutex_destroy( &mMutex );
+}
+
+fftw_plan FftCache::plan( size_t size, fftw_r2r_kind kind,
+                          unsigned int flags, bool inPlace )
+{
+    const PlanKey key = { size, kind, flags, inPlace };
+
+    ::pthread_mutex_lock( &mMutex );
+
+    // Made already?
+    std::map< PlanKey, fftw_plan >::iterator itr = mPlans.find( key );
+    if( mPlans.end() != itr )
+    {
+        fftw_plan plan = itr->second;
+        ::pthread_mutex_unlock( &mMutex );
+
+        return plan;
+    }
+
+    // Plan on scratch arrays, measuring overwrites them.
+    double* in  = (double*)::fftw_malloc( sizeof( double ) * size );
+    double* out = inPlace ? in : (double*)::fftw_malloc( sizeof( double ) * size );
+
+    fftw_plan plan = ::fftw_plan_r2r_1d( size, in, out, kind, flags );
+
+    if( out != in )
+        ::fftw_free( out );
+    ::fftw_free( in );
+
+    if( NULL != plan )
+        mPlans[ key ] = plan;
+
+    ::pthread_mutex_unlock( &mMutex );
+
+    // Check for error
+    if( NULL == plan )
+        throw except::RuntimeError(
+            ::ssprintf( "Failed to prepare FFTW plan of size %lu",
+                        (unsigned long)size ) );
+
+    return plan;
+}
+
+void FftCache::create()
+{
+    mInstance.reset( new FftCache );
+}
+
+/*************************************************************************/
+/* cgt::core::FftCache::PlanKey                                          */
+/*************************************************************************/
+bool FftCache::PlanKey::operator<( const PlanKey& key ) const
+{
+    if( size != key.size )
+        return size < key.size;
+    if( kind != key.kind )
+        return kind < key.kind;
+    if( flags != key.flags )
+        return flags < key.flags;
+
+    return inPlace < key.inPlace;
+}
@@ -0,0 +1,129 @@
+/**
+ * @file core/HarmonicProduct.cpp
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#include "cgt-common.h"
+
+#include "core/HarmonicProduct.h"
+
+using namespace cgt;
+using namespace cgt::core;
+
+/*************************************************************************/
+/* cgt::core::HarmonicProduct                                            */
+/*************************************************************************/
+const double HarmonicProduct::MIN_FREQ = 50.0;
+const double HarmonicProduct::MAX_FREQ = 1500.0;
+
+HarmonicProduct::HarmonicProduct( unsigned int harmonics )
+: mHarmonics( harmonics ),
+  mCount( 0 ),
+  mFirst( 0 ),
+  mLast( 0 ),
+  mProducts( NULL ),
+  mBin( 0 ),
+  mSalience( 0 )
+{
+    // Make sure the count is sane.
+    if( 1 > harmonics )
+        throw except::InvalidArgument(
+            ::ssprintf( "Invalid number of harmonics (%u)", harmonics ) );
+}
+
+HarmonicProduct::~HarmonicProduct()
+{
+    // Free all resources.
+    free();
+}
+
+void HarmonicProduct::init( size_t count, double binFreq )
+{
+    // Make sure all resources are freed first.
+    free();
+
+    // Half-width of the widest harmonic window.
+    const size_t width = harmonics() / 2;
+
+    mCount = count;
+
+    // Never consider DC a candidate.
+    mFirst = std::max< size_t >( 1, MIN_FREQ / binFreq );
+    // All harmonics of the last candidate must fit in.
+    mLast  = std::min< size_t >( MAX_FREQ / binFreq + 1,
+                                 count > width
+                                 ? ( count - 1 - width ) / harmonics() + 1
+                                 : 0 );
+
+    // Products are indexed by bin as well.
+    mProducts = new double[ std::max( mFirst, mLast ) ];
+}
+
+void HarmonicProduct::free()
+{
+    // Release the buffers.
+    util::safeDeleteArray( mProducts );
+
+    mCount = 0;
+    mFirst = 0;
+    mLast  = 0;
+
+    mBin      = 0;
+    mSalience = 0;
+}
+
+bool HarmonicProduct::process( const double* mags )
+{
+    // Forget the last estimate.
+    mBin      = 0;
+    mSalience = 0;
+
+    // Check if there are any candidates at all.
+    if( mFirst >= mLast )
+        return false;
+
+    // Start with the fundamental itself.
+    ::memcpy( &mProducts[ mFirst ], &mags[ mFirst ],
+              sizeof( double ) * ( mLast - mFirst ) );
+
+    // Multiply by each of the higher harmonics.
+    for( unsigned int h = 2; h <= harmonics(); ++h )
+    {
+        // The harmonic may lie up to h/2 bins away.
+        const size_t width = h / 2;
+
+        for( size_t k = mFirst; k < mLast; ++k )
+        {
+            // Pick the largest magnitude in the window.
+            const double* cur = &mags[ h * k - width ];
+            double peak = cur[ 0 ];
+
+            for( size_t j = 1; j <= 2 * width; ++j )
+                peak = std::max( peak, cur[ j ] );
+
+            mProducts[ k ] *= peak;
+        }
+    }
+
+    // Find the best candidate.
+    size_t best = mFirst;
+    for( size_t k = mFirst + 1; k < mLast; ++k )
+    {
+        if( mProducts[ best ] < mProducts[ k ] )
+            best = k;
+    }
+
+    // Check if we've got anything at all.
+    if( !( 0 < mProducts[ best ] ) )
+        return false;
+
+    // Store the estimate.
+    mBin      = best;
+    mSalience = 10 * ::log10( mProducts[ best ] ) / harmonics();
+
+    return true;
+}
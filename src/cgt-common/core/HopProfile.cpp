@@ -0,0 +1,62 @@
+/**
+ * @file core/HopProfile.cpp
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#include "cgt-common.h"
+
+#include "core/HopProfile.h"
+#include "util/Misc.h"
+#include "util/Tracer.h"
+
+using namespace cgt;
+using namespace cgt::core;
+
+/*************************************************************************/
+/* cgt::core::HopProfile                                                 */
+/*************************************************************************/
+const char* const HopProfile::STAGE_NAMES[ STAGE_COUNT ] =
+{
+    "Capture",   // STAGE_CAPTURE
+    "Shift",     // STAGE_SHIFT
+    "Transform", // STAGE_TRANSFORM
+    "Process",   // STAGE_PROCESS
+    "Output",    // STAGE_OUTPUT
+    "Observer",  // STAGE_OBSERVER
+    "Hop"        // STAGE_HOP
+};
+
+void HopProfile::snapshot( HopProfile& copy ) const
+{
+    for( unsigned int i = 0; i < STAGE_COUNT; ++i )
+        mStages[ i ].snapshot( copy.mStages[ i ] );
+}
+
+void HopProfile::since( const HopProfile& earlier )
+{
+    for( unsigned int i = 0; i < STAGE_COUNT; ++i )
+        mStages[ i ].since( earlier.mStages[ i ] );
+}
+
+/*************************************************************************/
+/* cgt::core::HopProfile::Timer                                          */
+/*************************************************************************/
+HopProfile::Timer::Timer( HopProfile& profile, Stage stage )
+: mProfile( profile ),
+  mStage( stage ),
+  mStart( util::monotonicTime() )
+{
+    sTracer.record( 'B', STAGE_NAMES[ mStage ], mStart );
+}
+
+HopProfile::Timer::~Timer()
+{
+    const uint64 end = util::monotonicTime();
+
+    mProfile.record( mStage, end - mStart );
+    sTracer.record( 'E', STAGE_NAMES[ mStage ], end );
+}
@@ -0,0 +1,44 @@
+/**
+ * @file core/LatencyMeter.cpp
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#include "cgt-common.h"
+
+#include "core/LatencyMeter.h"
+
+using namespace cgt;
+using namespace cgt::core;
+
+/*************************************************************************/
+/* cgt::core::LatencyMeter                                               */
+/*************************************************************************/
+void LatencyMeter::add( uint64 captured, unsigned int delay, unsigned int rate, uint64 shown )
+{
+    // Unknown, or a clock we can't compare with?
+    if( 0 == captured || 0 == rate || shown < captured )
+        return;
+
+    const uint64 pipeline = shown - captured;
+
+    mPipeline.add( pipeline );
+    mTotal.add( pipeline + uint64( delay ) * 1000000000 / rate );
+}
+
+std::string LatencyMeter::summary() const
+{
+    return ::ssprintf( "%.1f/%.1f/%.1f ms from capture, "
+                       "%.1f/%.1f/%.1f ms from the middle of the window "
+                       "(p50/p99/max of %"PRIu64" frames)",
+                       mPipeline.percentile( 50 ) / 1e6,
+                       mPipeline.percentile( 99 ) / 1e6,
+                       mPipeline.max() / 1e6,
+                       mTotal.percentile( 50 ) / 1e6,
+                       mTotal.percentile( 99 ) / 1e6,
+                       mTotal.max() / 1e6,
+                       mPipeline.count() );
+}
@@ -0,0 +1,306 @@
+/**
+ * @file core/ObserverBus.cpp
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#include "cgt-common.h"
+
+#include "core/ObserverBus.h"
+#include "util/Tracer.h"
+
+using namespace cgt;
+using namespace cgt::core;
+
+/*************************************************************************/
+/* cgt::core::ObserverBus                                                */
+/*************************************************************************/
+const uint64 ObserverBus::WRITING = ~uint64( 0 );
+
+ObserverBus::ObserverBus( size_t maxPeaks )
+: mMaxPeaks( maxPeaks ),
+  mTruncated( 0 )
+{
+    // Make sure the capacity is sane.
+    if( 0 == maxPeaks )
+        throw except::InvalidArgument( "Invalid frame capacity (0)" );
+}
+
+ObserverBus::~ObserverBus()
+{
+    try
+    {
+        // Stop the threads first.
+        stop();
+    }
+    catch( const except::Exception& )
+    {
+        // Nobody to tell about it anymore.
+    }
+
+    // Release the subscribers.
+    std::vector< Subscriber* >::iterator cur, end;
+    cur = mSubscribers.begin();
+    end = mSubscribers.end();
+    for(; cur != end; ++cur )
+        util::safeDelete( *cur );
+}
+
+size_t ObserverBus::subscribe( Analyser::IFrameObserver& observer,
+                               size_t capacity, Policy policy )
+{
+    // Make sure the capacity is sane.
+    if( 0 == capacity )
+        throw except::InvalidArgument( "Invalid subscriber queue capacity (0)" );
+
+    mSubscribers.push_back( new Subscriber( observer, capacity, policy, mMaxPeaks ) );
+    return mSubscribers.size() - 1;
+}
+
+uint64 ObserverBus::delivered( size_t index ) const
+{
+    return mSubscribers.at( index )->delivered();
+}
+
+uint64 ObserverBus::dropped( size_t index ) const
+{
+    return mSubscribers.at( index )->dropped();
+}
+
+uint64 ObserverBus::lag( size_t index ) const
+{
+    return mSubscribers.at( index )->lag();
+}
+
+void ObserverBus::start()
+{
+    // Start all the threads.
+    for( size_t i = 0; i < mSubscribers.size(); ++i )
+        mSubscribers[ i ]->thread().start();
+}
+
+void ObserverBus::stop()
+{
+    bool        failed = false;
+    std::string error;
+
+    for( size_t i = 0; i < mSubscribers.size(); ++i )
+    {
+        Subscriber* sub = mSubscribers[ i ];
+
+        try
+        {
+            // Request stop, wake it up and wait for it.
+            sub->thread().requestStop();
+            sub->wake();
+            sub->thread().stop();
+        }
+        catch( const except::Exception& e )
+        {
+            // Remember the first error, stop the rest.
+            if( !failed )
+                error = e.what();
+            failed = true;
+        }
+    }
+
+    // Pass the error on.
+    if( failed )
+        throw except::RuntimeError( error );
+}
+
+void ObserverBus::addFrame( const Analyser::Frame& frame )
+{
+    // Fundamentals always fit, frequencies may be cut.
+    const size_t room  = mMaxPeaks > frame.pitchCount ? mMaxPeaks - frame.pitchCount : 0;
+    const size_t count = std::min( room, frame.peakCount );
+
+    if( count < frame.peakCount )
+        ++mTruncated;
+
+    // Queue it for everyone.
+    std::vector< Subscriber* >::iterator cur, end;
+    cur = mSubscribers.begin();
+    end = mSubscribers.end();
+    for(; cur != end; ++cur )
+        (*cur)->push( frame, count );
+}
+
+/*************************************************************************/
+/* cgt::core::ObserverBus::Subscriber                                    */
+/*************************************************************************/
+ObserverBus::Subscriber::Subscriber( Analyser::IFrameObserver& observer, size_t capacity,
+                                     Policy policy, size_t maxPeaks )
+: mObserver( observer ),
+  mPolicy( policy ),
+  mCapacity( capacity ),
+  mMaxPeaks( maxPeaks ),
+  mSlots( new Slot[ capacity ] ),
+  mWrite( 0 ),
+  mRead( 0 ),
+  mPeaks( maxPeaks ),
+  mDelivered( 0 ),
+  mDropped( 0 ),
+  mThread( *this )
+{
+    // Preallocate all the slots.
+    for( size_t i = 0; i < mCapacity; ++i )
+    {
+        mSlots[ i ].sequence = 0;
+        mSlots[ i ].peaks    = new Analyser::Peak[ mMaxPeaks ];
+    }
+
+    ::sem_init( &mFrames, 0, 0 );
+    ::sem_init( &mSpace,  0, 0 );
+}
+
+ObserverBus::Subscriber::~Subscriber()
+{
+    // Don't leave the thread behind.
+    mThread.requestStop();
+    wake();
+
+    try
+    {
+        mThread.stop();
+    }
+    catch( const except::Exception& )
+    {
+        // Nobody to tell about it anymore.
+    }
+
+    ::sem_destroy( &mFrames );
+    ::sem_destroy( &mSpace );
+
+    // Release the slots.
+    for( size_t i = 0; i < mCapacity; ++i )
+        util::safeDeleteArray( mSlots[ i ].peaks );
+
+    util::safeDeleteArray( mSlots );
+}
+
+void ObserverBus::Subscriber::push( const Analyser::Frame& frame, size_t count )
+{
+    const uint64 index = mWrite;
+
+    // Wait for some space if asked to.
+    if( POLICY_BLOCK == mPolicy )
+    {
+        while( mCapacity <= index - mRead && !mThread.stopRequested() )
+            ::sem_wait( &mSpace );
+    }
+
+    Slot& slot = mSlots[ index % mCapacity ];
+
+    // Let the consumer know the slot is unusable ...
+    slot.sequence = WRITING;
+    __sync_synchronize();
+
+    // ... fill it in ...
+    slot.position   = frame.position;
+    slot.rate       = frame.rate;
+    slot.captured   = frame.captured;
+    slot.delay      = frame.delay;
+    slot.pitchCount = std::min( frame.pitchCount, mMaxPeaks );
+    slot.peakCount  = count;
+
+    std::copy( frame.pitches, frame.pitches + slot.pitchCount, slot.peaks );
+    std::copy( frame.peaks,   frame.peaks   + slot.peakCount,  slot.peaks + slot.pitchCount );
+
+    // ... and publish it.
+    __sync_synchronize();
+    slot.sequence = index + 1;
+    __sync_synchronize();
+    mWrite = index + 1;
+
+    // Wake up the consumer.
+    ::sem_post( &mFrames );
+}
+
+void ObserverBus::Subscriber::wake()
+{
+    // Unblock whoever might be waiting.
+    ::sem_post( &mFrames );
+    ::sem_post( &mSpace );
+}
+
+void ObserverBus::Subscriber::run( util::Thread& thread )
+{
+    // Tell it apart in the trace.
+    sTracer.nameThread( "Subscriber" );
+
+    while( !thread.stopRequested() )
+    {
+        // Wait for a frame.
+        if( mRead == mWrite )
+        {
+            ::sem_wait( &mFrames );
+            continue;
+        }
+
+        // Copy it and pass it on if it's intact.
+        if( pop() )
+        {
+            CGT_TRACE_SCOPE( "Deliver" );
+
+            mObserver.addFrame( mFrame );
+            ++mDelivered;
+        }
+
+        // Free the slot.
+        if( POLICY_BLOCK == mPolicy )
+            ::sem_post( &mSpace );
+    }
+}
+
+bool ObserverBus::Subscriber::pop()
+{
+    const uint64 write = mWrite;
+
+    // Skip what has been overwritten already.
+    if( mCapacity < write - mRead )
+    {
+        mDropped += write - mCapacity - mRead;
+        mRead     = write - mCapacity;
+    }
+
+    const uint64 index = mRead;
+    const Slot&  slot  = mSlots[ index % mCapacity ];
+
+    // Check the slot holds our frame ...
+    const uint64 sequence = slot.sequence;
+    __sync_synchronize();
+
+    if( index + 1 == sequence )
+    {
+        // ... copy it, the counts may be torn so clamp them ...
+        const size_t total = std::min( slot.pitchCount + slot.peakCount, mMaxPeaks );
+        const size_t pitch = std::min( slot.pitchCount, total );
+
+        mFrame.position   = slot.position;
+        mFrame.rate       = slot.rate;
+        mFrame.captured   = slot.captured;
+        mFrame.delay      = slot.delay;
+        mFrame.pitchCount = pitch;
+        mFrame.peakCount  = total - pitch;
+
+        std::copy( slot.peaks, slot.peaks + total, mPeaks.begin() );
+
+        mFrame.pitches = &mPeaks[ 0 ];
+        mFrame.peaks   = &mPeaks[ 0 ] + pitch;
+    }
+
+    // ... and check it hasn't changed meanwhile.
+    __sync_synchronize();
+    const bool intact = ( index + 1 == sequence && sequence == slot.sequence );
+
+    // Move on either way.
+    mRead = index + 1;
+
+    if( !intact )
+        ++mDropped;
+    return intact;
+}
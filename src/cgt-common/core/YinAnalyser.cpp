@@ -0,0 +1,233 @@
+/**
+ * @file core/YinAnalyser.cpp
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#include "cgt-common.h"
+
+#include "core/YinAnalyser.h"
+#include "core/FftCache.h"
+
+using namespace cgt;
+using namespace cgt::core;
+
+/*************************************************************************/
+/* cgt::core::YinAnalyser                                                */
+/*************************************************************************/
+const double YinAnalyser::MIN_FREQ = 50.0;
+const double YinAnalyser::MAX_FREQ = 1500.0;
+
+YinAnalyser::YinAnalyser( IFrameObserver& observer, double threshold, double magCutoff )
+: core::Analyser( observer ),
+  mForward( NULL ),
+  mBackward( NULL ),
+  mThreshold( threshold ),
+  mMagnitudeCutoff( magCutoff ),
+  mPadded( NULL ),
+  mCorrelation( NULL ),
+  mEnergy( NULL ),
+  mDifference( NULL )
+{
+}
+
+YinAnalyser::~YinAnalyser()
+{
+    // Free our resources, parent won't call us.
+    free();
+}
+
+void YinAnalyser::init( unsigned int rate, unsigned int bufferSize,
+                        unsigned int captureSize )
+{
+    // Initialize parent first.
+    Analyser::init( rate, bufferSize, captureSize );
+
+    // Make sure we can see at least two periods of the lowest lag.
+    if( maxLag() <= minLag() + 1 )
+        throw except::InvalidArgument(
+            ::ssprintf( "Buffer size (%u) too small for YIN at %u Hz",
+                        bufferSize, rate ) );
+
+    // Zero padding avoids circular correlation.
+    const size_t size = 2 * this->bufferSize();
+
+    // Allocate the arrays.
+    mPadded      = (double*)::fftw_malloc( sizeof( double ) * size );
+    mCorrelation = (double*)::fftw_malloc( sizeof( double ) * size );
+    mEnergy      = new double[ this->bufferSize() + 1 ];
+    mDifference  = new double[ maxLag() ];
+
+    // Share the plans with analysers of the same size.
+    mForward  = sFftCache.plan( size, FFTW_R2HC, FFTW_MEASURE );
+    mBackward = sFftCache.plan( size, FFTW_HC2R, FFTW_MEASURE, true );
+
+    // The padding stays zero.
+    ::memset( mPadded, 0, sizeof( double ) * size );
+}
+
+void YinAnalyser::free()
+{
+    // The plans are shared, just drop them.
+    mForward  = NULL;
+    mBackward = NULL;
+
+    // Release the arrays.
+    util::safeRelease( mPadded,      ::fftw_free );
+    util::safeRelease( mCorrelation, ::fftw_free );
+
+    util::safeDeleteArray( mEnergy );
+    util::safeDeleteArray( mDifference );
+
+    // Let the parent free too.
+    Analyser::free();
+}
+
+void YinAnalyser::analyse()
+{
+    // Process the samples
+    processCorrelation();
+    processDifference();
+    processOutput();
+}
+
+Analyser* YinAnalyser::createTwin() const
+{
+    return new YinAnalyser( observer(), threshold(), magnitudeCutoff() );
+}
+
+void YinAnalyser::adopt( Analyser& twin )
+{
+    YinAnalyser& other = static_cast< YinAnalyser& >( twin );
+
+    std::swap( mForward,     other.mForward );
+    std::swap( mBackward,    other.mBackward );
+    std::swap( mPadded,      other.mPadded );
+    std::swap( mCorrelation, other.mCorrelation );
+    std::swap( mEnergy,      other.mEnergy );
+    std::swap( mDifference,  other.mDifference );
+
+    // Let the parent swap too.
+    Analyser::adopt( twin );
+}
+
+void YinAnalyser::processCorrelation()
+{
+    CGT_PROFILE_STAGE( STAGE_TRANSFORM );
+
+    const size_t size = 2 * bufferSize();
+
+    // Copy the samples, leaving the padding intact.
+    ::memcpy( mPadded, mSamples, sizeof( double ) * bufferSize() );
+
+    // Obtain the spectrum.
+    ::fftw_execute_r2r( mForward, mPadded, mCorrelation );
+
+    // Replace it with power spectrum (halfcomplex layout).
+    mCorrelation[ 0 ] *= mCorrelation[ 0 ];
+    for( size_t k = 1; k < size / 2; ++k )
+    {
+        const double real = mCorrelation[ k ];
+        const double img  = mCorrelation[ size - k ];
+
+        mCorrelation[ k ]        = real * real + img * img;
+        mCorrelation[ size - k ] = 0;
+    }
+    mCorrelation[ size / 2 ] *= mCorrelation[ size / 2 ];
+
+    // Transform back to obtain the (unscaled) autocorrelation.
+    ::fftw_execute_r2r( mBackward, mCorrelation, mCorrelation );
+
+    // Accumulate energy of the samples.
+    mEnergy[ 0 ] = 0;
+    for( size_t i = 0; i < bufferSize(); ++i )
+        mEnergy[ i + 1 ] = mEnergy[ i ] + mSamples[ i ] * mSamples[ i ];
+}
+
+void YinAnalyser::processDifference()
+{
+    CGT_PROFILE_STAGE( STAGE_PROCESS );
+
+    const size_t size  = bufferSize();
+    const size_t limit = maxLag();
+
+    // Scale factor given by FFT.
+    const double scale = 1.0 / ( 2 * size );
+
+    // Running sum of the difference function.
+    double sum = 0;
+
+    mDifference[ 0 ] = 1;
+    for( size_t lag = 1; lag < limit; ++lag )
+    {
+        // Energies of the overlapping parts.
+        const double head = mEnergy[ size - lag ];
+        const double tail = mEnergy[ size ] - mEnergy[ lag ];
+
+        // The plain difference function.
+        const double diff = head + tail - 2 * scale * mCorrelation[ lag ];
+
+        // Normalize it by its cumulative mean.
+        sum += diff;
+        mDifference[ lag ] = 0 < sum ? diff * lag / sum : 1;
+    }
+}
+
+void YinAnalyser::processOutput()
+{
+    CGT_PROFILE_STAGE( STAGE_OUTPUT );
+
+    const size_t limit = maxLag();
+
+    // Start a new frame.
+    startFrame();
+
+    // Obtain magnitude comparable to FftAnalyser.
+    const double mag = ::sqrt( mEnergy[ bufferSize() ] / bufferSize() ) * M_SQRT1_2;
+
+    // Check if the magnitude is large enough.
+    if( 0 < mag && magnitudeCutoff() <= 10 * ::log10( mag ) )
+    {
+        // Find the first dip below the threshold.
+        size_t lag = minLag();
+        for(; lag < limit; ++lag )
+        {
+            if( threshold() > mDifference[ lag ] )
+                break;
+        }
+
+        if( lag < limit )
+        {
+            // Slide down to the bottom of the dip.
+            while( lag + 1 < limit && mDifference[ lag + 1 ] < mDifference[ lag ] )
+                ++lag;
+
+            // Refine the lag by parabolic interpolation.
+            double shift = 0;
+            if( lag + 1 < limit )
+            {
+                const double prev = mDifference[ lag - 1 ];
+                const double cur  = mDifference[ lag ];
+                const double next = mDifference[ lag + 1 ];
+
+                const double den = prev - 2 * cur + next;
+                if( 0 < den )
+                    shift = 0.5 * ( prev - next ) / den;
+            }
+
+            const double freq = sampleRate() / ( lag + shift );
+            // The deeper the dip, the more periodic the signal.
+            const double confidence = std::max( 0.0, 1 - mDifference[ lag ] );
+
+            // It's both the fundamental and the only frequency.
+            addPitch( freq, mag, lag, confidence );
+            addPeak( freq, mag, lag, confidence );
+        }
+    }
+
+    // Pass it to observer.
+    endFrame();
+}
@@ -0,0 +1,267 @@
+/**
+ * @file ipc/FrameRing.cpp
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#include "cgt-common.h"
+
+#include "ipc/FrameRing.h"
+
+using namespace cgt;
+using namespace cgt::ipc;
+
+/*************************************************************************/
+/* cgt::ipc::FrameRing                                                   */
+/*************************************************************************/
+const uint32 FrameRing::MAGIC   = 0x52544743; // "CGTR"
+const uint16 FrameRing::VERSION = 3;
+const uint64 FrameRing::WRITING = ~uint64( 0 );
+
+FrameRing::FrameRing( const char* name, size_t capacity, size_t maxPeaks )
+: mName( name ),
+  mData( NULL ),
+  mSize( 0 ),
+  mHeader( NULL ),
+  mTruncated( 0 )
+{
+    // Make sure the sizes are sane.
+    if( 0 == capacity || 0 == maxPeaks )
+        throw except::InvalidArgument(
+            ::ssprintf( "Invalid frame ring size (%lu slots of %lu records)",
+                        (unsigned long)capacity, (unsigned long)maxPeaks ) );
+
+    int fd = ::shm_open( name, O_RDWR | O_CREAT | O_EXCL, 0644 );
+    int code = 0 > fd ? errno : 0;
+    // Take the name over only from a writer which is gone;
+    // readers still mapping the stale ring keep it to themselves.
+    if( EEXIST == code && stale( name ) )
+    {
+        ::shm_unlink( name );
+        fd = ::shm_open( name, O_RDWR | O_CREAT | O_EXCL, 0644 );
+        code = 0 > fd ? errno : 0;
+    }
+
+    // Check for error
+    if( EEXIST == code )
+        throw except::RuntimeError(
+            ::ssprintf( "Frame ring '%s' already exists and is in use", name ) );
+    else if( 0 > fd )
+        throw except::RuntimeError(
+            ::ssprintf( "Failed to create frame ring '%s': %s",
+                        name, ::strerror( code ) ) );
+
+    const size_t size = sizeof( Header ) + capacity * slotSize( maxPeaks );
+    if( 0 != ::ftruncate( fd, size ) )
+    {
+        const int code = errno;
+        ::close( fd );
+        ::shm_unlink( name );
+
+        throw except::RuntimeError(
+            ::ssprintf( "Failed to size frame ring '%s': %s",
+                        name, ::strerror( code ) ) );
+    }
+
+    try
+    {
+        map( fd, size, PROT_READ | PROT_WRITE );
+    }
+    catch( ... )
+    {
+        ::shm_unlink( name );
+        throw;
+    }
+
+    // The object is zero-filled, so are the sequence numbers.
+    mHeader->version  = VERSION;
+    mHeader->capacity = capacity;
+    mHeader->maxPeaks = maxPeaks;
+    mHeader->writer   = ::getpid();
+    mHeader->head     = 0;
+
+    // Valid from now on.
+    __sync_synchronize();
+    mHeader->magic = MAGIC;
+}
+
+FrameRing::FrameRing( const char* name )
+: mData( NULL ),
+  mSize( 0 ),
+  mHeader( NULL ),
+  mTruncated( 0 )
+{
+    int fd = ::shm_open( name, O_RDONLY, 0 );
+    // Check for error
+    if( 0 > fd )
+        throw except::RuntimeError(
+            ::ssprintf( "Failed to open frame ring '%s': %s",
+                        name, ::strerror( errno ) ) );
+
+    struct stat st;
+    if( 0 != ::fstat( fd, &st ) || size_t( st.st_size ) < sizeof( Header ) )
+    {
+        ::close( fd );
+        throw except::RuntimeError(
+            ::ssprintf( "Frame ring '%s' is not ready", name ) );
+    }
+
+    map( fd, st.st_size, PROT_READ );
+
+    // Check the header.
+    if( MAGIC != mHeader->magic || VERSION != mHeader->version
+        || 0 == capacity() || 0 == maxPeaks()
+        || mSize < sizeof( Header ) + capacity() * slotSize( maxPeaks() ) )
+    {
+        ::munmap( mData, mSize );
+        throw except::RuntimeError(
+            ::ssprintf( "Object '%s' is not a frame ring", name ) );
+    }
+
+    mPeaks.resize( maxPeaks() );
+}
+
+FrameRing::~FrameRing()
+{
+    ::munmap( mData, mSize );
+
+    // Only the writer removes the ring.
+    if( !mName.empty() )
+        ::shm_unlink( mName.c_str() );
+}
+
+void FrameRing::addFrame( const core::Analyser::Frame& frame )
+{
+    // Check if we're allowed to write.
+    if( mName.empty() )
+        throw except::LogicError( "Frame ring opened for reading" );
+
+    const uint64 index = mHeader->head;
+    Slot* cur = slot( index );
+
+    // Fundamentals always fit, frequencies may be cut.
+    const size_t pitchCount = std::min( frame.pitchCount, maxPeaks() );
+    const size_t peakCount  = std::min( frame.peakCount, maxPeaks() - pitchCount );
+
+    if( pitchCount + peakCount < frame.pitchCount + frame.peakCount )
+        ++mTruncated;
+
+    // Let the readers know the slot is unusable ...
+    cur->sequence = WRITING;
+    __sync_synchronize();
+
+    // ... fill it in ...
+    cur->position   = frame.position;
+    cur->captured   = frame.captured;
+    cur->rate       = frame.rate;
+    cur->delay      = frame.delay;
+    cur->pitchCount = pitchCount;
+    cur->peakCount  = peakCount;
+
+    Record* rec = (Record*)( cur + 1 );
+    for( size_t i = 0; i < pitchCount; ++i, ++rec )
+    {
+        rec->freq = frame.pitches[ i ].freq;
+        rec->mag  = frame.pitches[ i ].mag;
+    }
+    for( size_t i = 0; i < peakCount; ++i, ++rec )
+    {
+        rec->freq = frame.peaks[ i ].freq;
+        rec->mag  = frame.peaks[ i ].mag;
+    }
+
+    // ... and publish it.
+    __sync_synchronize();
+    cur->sequence = index + 1;
+    __sync_synchronize();
+    mHeader->head = index + 1;
+}
+
+bool FrameRing::read( uint64 index, core::Analyser::Frame& frame )
+{
+    const Slot* cur = slot( index );
+
+    // Check it's the frame we're after.
+    if( index + 1 != cur->sequence )
+        return false;
+    __sync_synchronize();
+
+    frame.position = cur->position;
+    frame.captured = cur->captured;
+    frame.rate     = cur->rate;
+    frame.delay    = cur->delay;
+
+    // Don't trust the counts until the sequence is checked again.
+    const size_t pitchCount = std::min< size_t >( cur->pitchCount, maxPeaks() );
+    const size_t peakCount  = std::min< size_t >( cur->peakCount, maxPeaks() - pitchCount );
+
+    const Record* rec = (const Record*)( cur + 1 );
+    for( size_t i = 0; i < pitchCount + peakCount; ++i )
+    {
+        mPeaks[ i ].freq       = rec[ i ].freq;
+        mPeaks[ i ].mag        = rec[ i ].mag;
+        mPeaks[ i ].bin        = 0;
+        mPeaks[ i ].confidence = 1;
+    }
+
+    // Overwritten meanwhile?
+    __sync_synchronize();
+    if( index + 1 != cur->sequence )
+        return false;
+
+    frame.pitches    = &mPeaks[ 0 ];
+    frame.pitchCount = pitchCount;
+    frame.peaks      = &mPeaks[ 0 ] + pitchCount;
+    frame.peakCount  = peakCount;
+
+    return true;
+}
+
+void FrameRing::map( int fd, size_t size, int prot )
+{
+    // The mapping keeps the object open on its own.
+    void* data = ::mmap( NULL, size, prot, MAP_SHARED, fd, 0 );
+    ::close( fd );
+
+    // Check for error
+    if( MAP_FAILED == data )
+        throw except::RuntimeError(
+            ::ssprintf( "Failed to map frame ring: %s", ::strerror( errno ) ) );
+
+    mData   = (uint8*)data;
+    mSize   = size;
+    mHeader = (Header*)mData;
+}
+
+bool FrameRing::stale( const char* name )
+{
+    int fd = ::shm_open( name, O_RDONLY, 0 );
+    if( 0 > fd )
+        return false;
+
+    // Anything too small to be a ring isn't ours to remove.
+    struct stat st;
+    if( 0 != ::fstat( fd, &st ) || size_t( st.st_size ) < sizeof( Header ) )
+    {
+        ::close( fd );
+        return false;
+    }
+
+    void* data = ::mmap( NULL, sizeof( Header ), PROT_READ, MAP_SHARED, fd, 0 );
+    ::close( fd );
+    if( MAP_FAILED == data )
+        return false;
+
+    // A ring whose writer doesn't exist anymore? Any version will do,
+    // those before 3 didn't record the writer and are taken over anyway.
+    const Header* header = (const Header*)data;
+    const bool result = MAGIC == header->magic
+                        && ( 3 > header->version
+                             || ( 0 != ::kill( header->writer, 0 ) && ESRCH == errno ) );
+
+    ::munmap( data, sizeof( Header ) );
+    return result;
+}
@@ -0,0 +1,100 @@
+/**
+ * @file stats/Histogram.cpp
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#include "cgt-common.h"
+
+#include "stats/Histogram.h"
+
+using namespace cgt;
+using namespace cgt::stats;
+
+/*************************************************************************/
+/* cgt::stats::Histogram                                                 */
+/*************************************************************************/
+const unsigned int Histogram::SUB_BITS;
+const unsigned int Histogram::SUB_COUNT;
+const unsigned int Histogram::MAX_BITS;
+const unsigned int Histogram::BUCKET_COUNT;
+
+Histogram::Histogram()
+{
+    clear();
+}
+
+void Histogram::clear()
+{
+    for( unsigned int i = 0; i < BUCKET_COUNT; ++i )
+        mCounts[ i ] = 0;
+}
+
+void Histogram::snapshot( Histogram& copy ) const
+{
+    for( unsigned int i = 0; i < BUCKET_COUNT; ++i )
+        copy.mCounts[ i ] = mCounts[ i ];
+}
+
+void Histogram::since( const Histogram& earlier )
+{
+    // Counts only grow, unless the writer cleared them meanwhile.
+    for( unsigned int i = 0; i < BUCKET_COUNT; ++i )
+        mCounts[ i ] = earlier.mCounts[ i ] <= mCounts[ i ]
+            ? mCounts[ i ] - earlier.mCounts[ i ] : mCounts[ i ];
+}
+
+uint64 Histogram::count() const
+{
+    uint64 total = 0;
+    for( unsigned int i = 0; i < BUCKET_COUNT; ++i )
+        total += mCounts[ i ];
+
+    return total;
+}
+
+uint64 Histogram::percentile( double percent ) const
+{
+    const uint64 total = count();
+    if( 0 == total )
+        return 0;
+
+    // Number of values at or below the percentile, at least one.
+    const double rank   = ::ceil( total * std::min( std::max( percent, 0.0 ), 100.0 ) / 100 );
+    const uint64 wanted = std::max< uint64 >( 1, (uint64)rank );
+
+    uint64 seen = 0;
+    for( unsigned int i = 0; i < BUCKET_COUNT; ++i )
+    {
+        seen += mCounts[ i ];
+        if( wanted <= seen )
+            return highest( i );
+    }
+
+    return highest( BUCKET_COUNT - 1 );
+}
+
+uint64 Histogram::max() const
+{
+    for( unsigned int i = BUCKET_COUNT; 0 < i; --i )
+        if( 0 < mCounts[ i - 1 ] )
+            return highest( i - 1 );
+
+    return 0;
+}
+
+uint64 Histogram::highest( unsigned int bucket )
+{
+    // Small values have a bucket each.
+    if( bucket < SUB_COUNT )
+        return bucket;
+
+    // Buckets of a range are as wide as its lowest bit.
+    const unsigned int shift = bucket / SUB_COUNT - 1;
+    const uint64       sub   = SUB_COUNT + bucket % SUB_COUNT;
+
+    return ( ( sub + 1 ) << shift ) - 1;
+}
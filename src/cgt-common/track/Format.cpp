@@ -0,0 +1,121 @@
+/**
+ * @file track/Format.cpp
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#include "cgt-common.h"
+
+#include "track/Format.h"
+
+using namespace cgt;
+using namespace cgt::track;
+
+/*************************************************************************/
+/* cgt::track::Format                                                    */
+/*************************************************************************/
+const size_t Format::BLOCK_SIZE;
+const size_t Format::BLOCK_HEADER_SIZE;
+const size_t Format::MAX_RECORD_SIZE;
+const size_t Format::MAX_FRAME_SIZE;
+
+const size_t Format::NOTE_COUNT;
+const size_t Format::INDEX_HEADER_SIZE;
+const size_t Format::INDEX_ENTRY_SIZE;
+
+const uint32 Format::FILE_MAGIC  = 0x54544743; // "CGTT"
+const uint32 Format::BLOCK_MAGIC = 0x42544743; // "CGTB"
+const uint32 Format::INDEX_MAGIC = 0x49544743; // "CGTI"
+const uint16 Format::VERSION     = 1;
+
+const double Format::CENTS_SCALE = 10.0;
+const double Format::DB_SCALE    = 100.0;
+
+int32 Format::encodeFreq( double freq )
+{
+    // Nothing sensible lies below MIDI note 0.
+    if( !( 0 < freq ) )
+        return 0;
+
+    const double cents = 1200 * ::log2( freq / 440.0 ) + 6900;
+    return std::max( 0L, ::lround( cents * CENTS_SCALE ) );
+}
+
+double Format::decodeFreq( int32 pitch )
+{
+    return 440.0 * ::exp2( ( pitch / CENTS_SCALE - 6900 ) / 1200 );
+}
+
+int32 Format::noteOf( int32 pitch )
+{
+    // Quantized pitches are never negative.
+    const int32 step = 100 * CENTS_SCALE;
+    return ( pitch + step / 2 ) / step;
+}
+
+double Format::deviationOf( int32 pitch )
+{
+    return pitch / CENTS_SCALE - 100 * noteOf( pitch );
+}
+
+int16 Format::encodeMag( double mag )
+{
+    // Magnitudes are in dB of amplitude, as the cutoffs.
+    const double level = 0 < mag ? 10 * ::log10( mag ) * DB_SCALE : -HUGE_VAL;
+
+    return std::max< double >( SHRT_MIN, std::min< double >( SHRT_MAX, ::round( level ) ) );
+}
+
+double Format::decodeMag( int16 level )
+{
+    return ::pow( 10, level / DB_SCALE / 10 );
+}
+
+uint8* Format::putFixed( uint8* buf, uint64 value, size_t size )
+{
+    for( size_t i = 0; i < size; ++i, value >>= 8 )
+        *buf++ = uint8( value );
+
+    return buf;
+}
+
+uint64 Format::getFixed( const uint8* buf, size_t size )
+{
+    uint64 value = 0;
+    for( size_t i = size; 0 < i; --i )
+        value = ( value << 8 ) | buf[ i - 1 ];
+
+    return value;
+}
+
+uint8* Format::putVarint( uint8* buf, uint64 value )
+{
+    // Seven bits at a time, the top bit marks continuation.
+    while( 0x80 <= value )
+    {
+        *buf++ = uint8( value ) | 0x80;
+        value >>= 7;
+    }
+
+    *buf++ = uint8( value );
+    return buf;
+}
+
+const uint8* Format::getVarint( const uint8* buf, const uint8* end, uint64& value )
+{
+    value = 0;
+    for( unsigned int shift = 0; buf < end && shift < 64; shift += 7 )
+    {
+        const uint8 byte = *buf++;
+        value |= uint64( byte & 0x7F ) << shift;
+
+        if( 0 == ( byte & 0x80 ) )
+            return buf;
+    }
+
+    // Ran out of the buffer.
+    return NULL;
+}
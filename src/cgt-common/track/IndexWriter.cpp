@@ -0,0 +1,144 @@
+/**
+ * @file track/IndexWriter.cpp
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#include "cgt-common.h"
+
+#include "track/IndexWriter.h"
+
+using namespace cgt;
+using namespace cgt::track;
+
+/*************************************************************************/
+/* cgt::track::IndexWriter                                               */
+/*************************************************************************/
+IndexWriter::IndexWriter( const char* path )
+: mFile( ::fopen( path, "wb" ) ),
+  mRate( 0 )
+{
+    // Check for error
+    if( NULL == mFile )
+        throw except::RuntimeError(
+            ::ssprintf( "Failed to create index '%s': %s",
+                        path, ::strerror( errno ) ) );
+
+    clear();
+}
+
+IndexWriter::~IndexWriter()
+{
+    // Nowhere to report errors to.
+    try
+    {
+        close();
+    }
+    catch( const except::Exception& )
+    {
+    }
+}
+
+void IndexWriter::add( const core::Analyser::Frame& frame )
+{
+    // The rate comes with the first frame.
+    if( 0 == mRate )
+    {
+        uint8 header[ Format::INDEX_HEADER_SIZE ] = { 0 };
+
+        Format::putFixed( &header[ 0 ], Format::INDEX_MAGIC, 4 );
+        Format::putFixed( &header[ 4 ], Format::VERSION, 2 );
+        Format::putFixed( &header[ 6 ], Format::NOTE_COUNT, 2 );
+        Format::putFixed( &header[ 8 ], frame.rate, 4 );
+
+        write( header, sizeof( header ) );
+        mRate = frame.rate;
+    }
+
+    if( 0 == mFrames++ )
+        mFirst = frame.position;
+    mLast = frame.position;
+
+    addRecords( frame.pitches, frame.pitchCount );
+    addRecords( frame.peaks, frame.peakCount );
+}
+
+void IndexWriter::endBlock()
+{
+    // The track doesn't write empty blocks either.
+    if( 0 == mFrames )
+        return;
+
+    uint8 entry[ Format::INDEX_ENTRY_SIZE ];
+
+    uint8* cur = entry;
+    cur = Format::putFixed( cur, mFirst, 8 );
+    cur = Format::putFixed( cur, mLast, 8 );
+
+    for( size_t note = 0; note < Format::NOTE_COUNT; ++note )
+    {
+        *cur++ = uint8( mLow[ note ] );
+        *cur++ = uint8( mHigh[ note ] );
+    }
+
+    write( entry, sizeof( entry ) );
+    clear();
+}
+
+void IndexWriter::close()
+{
+    if( NULL == mFile )
+        return;
+
+    FILE* file = mFile;
+    mFile = NULL;
+
+    // Check for error
+    if( 0 != ::fclose( file ) )
+        throw except::RuntimeError(
+            ::ssprintf( "Failed to close index: %s", ::strerror( errno ) ) );
+}
+
+void IndexWriter::addRecords( const core::Analyser::Peak* peaks, size_t count )
+{
+    for( size_t i = 0; i < count; ++i )
+    {
+        const int32 pitch = Format::encodeFreq( peaks[ i ].freq );
+        const int32 note  = Format::noteOf( pitch );
+
+        // Too high to be a note.
+        if( Format::NOTE_COUNT <= size_t( note ) )
+            continue;
+
+        // Round outwards, so that the summary covers the record.
+        const double dev = Format::deviationOf( pitch );
+        mLow[ note ]  = std::min< int >( mLow[ note ],  ::floor( dev ) );
+        mHigh[ note ] = std::max< int >( mHigh[ note ], ::ceil( dev ) );
+    }
+}
+
+void IndexWriter::clear()
+{
+    mFrames = 0;
+    mFirst  = 0;
+    mLast   = 0;
+
+    // Low above high means no records.
+    std::fill( mLow,  mLow  + Format::NOTE_COUNT, SCHAR_MAX );
+    std::fill( mHigh, mHigh + Format::NOTE_COUNT, SCHAR_MIN );
+}
+
+void IndexWriter::write( const uint8* data, size_t size )
+{
+    // Check if we've got anywhere to write to.
+    if( NULL == mFile )
+        throw except::LogicError( "Index already closed" );
+
+    // Check for error
+    if( 1 != ::fwrite( data, size, 1, mFile ) )
+        throw except::RuntimeError(
+            ::ssprintf( "Failed to write index: %s", ::strerror( errno ) ) );
+}
@@ -0,0 +1,102 @@
+/**
+ * @file track/TrackIndex.cpp
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#include "cgt-common.h"
+
+#include "track/TrackIndex.h"
+
+using namespace cgt;
+using namespace cgt::track;
+
+/*************************************************************************/
+/* cgt::track::TrackIndex                                                */
+/*************************************************************************/
+TrackIndex::TrackIndex( const char* path )
+: mData( NULL ),
+  mSize( 0 ),
+  mRate( 0 ),
+  mEntryCount( 0 )
+{
+    int fd = ::open( path, O_RDONLY );
+    // Check for error
+    if( 0 > fd )
+        throw except::RuntimeError(
+            ::ssprintf( "Failed to open index '%s': %s",
+                        path, ::strerror( errno ) ) );
+
+    struct stat st;
+    if( 0 != ::fstat( fd, &st ) || size_t( st.st_size ) < Format::INDEX_HEADER_SIZE )
+    {
+        ::close( fd );
+        throw except::RuntimeError(
+            ::ssprintf( "Index '%s' is empty", path ) );
+    }
+
+    // The mapping keeps the file open on its own.
+    void* data = ::mmap( NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+    ::close( fd );
+
+    if( MAP_FAILED == data )
+        throw except::RuntimeError(
+            ::ssprintf( "Failed to map index '%s': %s",
+                        path, ::strerror( errno ) ) );
+
+    mData = (const uint8*)data;
+    mSize = st.st_size;
+
+    // Check the header.
+    if( Format::INDEX_MAGIC != Format::getFixed( &mData[ 0 ], 4 )
+        || Format::VERSION != Format::getFixed( &mData[ 4 ], 2 )
+        || Format::NOTE_COUNT != Format::getFixed( &mData[ 6 ], 2 ) )
+    {
+        ::munmap( data, mSize );
+        throw except::RuntimeError(
+            ::ssprintf( "File '%s' is not a track index", path ) );
+    }
+
+    mRate = Format::getFixed( &mData[ 8 ], 4 );
+    // An entry cut short by a crash is ignored.
+    mEntryCount = ( mSize - Format::INDEX_HEADER_SIZE ) / Format::INDEX_ENTRY_SIZE;
+}
+
+TrackIndex::~TrackIndex()
+{
+    ::munmap( (void*)mData, mSize );
+}
+
+bool TrackIndex::contains( uint64 index, size_t note, double low, double high ) const
+{
+    if( Format::NOTE_COUNT <= note )
+        return false;
+
+    // Deviations of the note follow the positions.
+    const uint8* range = entry( index ) + 16 + 2 * note;
+    const int8 noteLow  = int8( range[ 0 ] );
+    const int8 noteHigh = int8( range[ 1 ] );
+
+    // Empty summaries never overlap.
+    return noteLow <= high && low <= noteHigh;
+}
+
+uint64 TrackIndex::find( uint64 position ) const
+{
+    // Bisect, the blocks are in order.
+    uint64 low = 0, high = entryCount();
+    while( low < high )
+    {
+        const uint64 mid = low + ( high - low ) / 2;
+
+        if( lastPosition( mid ) < position )
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return low;
+}
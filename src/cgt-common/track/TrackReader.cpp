@@ -0,0 +1,244 @@
+/**
+ * @file track/TrackReader.cpp
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#include "cgt-common.h"
+
+#include "track/TrackReader.h"
+
+using namespace cgt;
+using namespace cgt::track;
+
+/*************************************************************************/
+/* cgt::track::TrackReader                                               */
+/*************************************************************************/
+TrackReader::TrackReader( const char* path )
+: mFile( ::fopen( path, "rb" ) ),
+  mRate( 0 ),
+  mBlockCount( 0 ),
+  mBlockIndex( 0 ),
+  mCursor( NULL ),
+  mEnd( NULL ),
+  mFramesLeft( 0 ),
+  mPosition( 0 ),
+  mPending( false )
+{
+    // Check for error
+    if( NULL == mFile )
+        throw except::RuntimeError(
+            ::ssprintf( "Failed to open track '%s': %s",
+                        path, ::strerror( errno ) ) );
+
+    try
+    {
+        // A block cut short by a crash is ignored.
+        ::fseeko( mFile, 0, SEEK_END );
+        const uint64 blocks = ::ftello( mFile ) / Format::BLOCK_SIZE;
+
+        if( 0 == blocks )
+            throw except::RuntimeError(
+                ::ssprintf( "Track '%s' is empty", path ) );
+
+        // Check the file header.
+        uint8 header[ Format::BLOCK_SIZE ];
+        readBlock( 0, header );
+        mBlockCount = blocks - 1;
+
+        if( Format::FILE_MAGIC != Format::getFixed( &header[ 0 ], 4 )
+            || Format::VERSION != Format::getFixed( &header[ 4 ], 2 ) )
+            throw except::RuntimeError(
+                ::ssprintf( "File '%s' is not a track", path ) );
+
+        mRate = Format::getFixed( &header[ 8 ], 4 );
+
+        // Get ready for the first frame.
+        if( 0 < mBlockCount )
+            loadBlock( 0 );
+    }
+    catch( ... )
+    {
+        ::fclose( mFile );
+        throw;
+    }
+}
+
+TrackReader::~TrackReader()
+{
+    ::fclose( mFile );
+}
+
+bool TrackReader::next( core::Analyser::Frame& frame )
+{
+    // seek() may have read it already.
+    if( mPending )
+    {
+        frame    = mFrame;
+        mPending = false;
+        return true;
+    }
+
+    // Skip to the next block with frames.
+    while( 0 == mFramesLeft )
+    {
+        if( mBlockCount <= mBlockIndex + 1 )
+            return false;
+
+        loadBlock( mBlockIndex + 1 );
+    }
+
+    decode( frame );
+    return true;
+}
+
+void TrackReader::seek( uint64 position )
+{
+    if( 0 == mBlockCount )
+        return;
+
+    // Bisect for the last block starting at the position or earlier.
+    uint64 low = 0, high = mBlockCount - 1;
+    while( low < high )
+    {
+        const uint64 mid = low + ( high - low + 1 ) / 2;
+
+        if( blockPosition( mid ) <= position )
+            low = mid;
+        else
+            high = mid - 1;
+    }
+
+    loadBlock( low );
+
+    // Skip the earlier frames, keeping the first one after.
+    core::Analyser::Frame frame;
+    while( next( frame ) )
+    {
+        if( position <= frame.position )
+        {
+            mFrame   = frame;
+            mPending = true;
+            return;
+        }
+    }
+}
+
+void TrackReader::seekBlock( uint64 index )
+{
+    if( index < mBlockCount )
+        loadBlock( index );
+    else
+    {
+        // Past the end, nothing left to read.
+        mBlockIndex = mBlockCount;
+        mFramesLeft = 0;
+        mPending    = false;
+    }
+}
+
+void TrackReader::readBlock( uint64 index, uint8* block )
+{
+    // Check for error
+    if( 0 != ::fseeko( mFile, index * Format::BLOCK_SIZE, SEEK_SET )
+        || 1 != ::fread( block, Format::BLOCK_SIZE, 1, mFile ) )
+        throw except::RuntimeError(
+            ::ssprintf( "Failed to read track block %"PRIu64, index ) );
+}
+
+uint64 TrackReader::blockPosition( uint64 index )
+{
+    uint8 header[ Format::BLOCK_HEADER_SIZE ];
+
+    // The header is all we need.
+    if( 0 != ::fseeko( mFile, ( index + 1 ) * Format::BLOCK_SIZE, SEEK_SET )
+        || 1 != ::fread( header, sizeof( header ), 1, mFile ) )
+        throw except::RuntimeError(
+            ::ssprintf( "Failed to read track block %"PRIu64, index ) );
+
+    if( Format::BLOCK_MAGIC != Format::getFixed( &header[ 0 ], 4 ) )
+        throw except::RuntimeError(
+            ::ssprintf( "Corrupted track block %"PRIu64, index ) );
+
+    return Format::getFixed( &header[ 8 ], 8 );
+}
+
+void TrackReader::loadBlock( uint64 index )
+{
+    // The file header precedes the blocks.
+    readBlock( index + 1, mBlock );
+
+    const size_t used = Format::getFixed( &mBlock[ 6 ], 2 );
+
+    // Check the header.
+    if( Format::BLOCK_MAGIC != Format::getFixed( &mBlock[ 0 ], 4 )
+        || used < Format::BLOCK_HEADER_SIZE || Format::BLOCK_SIZE < used )
+        throw except::RuntimeError(
+            ::ssprintf( "Corrupted track block %"PRIu64, index ) );
+
+    mBlockIndex = index;
+    mCursor     = &mBlock[ Format::BLOCK_HEADER_SIZE ];
+    mEnd        = &mBlock[ used ];
+    mFramesLeft = Format::getFixed( &mBlock[ 4 ], 2 );
+    mPosition   = Format::getFixed( &mBlock[ 8 ], 8 );
+    mPending    = false;
+}
+
+void TrackReader::decode( core::Analyser::Frame& frame )
+{
+    uint64 delta, pitchCount, peakCount;
+
+    // Check for error
+    if( NULL == ( mCursor = Format::getVarint( mCursor, mEnd, delta ) )
+        || NULL == ( mCursor = Format::getVarint( mCursor, mEnd, pitchCount ) )
+        || NULL == ( mCursor = Format::getVarint( mCursor, mEnd, peakCount ) )
+        || Format::BLOCK_SIZE < pitchCount + peakCount )
+        throw except::RuntimeError(
+            ::ssprintf( "Corrupted track block %"PRIu64, mBlockIndex ) );
+
+    getRecords( pitchCount, mPitches );
+    getRecords( peakCount, mPeaks );
+
+    mPosition += delta;
+    --mFramesLeft;
+
+    frame.position   = mPosition;
+    frame.rate       = mRate;
+    // Tracks don't keep the timing of the capture.
+    frame.captured   = 0;
+    frame.delay      = 0;
+    frame.pitches    = mPitches.empty() ? NULL : &mPitches[ 0 ];
+    frame.pitchCount = mPitches.size();
+    frame.peaks      = mPeaks.empty() ? NULL : &mPeaks[ 0 ];
+    frame.peakCount  = mPeaks.size();
+}
+
+void TrackReader::getRecords( size_t count, std::vector< core::Analyser::Peak >& peaks )
+{
+    peaks.resize( count );
+
+    int32 pitch = 0;
+    for( size_t i = 0; i < count; ++i )
+    {
+        uint64 delta;
+
+        // Check for error
+        if( NULL == ( mCursor = Format::getVarint( mCursor, mEnd, delta ) )
+            || mEnd < mCursor + 2 )
+            throw except::RuntimeError(
+                ::ssprintf( "Corrupted track block %"PRIu64, mBlockIndex ) );
+
+        pitch += Format::unzigzag( delta );
+        const int16 level = Format::getFixed( mCursor, 2 );
+        mCursor += 2;
+
+        core::Analyser::Peak& peak = peaks[ i ];
+        peak.freq       = Format::decodeFreq( pitch );
+        peak.mag        = Format::decodeMag( level );
+        peak.bin        = 0;
+        peak.confidence = 1;
+    }
+}
@@ -0,0 +1,200 @@
+/**
+ * @file track/TrackWriter.cpp
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#include "cgt-common.h"
+
+#include "track/TrackWriter.h"
+
+using namespace cgt;
+using namespace cgt::track;
+
+/*************************************************************************/
+/* cgt::track::TrackWriter                                               */
+/*************************************************************************/
+TrackWriter::TrackWriter( const char* path, const char* indexPath )
+: mFile( ::fopen( path, "wb" ) ),
+  mIndex( NULL ),
+  mRate( 0 ),
+  mUsed( Format::BLOCK_HEADER_SIZE ),
+  mBlockFrames( 0 ),
+  mPosition( 0 ),
+  mFrames( 0 ),
+  mTruncated( 0 )
+{
+    // Check for error
+    if( NULL == mFile )
+        throw except::RuntimeError(
+            ::ssprintf( "Failed to create track '%s': %s",
+                        path, ::strerror( errno ) ) );
+
+    // Open the index as well, if requested.
+    if( NULL != indexPath )
+    {
+        try
+        {
+            mIndex = new IndexWriter( indexPath );
+        }
+        catch( ... )
+        {
+            ::fclose( mFile );
+            throw;
+        }
+    }
+}
+
+TrackWriter::~TrackWriter()
+{
+    // Nowhere to report errors to.
+    try
+    {
+        close();
+    }
+    catch( const except::Exception& )
+    {
+    }
+
+    util::safeDelete( mIndex );
+}
+
+void TrackWriter::addFrame( const core::Analyser::Frame& frame )
+{
+    // The rate comes with the first frame.
+    if( 0 == mRate )
+        writeHeader( frame.rate );
+    else if( frame.rate != mRate )
+        throw except::InvalidArgument(
+            ::ssprintf( "Sample rate changed within track (%u, expected %u)",
+                        frame.rate, mRate ) );
+
+    // Cut the records which wouldn't fit even an empty block.
+    const size_t maxRecords = ( Format::BLOCK_SIZE - Format::BLOCK_HEADER_SIZE
+                                - Format::MAX_FRAME_SIZE ) / Format::MAX_RECORD_SIZE;
+
+    const size_t pitchCount = std::min( frame.pitchCount, maxRecords );
+    const size_t peakCount  = std::min( frame.peakCount, maxRecords - pitchCount );
+    mTruncated += frame.pitchCount + frame.peakCount - pitchCount - peakCount;
+
+    // Start a new block if the worst case doesn't fit.
+    const size_t worst = Format::MAX_FRAME_SIZE
+                         + ( pitchCount + peakCount ) * Format::MAX_RECORD_SIZE;
+    if( Format::BLOCK_SIZE < mUsed + worst )
+        flush();
+
+    // The first frame of a block is at the block position.
+    if( 0 == mBlockFrames )
+    {
+        Format::putFixed( &mBlock[ 8 ], frame.position, 8 );
+        mPosition = frame.position;
+    }
+
+    uint8* cur = &mBlock[ mUsed ];
+    cur = Format::putVarint( cur, frame.position - mPosition );
+    cur = Format::putVarint( cur, pitchCount );
+    cur = Format::putVarint( cur, peakCount );
+
+    cur = putRecords( cur, frame.pitches, pitchCount );
+    cur = putRecords( cur, frame.peaks, peakCount );
+
+    // Summarize it into the same block.
+    if( NULL != mIndex )
+        mIndex->add( frame );
+
+    mUsed     = cur - mBlock;
+    mPosition = frame.position;
+
+    ++mBlockFrames;
+    ++mFrames;
+}
+
+void TrackWriter::flush()
+{
+    // Nothing to write?
+    if( 0 == mBlockFrames )
+        return;
+
+    // Fill in the header, pad the rest.
+    Format::putFixed( &mBlock[ 0 ], Format::BLOCK_MAGIC, 4 );
+    Format::putFixed( &mBlock[ 4 ], mBlockFrames, 2 );
+    Format::putFixed( &mBlock[ 6 ], mUsed, 2 );
+    ::memset( &mBlock[ mUsed ], 0, Format::BLOCK_SIZE - mUsed );
+
+    writeBlock( mBlock );
+
+    // Index entries follow the blocks.
+    if( NULL != mIndex )
+        mIndex->endBlock();
+
+    // Start over.
+    mUsed        = Format::BLOCK_HEADER_SIZE;
+    mBlockFrames = 0;
+}
+
+void TrackWriter::close()
+{
+    if( NULL == mFile )
+        return;
+
+    // Write whatever is pending.
+    flush();
+
+    FILE* file = mFile;
+    mFile = NULL;
+
+    const int code = ::fclose( file );
+
+    // Close the index even if the track failed.
+    if( NULL != mIndex )
+        mIndex->close();
+
+    // Check for error
+    if( 0 != code )
+        throw except::RuntimeError(
+            ::ssprintf( "Failed to close track: %s", ::strerror( errno ) ) );
+}
+
+void TrackWriter::writeHeader( unsigned int rate )
+{
+    uint8 block[ Format::BLOCK_SIZE ] = { 0 };
+
+    Format::putFixed( &block[ 0 ], Format::FILE_MAGIC, 4 );
+    Format::putFixed( &block[ 4 ], Format::VERSION, 2 );
+    Format::putFixed( &block[ 8 ], rate, 4 );
+
+    writeBlock( block );
+    mRate = rate;
+}
+
+void TrackWriter::writeBlock( const uint8* block )
+{
+    // Check if we've got anywhere to write to.
+    if( NULL == mFile )
+        throw except::LogicError( "Track already closed" );
+
+    // Check for error
+    if( 1 != ::fwrite( block, Format::BLOCK_SIZE, 1, mFile ) )
+        throw except::RuntimeError(
+            ::ssprintf( "Failed to write track: %s", ::strerror( errno ) ) );
+}
+
+uint8* TrackWriter::putRecords( uint8* buf, const core::Analyser::Peak* peaks, size_t count )
+{
+    // Deltas keep ascending frequencies short.
+    int32 last = 0;
+    for( size_t i = 0; i < count; ++i )
+    {
+        const int32 pitch = Format::encodeFreq( peaks[ i ].freq );
+
+        buf = Format::putVarint( buf, Format::zigzag( pitch - last ) );
+        buf = Format::putFixed( buf, uint16( Format::encodeMag( peaks[ i ].mag ) ), 2 );
+
+        last = pitch;
+    }
+
+    return buf;
+}
@@ -18,11 +18,74 @@ using namespace cgt::util;
 /* cgt::util::Harmonics                                                  */
 /*************************************************************************/
 Harmonics::Harmonics( double tol )
-: mTolerance( tol )
 {
+    // Compute the spread as well.
+    setTolerance( tol );
+}
+
+void Harmonics::setTolerance( double tol )
+{
+    mTolerance = tol;
+    // tol > 10 * log10( |ratio - k| ) <=> |ratio - k| < 10^( tol / 10 )
+    mSpread    = ::pow( 10, tol / 10 );
 }
 
 unsigned int Harmonics::get( double freq )
+{
+    int harm = -1;
+
+    if( !mFundamentals.empty() )
+    {
+        // Only ratios hitting the known fundamentals are plausible.
+        const int first = std::max( 1.0, ::ceil( freq / mFundamentals.back() - mSpread ) );
+        const int last  = freq / mFundamentals.front() + mSpread;
+
+        // Pick whichever is cheaper.
+        if( last - first + 1 < (int)mFundamentals.size() )
+            harm = search( freq, first, last );
+        else
+            harm = scan( freq );
+    }
+
+    // Return the harmonic index if found.
+    if( 0 <= harm )
+        return harm;
+
+    // Add a new fundamental, frequencies usually come sorted.
+    mFundamentals.insert( std::lower_bound( mFundamentals.begin(),
+                                            mFundamentals.end(), freq ),
+                          freq );
+    return 0;
+}
+
+void Harmonics::clear()
+{
+    // Clear fundamentals.
+    mFundamentals.clear();
+}
+
+int Harmonics::search( double freq, int first, int last ) const
+{
+    // Higher ratios first, i.e. lower fundamentals first.
+    for( int k = last; k >= first; --k )
+    {
+        // The fundamental must lie within these bounds.
+        const double lower = freq / ( k + mSpread );
+        const double upper = k > mSpread ? freq / ( k - mSpread ) : HUGE_VAL;
+
+        // Find the lowest fundamental above the lower bound.
+        std::vector< double >::const_iterator itr =
+            std::upper_bound( mFundamentals.begin(), mFundamentals.end(), lower );
+
+        // If it's below the upper bound, we've got a match.
+        if( mFundamentals.end() != itr && *itr < upper )
+            return k - 1;
+    }
+
+    return -1;
+}
+
+int Harmonics::scan( double freq ) const
 {
     std::vector< double >::const_iterator cur, end;
     cur = mFundamentals.begin();
@@ -35,17 +98,9 @@ unsigned int Harmonics::get( double freq )
         int k = ratio + 0.5;
 
         // If the error is small enough, return the ratio.
-        if( tolerance() > 10 * ::log10( ::fabs( ratio - k ) ) )
+        if( 0 < k && ::fabs( ratio - k ) < mSpread )
             return k - 1;
     }
 
-    // Add a new fundamental.
-    mFundamentals.push_back( freq );
-    return 0;
-}
-
-void Harmonics::clear()
-{
-    // Clear fundamentals.
-    mFundamentals.clear();
+    return -1;
 }
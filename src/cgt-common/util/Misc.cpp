@@ -22,3 +22,12 @@ double util::normalize( double value, double period )
     int k = ( value + ::copysign( period / 2, value ) ) / period;
     return value -= k * period;
 }
+
+uint64 util::monotonicTime()
+{
+    // Served by the vDSO, no syscall.
+    struct timespec ts;
+    ::clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return uint64( ts.tv_sec ) * 1000000000 + ts.tv_nsec;
+}
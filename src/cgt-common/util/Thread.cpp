@@ -0,0 +1,107 @@
+/**
+ * @file util/Thread.cpp
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#include "cgt-common.h"
+
+#include "util/Thread.h"
+
+using namespace cgt;
+using namespace cgt::util;
+
+/*************************************************************************/
+/* cgt::util::Thread                                                     */
+/*************************************************************************/
+Thread::Thread( IRunnable& runnable )
+: mRunnable( runnable ),
+  mStarted( false ),
+  mRunning( false ),
+  mStopRequested( false ),
+  mFailed( false )
+{
+}
+
+Thread::~Thread()
+{
+    try
+    {
+        // Don't leave the thread behind.
+        stop();
+    }
+    catch( const except::Exception& )
+    {
+        // Nobody to tell about it anymore.
+    }
+}
+
+void Thread::start()
+{
+    // Make sure we're not running already.
+    if( mStarted )
+        throw except::LogicError( "Thread already started" );
+
+    mRunning       = true;
+    mStopRequested = false;
+    mFailed        = false;
+
+    // Create the thread.
+    int code = ::pthread_create( &mThread, NULL, &Thread::routine, this );
+    if( 0 != code )
+    {
+        mRunning = false;
+
+        throw except::RuntimeError(
+            ::ssprintf( "Failed to create thread: %s", ::strerror( code ) ) );
+    }
+
+    mStarted = true;
+}
+
+void Thread::stop()
+{
+    // Check if there's anything to stop.
+    if( !mStarted )
+        return;
+
+    // Ask the runnable to return ...
+    requestStop();
+    // ... and wait for it.
+    ::pthread_join( mThread, NULL );
+
+    mStarted = false;
+
+    // Pass the error on.
+    if( mFailed )
+    {
+        mFailed = false;
+        throw except::RuntimeError( mError );
+    }
+}
+
+void* Thread::routine( void* arg )
+{
+    Thread* thread = static_cast< Thread* >( arg );
+
+    try
+    {
+        // Run the code.
+        thread->mRunnable.run( *thread );
+    }
+    catch( const except::Exception& e )
+    {
+        // Save the error for stop().
+        thread->mError  = e.what();
+        thread->mFailed = true;
+    }
+
+    // Let the others know we're done.
+    __sync_synchronize();
+    thread->mRunning = false;
+
+    return NULL;
+}
@@ -39,11 +39,11 @@ const int Tone::CENTS_PER_NOTE   = 100;
 const int    Tone::A4_INDEX = NOTE_A + 4 * NOTES_PER_OCTAVE;
 const double Tone::A4_FREQ  = 440.0;
 
-Tone::Tone( double freq )
+Tone::Tone( double freq, double a4Freq )
 : mFrequency( freq )
 {
     // Calculate index of the note
-    double index  = A4_INDEX + NOTES_PER_OCTAVE * ::log2( freq / A4_FREQ );
+    double index  = A4_INDEX + NOTES_PER_OCTAVE * ::log2( freq / a4Freq );
 
     // Split note/cents
     mCents  = CENTS_PER_NOTE * ::modf( index, &index );
@@ -68,7 +68,7 @@ Tone::Tone( double freq )
     mNote = static_cast< Note>( note );
 }
 
-Tone::Tone( Note note, double cents, int octave )
+Tone::Tone( Note note, double cents, int octave, double a4Freq )
 : mNote( note ),
   mCents( cents ),
   mOctave( octave )
@@ -77,7 +77,7 @@ Tone::Tone( Note note, double cents, int octave )
     const double index = octave * NOTES_PER_OCTAVE + note + cents / CENTS_PER_NOTE;
 
     // Compute the frequency
-    mFrequency = A4_FREQ * ::pow( 2, double( index - A4_INDEX ) / NOTES_PER_OCTAVE );
+    mFrequency = a4Freq * ::pow( 2, double( index - A4_INDEX ) / NOTES_PER_OCTAVE );
 }
 
 void Tone::getName( char* name, size_t len ) const
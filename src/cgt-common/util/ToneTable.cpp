@@ -0,0 +1,123 @@
+/**
+ * @file util/ToneTable.cpp
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#include "cgt-common.h"
+
+#include "util/ToneTable.h"
+
+using namespace cgt;
+using namespace cgt::util;
+
+/*************************************************************************/
+/* cgt::util::ToneTable                                                  */
+/*************************************************************************/
+const size_t ToneTable::LOG_TABLE_SIZE = 1024;
+
+const int ToneTable::MIN_OCTAVE = -1;
+const int ToneTable::MAX_OCTAVE = 10;
+
+ToneTable::ToneTable( double a4Freq )
+: mReference( a4Freq ),
+  mLog2( LOG_TABLE_SIZE + 1 )
+{
+    // Make sure the reference is sane.
+    if( !( 0 < a4Freq ) )
+        throw except::InvalidArgument(
+            ::ssprintf( "Invalid reference frequency (%f Hz)", a4Freq ) );
+
+    // Tabulate the mantissa range [1, 2].
+    for( size_t i = 0; i <= LOG_TABLE_SIZE; ++i )
+        mLog2[ i ] = ::log2( 1 + double( i ) / LOG_TABLE_SIZE );
+
+    // Exact here, it's used for every tone.
+    mOffset = Tone::A4_INDEX - Tone::NOTES_PER_OCTAVE * ::log2( a4Freq );
+
+    // Print the name prefixes (ssprintf keeps the terminator, strip it).
+    for( int octave = MIN_OCTAVE; octave <= MAX_OCTAVE; ++octave )
+    {
+        for( int note = 0; note < Tone::NOTES_PER_OCTAVE; ++note )
+            mNames.push_back( ::ssprintf( "%s%d.", Tone::NOTE_NAMES[ note ], octave ).c_str() );
+    }
+}
+
+Tone ToneTable::get( double freq ) const
+{
+    // Fall back to the math library for nonsense.
+    if( !( 0 < freq ) || HUGE_VAL == freq )
+        return Tone( freq, reference() );
+
+    // Calculate index of the note
+    const double index   = mOffset + Tone::NOTES_PER_OCTAVE * log2( freq );
+    const double nearest = ::floor( index + 0.5 );
+
+    // Split note/octave
+    int note   = nearest;
+    int octave = ( 0 <= note ? note : note - Tone::NOTES_PER_OCTAVE + 1 )
+                 / Tone::NOTES_PER_OCTAVE;
+    note -= octave * Tone::NOTES_PER_OCTAVE;
+
+    Tone tone;
+    tone.mFrequency = freq;
+    tone.mNote      = static_cast< Tone::Note >( note );
+    tone.mCents     = Tone::CENTS_PER_NOTE * ( index - nearest );
+    tone.mOctave    = octave;
+
+    return tone;
+}
+
+void ToneTable::getName( const Tone& tone, char* name, size_t len ) const
+{
+    // Tenths of a cent, rounded.
+    const unsigned int tenths = ::fabs( tone.cents() ) * 10 + 0.5;
+
+    // Fall back to the printf-based formatting outside of the cache.
+    if( tone.octave() < MIN_OCTAVE || MAX_OCTAVE < tone.octave() || 1000 <= tenths )
+    {
+        tone.getName( name, len );
+        return;
+    }
+
+    const std::string& prefix =
+        mNames[ ( tone.octave() - MIN_OCTAVE ) * Tone::NOTES_PER_OCTAVE + tone.note() ];
+
+    // Format cents the same way as "%+05.1f".
+    char buf[ 0x20 ];
+    char* cur = std::copy( prefix.begin(), prefix.end(), buf );
+
+    *cur++ = 0 > ::copysign( 1, tone.cents() ) ? '-' : '+';
+    *cur++ = '0' + tenths / 100;
+    *cur++ = '0' + tenths / 10 % 10;
+    *cur++ = '.';
+    *cur++ = '0' + tenths % 10;
+    *cur   = '\0';
+
+    // Copy as much as fits, like snprintf does.
+    if( 0 < len )
+    {
+        const size_t count = std::min< size_t >( cur - buf, len - 1 );
+
+        ::memcpy( name, buf, count );
+        name[ count ] = '\0';
+    }
+}
+
+double ToneTable::log2( double x ) const
+{
+    // Split into mantissa [0.5, 1) and exponent.
+    int exponent;
+    const double mantissa = ::frexp( x, &exponent );
+
+    // Locate the mantissa [1, 2) in the table.
+    const double pos   = ( 2 * mantissa - 1 ) * LOG_TABLE_SIZE;
+    const size_t index = pos;
+    const double frac  = pos - index;
+
+    // Interpolate between the neighbours.
+    return exponent - 1 + mLog2[ index ] + frac * ( mLog2[ index + 1 ] - mLog2[ index ] );
+}
@@ -0,0 +1,281 @@
+/**
+ * @file util/Tracer.cpp
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#include "cgt-common.h"
+
+#include "util/Misc.h"
+#include "util/Tracer.h"
+
+using namespace cgt;
+using namespace cgt::util;
+
+/*************************************************************************/
+/* cgt::util::Tracer                                                     */
+/*************************************************************************/
+__thread Tracer::Ring*       Tracer::mThreadRing = NULL;
+__thread const char*         Tracer::mThreadName = NULL;
+
+std::auto_ptr< Tracer > Tracer::mInstance( NULL );
+pthread_once_t          Tracer::mInstanceOnce = PTHREAD_ONCE_INIT;
+
+Tracer& Tracer::get()
+{
+    ::pthread_once( &mInstanceOnce, &Tracer::create );
+    return *mInstance;
+}
+
+Tracer::Tracer()
+: mRingSize( 0 ),
+  mEnabled( false ),
+  mStream( NULL )
+{
+    ::pthread_mutex_init( &mMutex, NULL );
+}
+
+Tracer::~Tracer()
+{
+    // Stream the rest, nobody records anymore.
+    if( NULL != mStream )
+    {
+        try
+        {
+            save();
+        }
+        catch( const except::Exception& )
+        {
+            // Nothing to be done about it here.
+        }
+
+        ::fclose( mStream );
+    }
+
+    // Free the rings.
+    std::vector< Ring* >::iterator cur, end;
+    cur = mRings.begin();
+    end = mRings.end();
+    for(; cur != end; ++cur )
+    {
+        util::safeDeleteArray( ( *cur )->events );
+        util::safeDelete( *cur );
+    }
+
+    ::pthread_mutex_destroy( &mMutex );
+}
+
+void Tracer::start( const char* path, size_t ringSize, bool stream )
+{
+    // Make sure it's started once.
+    if( mEnabled )
+        throw except::LogicError( "Tracer already started" );
+    if( 0 == ringSize )
+        throw except::InvalidArgument( "Invalid trace ring size (0)" );
+
+    if( stream )
+    {
+        mStream = ::fopen( path, "w" );
+        // Check for error
+        if( NULL == mStream )
+            throw except::RuntimeError(
+                ::ssprintf( "Failed to open trace '%s': %s",
+                            path, ::strerror( errno ) ) );
+
+        // The array format, it may be left unterminated.
+        ::fputs( "[\n", mStream );
+    }
+
+    mPath     = path;
+    mRingSize = ringSize;
+    mEnabled  = true;
+}
+
+void Tracer::startFromSettings( const config::Settings& settings )
+{
+    // Not asked to?
+    if( settings.tracePath.empty() )
+        return;
+
+#ifdef CGT_PROFILE
+    const std::string& mode = settings.traceMode;
+    if( "snapshot" != mode && "stream" != mode )
+        throw except::InvalidArgument(
+            ::ssprintf( "Unknown trace mode '%s'", mode.c_str() ) );
+
+    start( settings.tracePath.c_str(), settings.traceRingSize,
+           "stream" == mode );
+#else /* CGT_PROFILE */
+    throw except::InvalidArgument( "Tracing needs a build with CGT_PROFILE" );
+#endif /* CGT_PROFILE */
+}
+
+void Tracer::save()
+{
+    // Nothing to save?
+    if( !mEnabled )
+        return;
+
+    // A snapshot replaces the previous one at once.
+    const std::string tmpPath = mPath + ".tmp";
+    FILE* file = mStream;
+    if( NULL == file )
+    {
+        file = ::fopen( tmpPath.c_str(), "w" );
+        // Check for error
+        if( NULL == file )
+            throw except::RuntimeError(
+                ::ssprintf( "Failed to open trace '%s': %s",
+                            tmpPath.c_str(), ::strerror( errno ) ) );
+
+        ::fputs( "[\n", file );
+    }
+
+    ::pthread_mutex_lock( &mMutex );
+
+    const int pid = ::getpid();
+    for( size_t i = 0; i < mRings.size(); ++i )
+    {
+        Ring& ring = *mRings[ i ];
+
+        // Name the thread first.
+        if( NULL == mStream || !ring.announced )
+        {
+            ::fprintf( file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,"
+                             "\"tid\":%u,\"args\":{\"name\":\"%s\"}},\n",
+                       pid, ring.id, ring.name );
+            ring.announced = true;
+        }
+
+        // Stream only what's new.
+        if( NULL == mStream )
+            write( file, ring, 0 );
+        else
+            ring.saved = write( file, ring, ring.saved );
+    }
+
+    ::pthread_mutex_unlock( &mMutex );
+
+    // Terminate a snapshot properly.
+    if( NULL == mStream )
+        ::fprintf( file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,"
+                         "\"args\":{\"name\":\"cgt\"}}\n]\n", pid );
+
+    bool failed = 0 != ::fflush( file ) || 0 != ::ferror( file );
+    if( NULL == mStream )
+        failed = 0 != ::fclose( file ) || failed;
+
+    // Check for error
+    if( failed )
+        throw except::RuntimeError(
+            ::ssprintf( "Failed to write trace '%s'", mPath.c_str() ) );
+
+    if( NULL == mStream && 0 != ::rename( tmpPath.c_str(), mPath.c_str() ) )
+        throw except::RuntimeError(
+            ::ssprintf( "Failed to replace trace '%s': %s",
+                        mPath.c_str(), ::strerror( errno ) ) );
+}
+
+void Tracer::record( char phase, const char* name, uint64 time )
+{
+    // Not recording?
+    if( !mEnabled )
+        return;
+
+    Ring* ring = mThreadRing;
+    if( NULL == ring )
+        ring = attach();
+
+    // Only this thread writes the ring, publish the event after it's filled.
+    const uint64 head = ring->head;
+    Event& event = ring->events[ head % mRingSize ];
+    event.time  = time;
+    event.name  = name;
+    event.phase = phase;
+
+    __sync_synchronize();
+    ring->head = head + 1;
+}
+
+void Tracer::nameThread( const char* name )
+{
+    mThreadName = name;
+
+    if( NULL != mThreadRing )
+        mThreadRing->name = name;
+    else if( mEnabled )
+        attach();
+}
+
+void Tracer::create()
+{
+    mInstance.reset( new Tracer );
+}
+
+Tracer::Ring* Tracer::attach()
+{
+    std::auto_ptr< Ring > ring( new Ring );
+    ring->name      = NULL != mThreadName ? mThreadName : "Thread";
+    ring->announced = false;
+    ring->events    = new Event[ mRingSize ];
+    ring->head      = 0;
+    ring->saved     = 0;
+
+    ::pthread_mutex_lock( &mMutex );
+
+    ring->id = mRings.size() + 1;
+    mRings.push_back( ring.get() );
+
+    ::pthread_mutex_unlock( &mMutex );
+
+    return mThreadRing = ring.release();
+}
+
+uint64 Tracer::write( FILE* file, const Ring& ring, uint64 start )
+{
+    // The writer keeps going, take what's there now.
+    const uint64 head = ring.head;
+    __sync_synchronize();
+
+    // The slot of the next event, the oldest one's, may be half-written.
+    const uint64 oldest = mRingSize <= head ? head - mRingSize + 1 : 0;
+    const uint64 first  = std::max( start, oldest );
+
+    mScratch.resize( head - first );
+    for( uint64 i = first; i < head; ++i )
+        mScratch[ i - first ] = ring.events[ i % mRingSize ];
+
+    // Re-check the head, dropping whatever got overwritten while
+    // copying, including the slot the writer may be filling now.
+    __sync_synchronize();
+    const uint64 now   = ring.head;
+    const uint64 valid = std::max( first, mRingSize <= now ? now - mRingSize + 1 : 0 );
+
+    const int pid = ::getpid();
+    for( uint64 i = valid; i < head; ++i )
+    {
+        const Event& event = mScratch[ i - first ];
+        ::fprintf( file, "{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,"
+                         "\"pid\":%d,\"tid\":%u},\n",
+                   event.name, event.phase, event.time / 1e3, pid, ring.id );
+    }
+
+    return head;
+}
+
+/*************************************************************************/
+/* cgt::util::Tracer::Scope                                              */
+/*************************************************************************/
+Tracer::Scope::Scope( const char* name )
+: mName( name )
+{
+    sTracer.record( 'B', mName, util::monotonicTime() );
+}
+
+Tracer::Scope::~Scope()
+{
+    sTracer.record( 'E', mName, util::monotonicTime() );
+}
@@ -12,50 +12,71 @@
 #include "curses/LibInit.h"
 #include "curses/Screen.h"
 
+/**
+ * @brief Loads the configuration.
+ *
+ * @param[in] config The config manager to load into.
+ * @param[in] argc   Number of arguments.
+ * @param[in] argv   The array of arguments.
+ */
+static void loadConfig( config::ConfigMgr& config, int argc, char* argv[] )
+{
+    // Load config
+    config::ArgvParser argvParser( config );
+    argvParser.addConfig();
+    argvParser.addHelp();
+
+    // Define value options
+    argvParser.addValue( 'D', "device", "cgt.pcm.device",
+                         "Name of ALSA device to use" );
+    argvParser.addValue( 'r', "rate", "cgt.pcm.rate",
+                         "Sample rate to use" );
+    argvParser.addValue( 'B', "buffer-size", "cgt.bufferSize",
+                         "Buffer size to use" );
+    argvParser.addValue( 'C', "capture-size", "cgt.captureSize",
+                         "Capture size to use" );
+    argvParser.addValue( 'a', "analyser", "cgt.analyser",
+                         "Analyser to use (fft, yin or cq)" );
+    argvParser.addValue( 'g', "gate", "cgt.gate.threshold",
+                         "Input level below which analysis is skipped, in dB" );
+    argvParser.addValue( 'm', "mag-cutoff", "cgt.fft.magnitudeCutoff",
+                         "Magnitude cutoff value when using FFT" );
+    argvParser.addValue( 'H', "harm-tol", "cgt.fft.harmonicTolerance",
+                         "Harmonic tolerance value" );
+    argvParser.addValue( 'P', "pitch-harm", "cgt.fft.pitchHarmonics",
+                         "Number of harmonics for pitch detection, 0 to disable" );
+    argvParser.addValue( 'f', "floor-margin", "cgt.fft.floorMargin",
+                         "Margin above the noise floor when using FFT, in dB" );
+    argvParser.addValue( 'k', "max-peaks", "cgt.fft.maxPeaks",
+                         "Maximal number of peaks per frame when using FFT, 0 for all" );
+    argvParser.addValue( 'y', "yin-thres", "cgt.yin.threshold",
+                         "Absolute threshold when using YIN" );
+    argvParser.addValue( 'b', "cq-bins", "cgt.cq.binsPerOctave",
+                         "Bins per octave when using constant-Q" );
+    argvParser.addValue( 'o', "track", "cgt.track.path",
+                         "File to record the pitch track to" );
+    argvParser.addValue( 'T', "trace", "cgt.trace.path",
+                         "File to save the trace of the analysis to" );
+    argvParser.addValue( 'W', "trace-mode", "cgt.trace.mode",
+                         "How to save the trace (snapshot or stream)" );
+    argvParser.addValue( 'F', "max-fps", "cgt.curses.maxFps",
+                         "Maximal number of screen updates per second" );
+    argvParser.addValue( 'R', "reference", "cgt.tune.reference",
+                         "Reference frequency of note A4" );
+    argvParser.addValue( 't', "tune-tol", "cgt.tune.tolerance",
+                         "Tuning tolerance, +/- in cents" );
+    argvParser.addValue( 'M', "mag-span", "cgt.tune.magSpan",
+                         "Span of the magnitude lever bar" );
+
+    // Parse arg vector
+    argvParser.parse( argc, argv );
+}
+
 int main( int argc, char* argv[] )
 {
     try
     {
-        // Load default configuration
-        sConfigMgr[ "cgt.bufferSize"  ] = 16384;
-        sConfigMgr[ "cgt.captureSize" ] = 4096;
-
-        sConfigMgr[ "cgt.pcm.device" ] = "plughw:0,0";
-        sConfigMgr[ "cgt.pcm.rate"   ] = 48000;
-
-        sConfigMgr[ "cgt.fft.magnitudeCutoff"   ] = -30.0;
-        sConfigMgr[ "cgt.fft.harmonicTolerance" ] = -6.0;
-
-        sConfigMgr[ "cgt.tune.tolerance" ] = 3.0;
-        sConfigMgr[ "cgt.tune.magSpan"   ] = 12.0;
-
-        // Load config
-        config::ArgvParser argvParser;
-        argvParser.addConfig();
-        argvParser.addHelp();
-
-        // Define value options
-        argvParser.addValue( 'D', "device", "cgt.pcm.device",
-                             "Name of ALSA device to use" );
-        argvParser.addValue( 'r', "rate", "cgt.pcm.rate",
-                             "Sample rate to use" );
-        argvParser.addValue( 'B', "buffer-size", "cgt.bufferSize",
-                             "Buffer size to use" );
-        argvParser.addValue( 'C', "capture-size", "cgt.captureSize",
-                             "Capture size to use" );
-        argvParser.addValue( 'm', "mag-cutoff", "cgt.fft.magnitudeCutoff",
-                             "Magnitude cutoff value when using FFT" );
-        argvParser.addValue( 'H', "harm-tol", "cgt.fft.harmonicTolerance",
-                             "Harmonic tolerance value" );
-        argvParser.addValue( 't', "tune-tol", "cgt.tune.tolerance",
-                             "Tuning tolerance, +/- in cents" );
-        argvParser.addValue( 'M', "mag-span", "cgt.tune.magSpan",
-                             "Span of the magnitude lever bar" );
-
-        // Parse arg vector
-        unsigned int code = argvParser.parse( argc, argv );
-        argc -= code;
-        argv += code;
+        loadConfig( sConfigMgr, argc, argv );
     }
     catch( const except::GracefulExit& e )
     {
@@ -69,8 +90,18 @@ int main( int argc, char* argv[] )
         return EXIT_FAILURE;
     }
 
+    // Reported once curses is gone
+    std::string latency, reloadError;
+
     try
     {
+        // Parse the configuration once
+        config::Settings settings( sConfigMgr );
+
+        // Record a timeline if asked to
+        sTracer.startFromSettings( settings );
+        sTracer.nameThread( "Render" );
+
         // Init curses screen
         curses::LibInit curs;
         curs.cBreak();
@@ -85,19 +116,106 @@ int main( int argc, char* argv[] )
         getmaxyx( stdscr, height, width );
 
         // Allocate the necessary classes
-        curses::Screen scr( 0, 0, width, height );
-        core::FftAnalyser analyser( scr, sConfigMgr[ "cgt.fft.magnitudeCutoff" ] );
+        curses::Screen scr( settings, 0, 0, width, height );
+        std::auto_ptr< track::TrackWriter > recorder;
+        core::ObserverBus bus( settings.busMaxPeaks );
+        std::auto_ptr< core::Analyser > analyser;
+
+        // The screen picks the latest frame anyway, let it drop the rest
+        bus.subscribe( scr, settings.busQueueSize,
+                       core::ObserverBus::POLICY_DROP_OLDEST );
+
+        // The track must not miss any frame
+        const std::string& trackPath = settings.trackPath;
+        if( !trackPath.empty() )
+        {
+            const std::string indexPath = trackPath + ".idx";
+            recorder.reset( new track::TrackWriter( trackPath.c_str(), indexPath.c_str() ) );
+            bus.subscribe( *recorder, settings.trackQueueSize,
+                           core::ObserverBus::POLICY_BLOCK );
+        }
+
+        // Make the requested analyser
+        core::AnalyserFactory factory( settings );
+        analyser.reset( factory.create( bus ) );
+        scr.follow( *analyser );
 
         // Initialize the process
-        analyser.init( sConfigMgr[ "cgt.pcm.device" ],
-                       sConfigMgr[ "cgt.pcm.rate" ],
-                       sConfigMgr[ "cgt.bufferSize" ],
-                       sConfigMgr[ "cgt.captureSize" ] );
+        analyser->init( settings.pcmDevice.c_str(),
+                        settings.pcmRate,
+                        settings.bufferSize,
+                        settings.captureSize );
+
+        // Make sure the frame rate is sane
+        const unsigned int maxFps = settings.cursesMaxFps;
+        if( 0 == maxFps || 1000 < maxFps )
+            throw except::InvalidArgument(
+                ::ssprintf( "Invalid frame rate (%u)", maxFps ) );
+
+        // Run the subscribers ...
+        bus.start();
+        // ... and the analysis in the background
+        util::Thread analysis( *analyser );
+        analysis.start();
+
+        // Waiting for a key paces the rendering
+        curs.setTimeout( 1000 / maxFps );
 
         // Main loop
-        while( 'q' != ::getch() )
-            // Run the step
-            analyser.step();
+        int key;
+        while( 'q' != ( key = ::getch() ) && analysis.running() )
+        {
+#ifdef CGT_PROFILE
+            // Show where the time goes
+            if( 'p' == key )
+                scr.toggleProfile( *analyser );
+#endif /* CGT_PROFILE */
+
+            // Keep the stream going, take a snapshot only when asked
+            if( sTracer.streaming() || 't' == key )
+                sTracer.save();
+
+            // Reload the configuration, keeping the pipeline running
+            if( 'r' == key )
+            {
+                try
+                {
+                    config::ConfigMgr config;
+                    loadConfig( config, argc, argv );
+
+                    const config::Settings next( config );
+                    core::AnalyserFactory( next ).reconfigure( *analyser, settings );
+                    settings = next;
+
+                    scr.reload();
+                }
+                catch( const except::Exception& e )
+                {
+                    // Nowhere to print it now
+                    reloadError = e.what();
+                    ::beep();
+                }
+            }
+
+            // Free what the analysis is done with
+            analyser->reclaim();
+
+            // Draw the latest frame
+            scr.render();
+        }
+
+        // Stop the analysis and subscribers, reporting their errors
+        analysis.stop();
+        bus.stop();
+
+        // Report errors of the last block too
+        if( NULL != recorder.get() )
+            recorder->close();
+
+        // Save the end of the timeline
+        sTracer.save();
+
+        latency = scr.latency().summary();
     }
     catch( const except::Exception& e )
     {
@@ -106,5 +224,9 @@ int main( int argc, char* argv[] )
         return EXIT_FAILURE;
     }
 
+    if( !reloadError.empty() )
+        ::fprintf( stderr, "Failed to reload configuration: %s\n", reloadError.c_str() );
+
+    ::fprintf( stderr, "Latency: %s\n", latency.c_str() );
     return EXIT_SUCCESS;
 }
@@ -17,8 +17,10 @@ using namespace cgt::curses;
 /*************************************************************************/
 /* cgt::curses::ConfigList                                               */
 /*************************************************************************/
-ConfigList::ConfigList( int xpos, int ypos, int width, int height )
-: Window( xpos, ypos, width, height )
+ConfigList::ConfigList( const config::Settings& settings,
+                        int xpos, int ypos, int width, int height )
+: Window( xpos, ypos, width, height ),
+  mSettings( settings )
 {
     // Init our color pair
     ::init_pair( PAIR_CONFIG, COLOR_YELLOW, -1 );
@@ -30,16 +32,17 @@ ConfigList::ConfigList( int xpos, int ypos, int width, int height )
 void ConfigList::refresh()
 {
     // Print all lines
-    addLine( 0, "Device:             ", sConfigMgr[ "cgt.pcm.device"            ] );
-    addLine( 1, "Rate:               ", sConfigMgr[ "cgt.pcm.rate"              ] );
-    addLine( 2, "Buffer size:        ", sConfigMgr[ "cgt.bufferSize"            ] );
-    addLine( 3, "Capture size:       ", sConfigMgr[ "cgt.captureSize"           ] );
-    addLine( 4, "Magnitude cutoff:   ", sConfigMgr[ "cgt.fft.magnitudeCutoff"   ] );
-    addLine( 5, "Harmonic tolerance: ", sConfigMgr[ "cgt.fft.harmonicTolerance" ] );
-    addLine( 6, "Tune tolerance:     ", sConfigMgr[ "cgt.tune.tolerance"        ] );
-    addLine( 7, "Magnitude bar span: ", sConfigMgr[ "cgt.tune.magSpan"          ] );
+    addLine( 0, "Device:             ", mSettings.pcmDevice.c_str() );
+    addLine( 1, "Rate:               ", ::ssprintf( "%u", mSettings.pcmRate ).c_str() );
+    addLine( 2, "Buffer size:        ", ::ssprintf( "%u", mSettings.bufferSize ).c_str() );
+    addLine( 3, "Capture size:       ", ::ssprintf( "%u", mSettings.captureSize ).c_str() );
+    addLine( 4, "Magnitude cutoff:   ", ::ssprintf( "%g", mSettings.fftMagnitudeCutoff ).c_str() );
+    addLine( 5, "Harmonic tolerance: ", ::ssprintf( "%g", mSettings.fftHarmonicTolerance ).c_str() );
+    addLine( 6, "Tune tolerance:     ", ::ssprintf( "%g", mSettings.tuneTolerance ).c_str() );
+    addLine( 7, "Magnitude bar span: ", ::ssprintf( "%g", mSettings.tuneMagSpan ).c_str() );
 
-    // Refresh the window
+    // Repaint all of it, it may have been covered
+    touch();
     Window::noutRefresh();
 }
 
@@ -16,10 +16,11 @@ using namespace cgt::curses;
 /*************************************************************************/
 /* cgt::curses::MagnitudeBar                                             */
 /*************************************************************************/
-MagnitudeBar::MagnitudeBar( int xpos, int ypos, int width, int height )
+MagnitudeBar::MagnitudeBar( const config::Settings& settings,
+                            int xpos, int ypos, int width, int height )
 : Window( xpos, ypos, width, height ),
-  mCutoff( sConfigMgr[ "cgt.fft.magnitudeCutoff" ] ),
-  mSpan( sConfigMgr[ "cgt.tune.magSpan" ] )
+  mCutoff( settings.fftMagnitudeCutoff ),
+  mSpan( settings.tuneMagSpan )
 {
     // Init our colors
     ::init_pair( PAIR_MAGBAR, COLOR_WHITE, -1 );
@@ -24,11 +24,11 @@ NoteList::NoteList( int xpos, int ypos, int width, int height )
     ::init_pair( PAIR_FUNDAMENTAL, COLOR_RED, -1 );
 }
 
-void NoteList::print( const util::Tone& tone, unsigned int harm )
+void NoteList::print( const util::ToneTable& tones, const util::Tone& tone, unsigned int harm )
 {
     // Generate the name
     char name[ 0x20 ];
-    tone.getName( name, sizeof( name ) );
+    tones.getName( tone, name, sizeof( name ) );
 
     unsigned int off  = ::log2( harm + 1 ) + 1;
 
@@ -0,0 +1,126 @@
+/**
+ * @file curses/ProfileList.cpp
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#include "cgt-curses.h"
+
+#include "curses/ProfileList.h"
+
+using namespace cgt;
+using namespace cgt::curses;
+
+#ifdef CGT_PROFILE
+/*************************************************************************/
+/* cgt::curses::ProfileList                                              */
+/*************************************************************************/
+const uint64 ProfileList::UPDATE_PERIOD = 1000000000;
+
+ProfileList::ProfileList( const config::Settings& settings,
+                          int xpos, int ypos, int width, int height )
+: Window( xpos, ypos, width, height ),
+  mBudget( 1e9 * settings.captureSize / settings.pcmRate ),
+  mLastTime( 0 )
+{
+    // Init our color pair
+    ::init_pair( PAIR_CONFIG, COLOR_YELLOW, -1 );
+}
+
+bool ProfileList::refresh( const core::Analyser& analyser, bool force )
+{
+    // Is it time already?
+    const uint64 now = util::monotonicTime();
+    if( !force && now < mLastTime + UPDATE_PERIOD )
+        return false;
+
+    // Keep only what's been recorded since the last update
+    const core::HopProfile& profile = analyser.profile();
+    profile.snapshot( mRecent );
+    mRecent.since( mLast );
+    profile.snapshot( mLast );
+    mLastTime = now;
+
+    // Start from scratch
+    erase();
+    box();
+
+    move( 1, 1 );
+    attrOn( A_BOLD | COLOR_PAIR( PAIR_CONFIG ) );
+    printw( "%-9s %6s %6s %6s", "[us]", "p50", "p99", "max" );
+    attrOff( A_BOLD | COLOR_PAIR( PAIR_CONFIG ) );
+
+    // Print all stages
+    for( unsigned int i = 0; i < core::HopProfile::STAGE_COUNT; ++i )
+    {
+        const stats::Histogram& stage =
+            mRecent.stage( (core::HopProfile::Stage)i );
+
+        addLine( 1 + i, core::HopProfile::STAGE_NAMES[ i ],
+                 stage.percentile( 50 ) / 1e3,
+                 stage.percentile( 99 ) / 1e3,
+                 stage.max() / 1e3 );
+    }
+
+    // Print how much of a hop the analysis takes
+    const stats::Histogram& hop = mRecent.stage( core::HopProfile::STAGE_HOP );
+    addLine( 1 + core::HopProfile::STAGE_COUNT, "Budget %",
+             100 * hop.percentile( 50 ) / mBudget,
+             100 * hop.percentile( 99 ) / mBudget,
+             100 * hop.max() / mBudget );
+
+    // Print the gaps in the capture
+    addLine( 2 + core::HopProfile::STAGE_COUNT, "Gaps",
+             ::ssprintf( "%"PRIu64" (%"PRIu64" short reads)",
+                         analyser.gaps(), analyser.shortReads() ).c_str() );
+
+    // Print the last relock, only the FFT analyser tracks it
+    const core::FftAnalyser* fft =
+        dynamic_cast< const core::FftAnalyser* >( &analyser );
+    addLine( 3 + core::HopProfile::STAGE_COUNT, "Relock",
+             NULL == fft ? "n/a"
+             : ::ssprintf( "%.1f ms", 1e3 * fft->relockTime() ).c_str() );
+
+    // Refresh the window
+    Window::noutRefresh();
+    return true;
+}
+
+void ProfileList::addLine( int line, const char* title, double p50, double p99, double max )
+{
+    // Move the cursor to position (remember our border)
+    move( 1 + line, 1 );
+
+    // Print title
+    attrOn( A_BOLD | COLOR_PAIR( PAIR_CONFIG ) );
+    printw( "%-9s ", title );
+    attrOff( A_BOLD );
+
+    // Print values
+    printw( "%6.1f %6.1f %6.1f", p50, p99, max );
+
+    // Turn off the color
+    attrOff( COLOR_PAIR( PAIR_CONFIG ) );
+}
+
+void ProfileList::addLine( int line, const char* title, const char* value )
+{
+    // Move the cursor to position (remember our border)
+    move( 1 + line, 1 );
+
+    // Print title
+    attrOn( A_BOLD | COLOR_PAIR( PAIR_CONFIG ) );
+    printw( "%-9s ", title );
+    attrOff( A_BOLD );
+
+    // Print the value
+    printw( "%s", value );
+
+    // Turn off the color
+    attrOff( COLOR_PAIR( PAIR_CONFIG ) );
+}
+
+#endif /* CGT_PROFILE */
@@ -16,18 +16,26 @@ using namespace cgt::curses;
 /*************************************************************************/
 /* cgt::curses::Screen                                                   */
 /*************************************************************************/
-Screen::Screen( int xpos, int ypos, int width, int height )
-  // Pull the value from the config manager
-: mHarmonics( sConfigMgr[ "cgt.fft.harmonicTolerance" ] ),
+Screen::Screen( const config::Settings& settings,
+                int xpos, int ypos, int width, int height )
+  // Pull the values from the settings
+: mTones( settings.tuneReference ),
+  mHarmonics( settings.fftHarmonicTolerance ),
+  mAnalyser( NULL ),
   // Carefully positioned elements
-  mConfig( xpos + 2, ypos + height - 11,
+  mConfig( settings, xpos + 2, ypos + height - 11,
            2 * width / 5, 10 ),
-  mMagBar( xpos + width / 16, ypos + height / 8,
+  mMagBar( settings, xpos + width / 16, ypos + height / 8,
            3, 5 * height / 8 ),
   mNotes( xpos + ( width / 3 ) / 2, ypos + height / 2,
           2 * width / 3, height / 4 ),
-  mTuner( xpos + ( width / 3 ) / 2, ypos + height / 16,
+  mTuner( settings, xpos + ( width / 3 ) / 2, ypos + height / 16,
           2 * width / 3, 6 * height / 16 )
+#ifdef CGT_PROFILE
+, mProfileList( settings, xpos + 2, ypos + height - 14,
+                2 * width / 5, 13 ),
+  mProfile( NULL )
+#endif /* CGT_PROFILE */
 {
     // Draw a border around the main window
     ::box( stdscr, 0, 0 );
@@ -42,35 +50,121 @@ Screen::Screen( int xpos, int ypos, int width, int height )
     // Print the config ...
     mConfig.refresh();
     // ... and the rest of the windows
-    end();
+    draw( mFrames.front() );
 }
 
-void Screen::start()
+void Screen::addFrame( const core::Analyser::Frame& frame )
 {
-    // Flush harmonics.
-    mHarmonics.clear();
+    // Record the frame, reusing the back buffer
+    mFrames.back().captured = frame.captured;
+    mFrames.back().delay = frame.delay;
+    mFrames.back().rate = frame.rate;
+    mFrames.back().pitches.assign( frame.pitches, frame.pitches + frame.pitchCount );
+    mFrames.back().peaks.assign( frame.peaks, frame.peaks + frame.peakCount );
+
+    // Hand it over to rendering
+    mFrames.publish();
 }
 
-void Screen::add( double freq, double mag )
+void Screen::render()
 {
-    // Create the tone
-    const util::Tone tone( freq );
-    // Obtain harmonic index
-    const int harm = mHarmonics.get( tone.frequency() );
-
-    // Add magnitude to the bar
-    mMagBar.add( mag );
-    // Add the note to the list
-    mNotes.print( tone, harm );
-
-    // If it's a fundamental ...
-    if( 0 == harm )
-        // .. add to tuner
-        mTuner.add( tone );
+#ifdef CGT_PROFILE
+    // Update the profile once in a while
+    if( NULL != mProfile && mProfileList.refresh( *mProfile ) )
+        ::doupdate();
+#endif /* CGT_PROFILE */
+
+    // Draw only if there's something new
+    if( mFrames.update() )
+        draw( mFrames.front() );
 }
 
-void Screen::end()
+void Screen::reload()
 {
+#ifdef CGT_PROFILE
+    // The profile covers the config
+    if( NULL != mProfile )
+        return;
+#endif /* CGT_PROFILE */
+
+    mConfig.refresh();
+    ::doupdate();
+}
+
+#ifdef CGT_PROFILE
+void Screen::toggleProfile( const core::Analyser& analyser )
+{
+    if( NULL == mProfile )
+    {
+        // Cover the config with the profile
+        mProfile = &analyser;
+        mProfileList.refresh( *mProfile, true );
+    }
+    else
+    {
+        // Uncover the config again
+        mProfile = NULL;
+        ::touchwin( stdscr );
+        ::wnoutrefresh( stdscr );
+        mConfig.refresh();
+    }
+
+    ::doupdate();
+}
+#endif /* CGT_PROFILE */
+
+void Screen::draw( const Frame& frame )
+{
+    CGT_TRACE_SCOPE( "Render" );
+
+    // Flush harmonics and the tuner.
+    mHarmonics.clear();
+    mTuned.clear();
+
+    // Without pitch detection, the fundamentals come from the frequencies
+    const bool pitches = NULL != mAnalyser && mAnalyser->emitsPitches();
+
+    std::vector< Peak >::const_iterator cur, end;
+    cur = frame.pitches.begin();
+    end = frame.pitches.end();
+    for(; cur != end; ++cur )
+    {
+        // Create the tone
+        const util::Tone tone = mTones.get( cur->freq );
+
+        // Seed harmonics with the fundamental
+        mHarmonics.get( tone.frequency() );
+        // Add it to tuner
+        mTuned.push_back( tone );
+    }
+
+    cur = frame.peaks.begin();
+    end = frame.peaks.end();
+    for(; cur != end; ++cur )
+    {
+        // Create the tone
+        const util::Tone tone = mTones.get( cur->freq );
+        // Obtain harmonic index
+        const int harm = mHarmonics.get( tone.frequency() );
+
+        // Add magnitude to the bar
+        mMagBar.add( cur->mag );
+        // Add the note to the list
+        mNotes.print( mTones, tone, harm );
+
+        // If it's a fundamental not covered by pitch detection ...
+        if( 0 == harm && !pitches )
+            // .. add to tuner
+            mTuned.push_back( tone );
+    }
+
+    // Put the fundamentals on the tuner
+    std::vector< util::Tone >::const_iterator curTone, endTone;
+    curTone = mTuned.begin();
+    endTone = mTuned.end();
+    for(; curTone != endTone; ++curTone )
+        mTuner.add( mTones, *curTone );
+
     // Print the magnitude bar
     mMagBar.refresh();
     // Print the notes
@@ -80,4 +174,8 @@ void Screen::end()
 
     // Do the update
     ::doupdate();
+
+    // It's on the terminal now
+    mLatency.add( frame.captured, frame.delay, frame.rate,
+                  util::monotonicTime() );
 }
@@ -16,9 +16,10 @@ using namespace cgt::curses;
 /*************************************************************************/
 /* cgt::curses::TunerBar                                                 */
 /*************************************************************************/
-TunerBar::TunerBar( int xpos, int ypos, int width, int height )
+TunerBar::TunerBar( const config::Settings& settings,
+                    int xpos, int ypos, int width, int height )
 : Window( xpos, ypos, width, height ),
-  mTuneTolerance( sConfigMgr[ "cgt.tune.tolerance" ] )
+  mTuneTolerance( settings.tuneTolerance )
 {
     // Initialize our color pair
     ::init_pair( PAIR_TUNER_GOOD, COLOR_GREEN,  -1 );
@@ -26,15 +27,11 @@ TunerBar::TunerBar( int xpos, int ypos, int width, int height )
     ::init_pair( PAIR_TUNER_DESC, COLOR_YELLOW, -1 );
 }
 
-void TunerBar::add( const util::Tone& tone )
+void TunerBar::add( const util::ToneTable& tones, const util::Tone& tone )
 {
     // Obtain name of the note
     char name[ 0x20 ];
-    tone.getName( name, sizeof( name ) );
-
-    // Obtain min and max frequencies
-    const util::Tone toneMin( tone.note(), -50, tone.octave() );
-    const util::Tone toneMax( tone.note(), +50, tone.octave() );
+    tones.getName( tone, name, sizeof( name ) );
 
     // Determine exactness
     const bool exact = ( ::fabs( tone.cents() ) <= mTuneTolerance );
@@ -52,10 +49,10 @@ void TunerBar::add( const util::Tone& tone )
     mvwhline( mWindow, height - 4, 1, '-', width - 2 );
     mvwhline( mWindow, height - 3, 1, '-', width - 2 );
 
-    // Locate the marker
+    // Locate the marker, the bar spans +/- half a note
     int mark = 1.5 + ( width - 3 )
-        * ( tone.frequency()    - toneMin.frequency() )
-        / ( toneMax.frequency() - toneMin.frequency() );
+        * ( tone.cents() + util::Tone::CENTS_PER_NOTE / 2 )
+        / util::Tone::CENTS_PER_NOTE;
 
     // Draw the colorized markers
     attrOn( COLOR_PAIR( exact ? PAIR_TUNER_GOOD : PAIR_TUNER_BAD ) );
@@ -0,0 +1,221 @@
+/**
+ * @file cgt-daemon.cpp
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#include "cgt-daemon.h"
+
+#include "server/StreamServer.h"
+
+/**
+ * @brief Loads the configuration.
+ *
+ * @param[in] config The config manager to load into.
+ * @param[in] argc   Number of arguments.
+ * @param[in] argv   The array of arguments.
+ */
+static void loadConfig( config::ConfigMgr& config, int argc, char* argv[] )
+{
+    // Load config
+    config::ArgvParser argvParser( config );
+    argvParser.addConfig();
+    argvParser.addHelp();
+
+    // Define value options
+    argvParser.addValue( 'D', "device", "cgt.pcm.device",
+                         "Name of ALSA device to use" );
+    argvParser.addValue( 'r', "rate", "cgt.pcm.rate",
+                         "Sample rate to use" );
+    argvParser.addValue( 'B', "buffer-size", "cgt.bufferSize",
+                         "Buffer size to use" );
+    argvParser.addValue( 'C', "capture-size", "cgt.captureSize",
+                         "Capture size to use" );
+    argvParser.addValue( 'a', "analyser", "cgt.analyser",
+                         "Analyser to use (fft, yin or cq)" );
+    argvParser.addValue( 'g', "gate", "cgt.gate.threshold",
+                         "Input level below which analysis is skipped, in dB" );
+    argvParser.addValue( 'm', "mag-cutoff", "cgt.fft.magnitudeCutoff",
+                         "Magnitude cutoff value when using FFT" );
+    argvParser.addValue( 'P', "pitch-harm", "cgt.fft.pitchHarmonics",
+                         "Number of harmonics for pitch detection, 0 to disable" );
+    argvParser.addValue( 'f', "floor-margin", "cgt.fft.floorMargin",
+                         "Margin above the noise floor when using FFT, in dB" );
+    argvParser.addValue( 'k', "max-peaks", "cgt.fft.maxPeaks",
+                         "Maximal number of peaks per frame when using FFT, 0 for all" );
+    argvParser.addValue( 'y', "yin-thres", "cgt.yin.threshold",
+                         "Absolute threshold when using YIN" );
+    argvParser.addValue( 'b', "cq-bins", "cgt.cq.binsPerOctave",
+                         "Bins per octave when using constant-Q" );
+    argvParser.addValue( 'S', "socket", "cgt.daemon.socket",
+                         "Path of the socket to notify clients on" );
+    argvParser.addValue( 'N', "ring", "cgt.daemon.ring",
+                         "Name of the shared memory frame ring" );
+    argvParser.addValue( 'L', "ring-size", "cgt.daemon.ringSize",
+                         "Number of frames kept in the ring" );
+    argvParser.addValue( 'o', "track", "cgt.track.path",
+                         "File to record the pitch track to" );
+    argvParser.addValue( 'T', "trace", "cgt.trace.path",
+                         "File to save the trace of the analysis to" );
+    argvParser.addValue( 'W', "trace-mode", "cgt.trace.mode",
+                         "How to save the trace (snapshot or stream)" );
+
+    // Parse arg vector
+    argvParser.parse( argc, argv );
+}
+
+int main( int argc, char* argv[] )
+{
+    try
+    {
+        loadConfig( sConfigMgr, argc, argv );
+    }
+    catch( const except::GracefulExit& e )
+    {
+        // Gracefully exit, easy enough :-)
+        return EXIT_SUCCESS;
+    }
+    catch( const except::Exception& e )
+    {
+        // Print an error message
+        ::fprintf( stderr, "Failed to setup configuration: %s\n", e.what() );
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        // Leave the signals to the main thread, the others inherit the mask
+        sigset_t signals;
+        ::sigemptyset( &signals );
+        ::sigaddset( &signals, SIGINT );
+        ::sigaddset( &signals, SIGTERM );
+        ::sigaddset( &signals, SIGHUP );
+        ::sigaddset( &signals, SIGUSR1 );
+        ::pthread_sigmask( SIG_BLOCK, &signals, NULL );
+
+        // Parse the configuration once
+        config::Settings settings( sConfigMgr );
+
+        // Record a timeline if asked to
+        sTracer.startFromSettings( settings );
+        sTracer.nameThread( "Main" );
+
+        // Allocate the necessary classes
+        ipc::FrameRing ring( settings.daemonRing.c_str(),
+                             settings.daemonRingSize,
+                             settings.busMaxPeaks );
+        server::StreamServer server( settings.daemonSocket.c_str(), ring );
+        std::auto_ptr< track::TrackWriter > recorder;
+        core::ObserverBus bus( settings.busMaxPeaks );
+        std::auto_ptr< core::Analyser > analyser;
+
+        // Clients catch up on their own, the ring itself gets every frame
+        bus.subscribe( server, settings.daemonQueueSize,
+                       core::ObserverBus::POLICY_BLOCK );
+
+        // The track must not miss any frame
+        const std::string& trackPath = settings.trackPath;
+        if( !trackPath.empty() )
+        {
+            const std::string indexPath = trackPath + ".idx";
+            recorder.reset( new track::TrackWriter( trackPath.c_str(), indexPath.c_str() ) );
+            bus.subscribe( *recorder, settings.trackQueueSize,
+                           core::ObserverBus::POLICY_BLOCK );
+        }
+
+        // Make the requested analyser
+        core::AnalyserFactory factory( settings );
+        analyser.reset( factory.create( bus ) );
+
+        // Initialize the process
+        analyser->init( settings.pcmDevice.c_str(),
+                        settings.pcmRate,
+                        settings.bufferSize,
+                        settings.captureSize );
+
+        // Run the subscribers ...
+        bus.start();
+        // ... and the analysis in the background
+        util::Thread analysis( *analyser );
+        analysis.start();
+
+        // Main loop, checking on the analysis once a second
+        const struct timespec timeout = { 1, 0 };
+        while( analysis.running() )
+        {
+            const int signal = ::sigtimedwait( &signals, NULL, &timeout );
+
+            // Keep the stream going, take a snapshot only when asked
+            if( sTracer.streaming() || SIGUSR1 == signal )
+            {
+                try
+                {
+                    sTracer.save();
+                }
+                catch( const except::Exception& e )
+                {
+                    ::fprintf( stderr, "Failed to save trace: %s\n", e.what() );
+                }
+            }
+
+            // Free what the analysis is done with
+            analyser->reclaim();
+
+            if( 0 > signal || SIGUSR1 == signal )
+                continue;
+            else if( SIGHUP != signal )
+                break;
+
+            // Reload the configuration, keeping the pipeline running
+            try
+            {
+                config::ConfigMgr config;
+                loadConfig( config, argc, argv );
+
+                const config::Settings next( config );
+                core::AnalyserFactory( next ).reconfigure( *analyser, settings );
+                settings = next;
+            }
+            catch( const except::Exception& e )
+            {
+                ::fprintf( stderr, "Failed to reload configuration: %s\n", e.what() );
+            }
+        }
+
+        // Stop the analysis and subscribers, reporting their errors
+        analysis.stop();
+        bus.stop();
+
+        // Report errors of the last block too
+        if( NULL != recorder.get() )
+            recorder->close();
+
+        // Save the end of the timeline
+        sTracer.save();
+
+        ::fprintf( stderr, "Published %"PRIu64" frames (%"PRIu64" truncated), "
+                           "clients missed %"PRIu64" notifications\n",
+                   ring.head(), ring.truncated(), server.missed() );
+        ::fprintf( stderr, "Latency: %s\n", server.latency().summary().c_str() );
+        ::fprintf( stderr, "Captured with %"PRIu64" gaps (%"PRIu64" short reads)",
+                   analyser->gaps(), analyser->shortReads() );
+
+        // Only the FFT analyser tracks its relocks
+        const core::FftAnalyser* fft =
+            dynamic_cast< const core::FftAnalyser* >( analyser.get() );
+        if( NULL != fft )
+            ::fprintf( stderr, ", last relock took %.1f ms", 1e3 * fft->relockTime() );
+        ::fprintf( stderr, "\n" );
+    }
+    catch( const except::Exception& e )
+    {
+        // Print an error message
+        ::fprintf( stderr, "Fatal error: %s\n", e.what() );
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
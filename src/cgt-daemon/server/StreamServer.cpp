@@ -0,0 +1,143 @@
+/**
+ * @file server/StreamServer.cpp
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#include "cgt-daemon.h"
+
+#include "server/StreamServer.h"
+
+using namespace cgt::server;
+
+/*************************************************************************/
+/* cgt::server::StreamServer                                             */
+/*************************************************************************/
+StreamServer::StreamServer( const char* path, ipc::FrameRing& ring )
+: mPath( path ),
+  mListener( -1 ),
+  mRing( ring ),
+  mMissed( 0 )
+{
+    struct sockaddr_un addr;
+    ::memset( &addr, 0, sizeof( addr ) );
+    addr.sun_family = AF_UNIX;
+
+    // Make sure the path fits.
+    if( sizeof( addr.sun_path ) <= mPath.size() )
+        throw except::InvalidArgument(
+            ::ssprintf( "Socket path '%s' is too long", path ) );
+    ::strcpy( addr.sun_path, path );
+
+    mListener = ::socket( AF_UNIX, SOCK_SEQPACKET, 0 );
+    // Check for error
+    if( 0 > mListener )
+        throw except::RuntimeError(
+            ::ssprintf( "Failed to create socket: %s", ::strerror( errno ) ) );
+
+    // Replace only what a previous run left behind.
+    if( stale( addr ) )
+        ::unlink( path );
+    else
+    {
+        ::close( mListener );
+        throw except::RuntimeError(
+            ::ssprintf( "Socket '%s' already exists and is in use", path ) );
+    }
+
+    if( 0 != ::bind( mListener, (struct sockaddr*)&addr, sizeof( addr ) )
+        || 0 != ::listen( mListener, SOMAXCONN )
+        || 0 != ::fcntl( mListener, F_SETFL, O_NONBLOCK ) )
+    {
+        const int code = errno;
+        ::close( mListener );
+
+        throw except::RuntimeError(
+            ::ssprintf( "Failed to listen on '%s': %s",
+                        path, ::strerror( code ) ) );
+    }
+}
+
+StreamServer::~StreamServer()
+{
+    // Disconnect everyone.
+    std::vector< int >::iterator cur, end;
+    cur = mClients.begin();
+    end = mClients.end();
+    for(; cur != end; ++cur )
+        ::close( *cur );
+
+    ::close( mListener );
+    ::unlink( mPath.c_str() );
+}
+
+bool StreamServer::stale( const struct sockaddr_un& addr )
+{
+    // Nothing there, or not a socket of anybody's?
+    struct stat st;
+    if( 0 != ::lstat( addr.sun_path, &st ) )
+        return ENOENT == errno;
+    if( !S_ISSOCK( st.st_mode ) )
+        return false;
+
+    int fd = ::socket( AF_UNIX, SOCK_SEQPACKET, 0 );
+    if( 0 > fd )
+        return false;
+
+    // Nobody listening, or gone meanwhile?
+    const bool result = 0 != ::connect( fd, (const struct sockaddr*)&addr, sizeof( addr ) )
+                        && ( ECONNREFUSED == errno || ENOENT == errno );
+
+    ::close( fd );
+    return result;
+}
+
+void StreamServer::addFrame( const core::Analyser::Frame& frame )
+{
+    // Publish the frame first ...
+    mRing.addFrame( frame );
+
+    // ... then tell everyone about it.
+    acceptClients();
+    notifyClients( mRing.head() - 1 );
+
+    // Clients may show it from now on
+    mLatency.add( frame.captured, frame.delay, frame.rate,
+                  util::monotonicTime() );
+}
+
+void StreamServer::acceptClients()
+{
+    // The listener doesn't block.
+    int fd;
+    while( 0 <= ( fd = ::accept( mListener, NULL, NULL ) ) )
+        mClients.push_back( fd );
+}
+
+void StreamServer::notifyClients( uint64 index )
+{
+    std::vector< int >::iterator cur = mClients.begin();
+    while( cur != mClients.end() )
+    {
+        // Never wait for a client.
+        const ssize_t sent = ::send( *cur, &index, sizeof( index ),
+                                     MSG_DONTWAIT | MSG_NOSIGNAL );
+        if( ssize_t( sizeof( index ) ) == sent )
+            ++cur;
+        else if( EAGAIN == errno || EWOULDBLOCK == errno )
+        {
+            // It will catch up.
+            ++mMissed;
+            ++cur;
+        }
+        else
+        {
+            // Gone, forget about it.
+            ::close( *cur );
+            cur = mClients.erase( cur );
+        }
+    }
+}
@@ -0,0 +1,292 @@
+/**
+ * @file cgt-track.cpp
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#include "cgt-track.h"
+
+/**
+ * @brief Prints the frames in a time range as CSV.
+ *
+ * @param[in] reader The track.
+ * @param[in] start  Time of the first frame [s].
+ * @param[in] end    Time past the last frame [s], negative for the end.
+ */
+void printCsv( track::TrackReader& reader, double start, double end )
+{
+    ::printf( "time,type,freq,mag\n" );
+
+    // Jump right to the start.
+    reader.seek( start * reader.rate() );
+
+    core::Analyser::Frame frame;
+    while( reader.next( frame ) )
+    {
+        const double time = frame.time();
+        if( 0 <= end && end <= time )
+            break;
+
+        for( size_t i = 0; i < frame.pitchCount; ++i )
+            ::printf( "%.6f,pitch,%.3f,%.2f\n", time, frame.pitches[ i ].freq,
+                      10 * ::log10( frame.pitches[ i ].mag ) );
+        for( size_t i = 0; i < frame.peakCount; ++i )
+            ::printf( "%.6f,peak,%.3f,%.2f\n", time, frame.peaks[ i ].freq,
+                      10 * ::log10( frame.peaks[ i ].mag ) );
+    }
+}
+
+/**
+ * @brief Prints a summary of the track.
+ *
+ * @param[in] reader The track.
+ */
+void printInfo( track::TrackReader& reader )
+{
+    uint64 frames = 0, pitched = 0, records = 0;
+    double first = 0, last = 0;
+
+    core::Analyser::Frame frame;
+    while( reader.next( frame ) )
+    {
+        if( 0 == frames++ )
+            first = frame.time();
+        last = frame.time();
+
+        pitched += 0 < frame.pitchCount;
+        records += frame.pitchCount + frame.peakCount;
+    }
+
+    ::printf( "Sample rate: %u Hz\n", reader.rate() );
+    ::printf( "Blocks:      %"PRIu64" (%u bytes each)\n",
+              reader.blockCount(), (unsigned int)track::Format::BLOCK_SIZE );
+    ::printf( "Frames:      %"PRIu64" (%"PRIu64" pitched)\n", frames, pitched );
+    ::printf( "Records:     %"PRIu64"\n", records );
+    ::printf( "Time:        %.3f - %.3f s\n", first, last );
+}
+
+/**
+ * @brief Writes index of the track.
+ *
+ * @param[in] reader The track.
+ * @param[in] path   Path of the index.
+ */
+void writeIndex( track::TrackReader& reader, const char* path )
+{
+    track::IndexWriter index( path );
+    uint64 block = reader.block();
+
+    core::Analyser::Frame frame;
+    while( reader.next( frame ) )
+    {
+        // Entries follow the blocks.
+        if( block != reader.block() )
+        {
+            index.endBlock();
+            block = reader.block();
+        }
+
+        index.add( frame );
+    }
+
+    index.endBlock();
+    index.close();
+}
+
+/**
+ * @brief Parses name of a note, such as "E2" or "C#4".
+ *
+ * @param[in] name The name.
+ *
+ * @return The MIDI note.
+ */
+size_t parseNote( const char* name )
+{
+    // Pick the longest matching name.
+    int note = -1;
+    size_t length = 0;
+    for( int i = 0; i < util::Tone::NOTES_PER_OCTAVE; ++i )
+    {
+        const size_t len = ::strlen( util::Tone::NOTE_NAMES[ i ] );
+        if( length < len && 0 == ::strncmp( name, util::Tone::NOTE_NAMES[ i ], len ) )
+        {
+            note   = i;
+            length = len;
+        }
+    }
+
+    char* end;
+    const long octave = ::strtol( name + length, &end, 10 );
+
+    // Check for error
+    if( 0 > note || name + length == end || '\0' != *end
+        || 0 > octave + 1 || track::Format::NOTE_COUNT <= size_t( octave + 1 ) * util::Tone::NOTES_PER_OCTAVE + note )
+        throw except::InvalidArgument(
+            ::ssprintf( "Invalid note '%s'", name ) );
+
+    // MIDI starts at octave -1.
+    return ( octave + 1 ) * util::Tone::NOTES_PER_OCTAVE + note;
+}
+
+/**
+ * @brief Prints records of a note within a deviation range as CSV.
+ *
+ * @param[in] time  Time of the frame [s].
+ * @param[in] type  Type of the records.
+ * @param[in] peaks The records.
+ * @param[in] count Number of the records.
+ * @param[in] note  The MIDI note.
+ * @param[in] low   The lowest deviation [cents].
+ * @param[in] high  The highest deviation [cents].
+ */
+void printMatches( double time, const char* type,
+                   const core::Analyser::Peak* peaks, size_t count,
+                   size_t note, double low, double high )
+{
+    for( size_t i = 0; i < count; ++i )
+    {
+        const int32 pitch = track::Format::encodeFreq( peaks[ i ].freq );
+        if( note != size_t( track::Format::noteOf( pitch ) ) )
+            continue;
+
+        const double dev = track::Format::deviationOf( pitch );
+        if( low <= dev && dev <= high )
+            ::printf( "%.6f,%s,%.3f,%.1f\n", time, type, peaks[ i ].freq, dev );
+    }
+}
+
+/**
+ * @brief Prints records of a note within deviation and time ranges.
+ *
+ * Only the blocks whose summary may match are read.
+ *
+ * @param[in] reader The track.
+ * @param[in] index  Index of the track.
+ * @param[in] note   The MIDI note.
+ * @param[in] low    The lowest deviation [cents].
+ * @param[in] high   The highest deviation [cents].
+ * @param[in] start  Time of the first frame [s].
+ * @param[in] end    Time past the last frame [s], negative for the end.
+ */
+void printQuery( track::TrackReader& reader, const track::TrackIndex& index,
+                 size_t note, double low, double high, double start, double end )
+{
+    // Make sure they belong together.
+    if( index.rate() != reader.rate() || reader.blockCount() < index.entryCount() )
+        throw except::RuntimeError( "Index doesn't match the track" );
+
+    const uint64 first = start * reader.rate();
+    const uint64 last  = 0 <= end ? uint64( end * reader.rate() ) : ~uint64( 0 );
+
+    ::printf( "time,type,freq,cents\n" );
+
+    uint64 touched = 0;
+    for( uint64 i = index.find( first );
+         i < index.entryCount() && index.firstPosition( i ) < last;
+         ++i )
+    {
+        // Skip blocks without the note in range.
+        if( !index.contains( i, note, low, high ) )
+            continue;
+
+        ++touched;
+        reader.seekBlock( i );
+
+        core::Analyser::Frame frame;
+        while( 0 < reader.framesLeft() && reader.next( frame ) )
+        {
+            if( frame.position < first || last <= frame.position )
+                continue;
+
+            printMatches( frame.time(), "pitch", frame.pitches, frame.pitchCount,
+                          note, low, high );
+            printMatches( frame.time(), "peak", frame.peaks, frame.peakCount,
+                          note, low, high );
+        }
+    }
+
+    ::fprintf( stderr, "Read %"PRIu64" of %"PRIu64" blocks\n",
+               touched, index.entryCount() );
+}
+
+int main( int argc, char* argv[] )
+{
+    try
+    {
+        // Load config
+        config::ArgvParser argvParser;
+        argvParser.addConfig();
+        argvParser.addHelp();
+
+        // Define value options
+        argvParser.addValue( 's', "start", "cgt.track.start",
+                             "Time of the first frame, in seconds" );
+        argvParser.addValue( 'e', "end", "cgt.track.end",
+                             "Time past the last frame, in seconds, negative for the end" );
+        argvParser.addValue( 'n', "note", "cgt.track.note",
+                             "Note to query, such as E2" );
+        argvParser.addValue( 'l', "low", "cgt.track.low",
+                             "Lowest deviation from the note to query, in cents" );
+        argvParser.addValue( 'u', "high", "cgt.track.high",
+                             "Highest deviation from the note to query, in cents" );
+
+        // Parse arg vector
+        unsigned int code = argvParser.parse( argc, argv );
+        argc -= code;
+        argv += code;
+    }
+    catch( const except::GracefulExit& e )
+    {
+        // Gracefully exit, easy enough :-)
+        return EXIT_SUCCESS;
+    }
+    catch( const except::Exception& e )
+    {
+        // Print an error message
+        ::fprintf( stderr, "Failed to setup configuration: %s\n", e.what() );
+        return EXIT_FAILURE;
+    }
+
+    // We need a command and a track
+    if( 3 != argc )
+    {
+        ::fprintf( stderr, "Usage: cgt-track [options] <csv|info|index|query> <track>\n" );
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        // Parse the configuration once
+        const config::Settings settings( sConfigMgr );
+
+        const std::string command = argv[ 1 ];
+        const std::string indexPath = std::string( argv[ 2 ] ) + ".idx";
+        track::TrackReader reader( argv[ 2 ] );
+
+        if( "csv" == command )
+            printCsv( reader, settings.trackStart, settings.trackEnd );
+        else if( "info" == command )
+            printInfo( reader );
+        else if( "index" == command )
+            writeIndex( reader, indexPath.c_str() );
+        else if( "query" == command )
+            printQuery( reader, track::TrackIndex( indexPath.c_str() ),
+                        parseNote( settings.trackNote.c_str() ),
+                        settings.trackLow, settings.trackHigh,
+                        settings.trackStart, settings.trackEnd );
+        else
+            throw except::InvalidArgument(
+                ::ssprintf( "Unknown command '%s'", command.c_str() ) );
+    }
+    catch( const except::Exception& e )
+    {
+        // Print an error message
+        ::fprintf( stderr, "Fatal error: %s\n", e.what() );
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,305 @@
+/**
+ * @file AllocTest.cpp
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#include "cgt-common.h"
+
+#include "config/Settings.h"
+#include "core/CqAnalyser.h"
+#include "core/FftAnalyser.h"
+#include "core/YinAnalyser.h"
+
+#include "FakePcm.h"
+
+#include <new>
+
+using namespace cgt;
+
+/// Whether allocations are counted.
+static volatile bool   gArmed  = false;
+/// Number of allocations counted.
+static volatile size_t gAllocs = 0;
+
+/*************************************************************************/
+/* Allocation hooks                                                      */
+/*************************************************************************/
+#ifdef __GLIBC__
+extern "C"
+{
+    void* __libc_malloc( size_t size );
+    void* __libc_calloc( size_t count, size_t size );
+    void* __libc_realloc( void* ptr, size_t size );
+    void* __libc_memalign( size_t alignment, size_t size );
+
+    // The rest of glibc and operator new end up here.
+    void* malloc( size_t size )
+    {
+        if( gArmed )
+            ++gAllocs;
+
+        return ::__libc_malloc( size );
+    }
+
+    void* calloc( size_t count, size_t size )
+    {
+        if( gArmed )
+            ++gAllocs;
+
+        return ::__libc_calloc( count, size );
+    }
+
+    void* realloc( void* ptr, size_t size )
+    {
+        if( gArmed )
+            ++gAllocs;
+
+        return ::__libc_realloc( ptr, size );
+    }
+
+    // FFTW allocates its arrays aligned.
+    int posix_memalign( void** ptr, size_t alignment, size_t size )
+    {
+        if( 0 == alignment || 0 != ( alignment & ( alignment - 1 ) )
+            || 0 != alignment % sizeof( void* ) )
+            return EINVAL;
+
+        if( gArmed )
+            ++gAllocs;
+
+        *ptr = ::__libc_memalign( alignment, size );
+        return NULL == *ptr ? ENOMEM : 0;
+    }
+
+    void* memalign( size_t alignment, size_t size )
+    {
+        if( gArmed )
+            ++gAllocs;
+
+        return ::__libc_memalign( alignment, size );
+    }
+}
+#else /* !__GLIBC__ */
+// Without glibc, only operator new can be counted.
+void* operator new( size_t size ) throw( std::bad_alloc )
+{
+    if( gArmed )
+        ++gAllocs;
+
+    void* ptr = ::malloc( size ? size : 1 );
+    if( NULL == ptr )
+        throw std::bad_alloc();
+
+    return ptr;
+}
+
+void* operator new[]( size_t size ) throw( std::bad_alloc )
+{
+    return operator new( size );
+}
+
+void operator delete( void* ptr ) throw()
+{
+    ::free( ptr );
+}
+
+void operator delete[]( void* ptr ) throw()
+{
+    ::free( ptr );
+}
+#endif /* !__GLIBC__ */
+
+/*************************************************************************/
+/* Test                                                                  */
+/*************************************************************************/
+/**
+ * @brief Looks at the frames, keeping nothing.
+ *
+ * @author Bloody.Rabbit
+ */
+class NullObserver
+: public core::Analyser::IFrameObserver
+{
+public:
+    /**
+     * @brief Initializes the observer.
+     */
+    NullObserver()
+    : mRecords( 0 )
+    {
+    }
+
+    /**
+     * @brief Counts records of a frame.
+     *
+     * @param[in] frame The frame.
+     */
+    void addFrame( const core::Analyser::Frame& frame )
+    {
+        mRecords += frame.pitchCount + frame.peakCount;
+    }
+
+    /// Number of records seen.
+    size_t mRecords;
+};
+
+/// The sample rate.
+static const unsigned int RATE         = 48000;
+/// The buffer size.
+static const unsigned int BUFFER_SIZE  = 4096;
+/// The capture size.
+static const unsigned int CAPTURE_SIZE = 1024;
+/// Size of the pushed blocks, not a multiple of the hop.
+static const unsigned int BLOCK_SIZE   = 777;
+/// Number of blocks pushed while counting.
+static const unsigned int BLOCK_COUNT  = 64;
+/// Number of steps while counting.
+static const unsigned int STEP_COUNT   = 48;
+
+/**
+ * @brief Counts allocations of steady-state hops.
+ *
+ * @param[in] analyser The analyser.
+ * @param[in] name     Name of the analyser.
+ * @param[in] samples  The samples to push.
+ *
+ * @return Number of allocations.
+ */
+static size_t countAllocs( core::Analyser& analyser, const char* name,
+                           const std::vector< float >& samples )
+{
+    analyser.init( RATE, BUFFER_SIZE, CAPTURE_SIZE );
+    // Everything audible goes through the analysis.
+    analyser.setGateThreshold( -100 );
+
+    // Fill the buffer and do a few hops first.
+    analyser.process( &samples[ 0 ], 4 * BUFFER_SIZE );
+
+    gAllocs = 0;
+    gArmed  = true;
+
+    for( unsigned int i = 0; i < BLOCK_COUNT; ++i )
+        analyser.process( &samples[ i * BLOCK_SIZE ], BLOCK_SIZE );
+
+    gArmed = false;
+    const size_t allocs = gAllocs;
+
+    ::printf( "%s: %lu allocations in %u hops\n", name, (unsigned long)allocs,
+              BLOCK_COUNT * BLOCK_SIZE / CAPTURE_SIZE );
+    return allocs;
+}
+
+/**
+ * @brief Counts allocations of steady-state steps.
+ *
+ * @param[in] analyser The analyser.
+ * @param[in] name     Name of the analyser.
+ *
+ * @return Number of allocations.
+ */
+static size_t countStepAllocs( core::Analyser& analyser, const char* name )
+{
+    analyser.init( "fake", RATE, BUFFER_SIZE, CAPTURE_SIZE );
+    analyser.setGateThreshold( -100 );
+
+    // Fill the buffer and do a few steps first.
+    for( unsigned int i = 0; i < 4; ++i )
+        analyser.step();
+
+    gAllocs = 0;
+    gArmed  = true;
+
+    for( unsigned int i = 0; i < STEP_COUNT; ++i )
+        analyser.step();
+
+    gArmed = false;
+    const size_t allocs = gAllocs;
+
+    ::printf( "%s: %lu allocations in %u steps\n", name, (unsigned long)allocs,
+              STEP_COUNT );
+    return allocs;
+}
+
+/**
+ * @brief Counts allocations of applying prepared changes.
+ *
+ * The buffer grows and the hop shrinks, then
+ * the analysis goes on at the new sizes.
+ *
+ * @param[in] analyser The analyser.
+ * @param[in] name     Name of the analyser.
+ *
+ * @retval true  The changes are applied without allocating.
+ * @retval false Something else.
+ */
+static bool checkChangeAllocs( core::Analyser& analyser, const char* name )
+{
+    analyser.init( "fake", RATE, BUFFER_SIZE, CAPTURE_SIZE );
+    analyser.setGateThreshold( -100 );
+
+    for( unsigned int i = 0; i < 4; ++i )
+        analyser.step();
+
+    // Prepared and posted off the clock, as by another thread.
+    analyser.post( analyser.prepareResize( 2 * BUFFER_SIZE, CAPTURE_SIZE ) );
+    analyser.post( analyser.prepareCaptureSize( CAPTURE_SIZE / 2 ) );
+
+    gAllocs = 0;
+    gArmed  = true;
+
+    for( unsigned int i = 0; i < STEP_COUNT; ++i )
+        analyser.step();
+
+    gArmed = false;
+    const size_t allocs = gAllocs;
+
+    analyser.reclaim();
+
+    const bool applied = 2 * BUFFER_SIZE == analyser.bufferSize()
+        && CAPTURE_SIZE / 2 == analyser.captureSize();
+
+    ::printf( "%s: %lu allocations applying changes%s\n", name,
+              (unsigned long)allocs, applied ? "" : ", NOT applied" );
+    return applied && 0 == allocs;
+}
+
+int main()
+{
+    // Two strings and some noise.
+    std::vector< float > samples( BLOCK_COUNT * BLOCK_SIZE + 4 * BUFFER_SIZE );
+    for( size_t i = 0; i < samples.size(); ++i )
+        samples[ i ] = 0.4 * ::sin( 2 * M_PI * 110.0 * i / RATE )
+            + 0.2 * ::sin( 2 * M_PI * 331.0 * i / RATE )
+            + 0.05 * ( ::rand() / (double)RAND_MAX - 0.5 );
+
+    // The defaults, apart from the cutoffs.
+    const config::Settings settings;
+
+    NullObserver observer;
+    core::FftAnalyser fft( observer, -60,
+                           settings.fftFloorMargin, settings.fftFloorRise,
+                           settings.fftFloorSmoothing );
+    fft.setPitchHarmonics( 5 );
+    core::YinAnalyser yin( observer, 0.15, -60 );
+    core::CqAnalyser  cq( observer, 60, 2000, 36, -60 );
+
+    size_t allocs = 0;
+    allocs += countAllocs( fft, "fft", samples );
+    allocs += countAllocs( yin, "yin", samples );
+    allocs += countAllocs( cq,  "cq",  samples );
+
+    allocs += countStepAllocs( fft, "fft" );
+    allocs += countStepAllocs( yin, "yin" );
+    allocs += countStepAllocs( cq,  "cq" );
+
+    bool ok = 0 == allocs;
+    ok = checkChangeAllocs( fft, "fft" ) && ok;
+    ok = checkChangeAllocs( yin, "yin" ) && ok;
+    ok = checkChangeAllocs( cq,  "cq" )  && ok;
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
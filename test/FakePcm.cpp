@@ -0,0 +1,109 @@
+/**
+ * @file FakePcm.cpp
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#include "cgt-common.h"
+
+#include "FakePcm.h"
+
+/// Position of the next sample.
+static uint64       gPosition = 0;
+/// Position of the trouble pending, -1 if none.
+static uint64       gTrouble  = -1;
+/// Samples lost by the trouble, 0 if it's a stall.
+static unsigned int gLost     = 0;
+
+/// The handle handed out, never looked into.
+static int gHandle = 0;
+
+/*************************************************************************/
+/* FakePcm                                                               */
+/*************************************************************************/
+void FakePcm::rewind()
+{
+    gPosition = 0;
+    gTrouble  = -1;
+    gLost     = 0;
+}
+
+void FakePcm::overrun( unsigned int after, unsigned int lost )
+{
+    gTrouble = gPosition + after;
+    gLost    = lost;
+}
+
+void FakePcm::stall( unsigned int after )
+{
+    overrun( after, 0 );
+}
+
+/*************************************************************************/
+/* ALSA                                                                  */
+/*************************************************************************/
+// These take over the ones of the library.
+int snd_pcm_open( snd_pcm_t** pcm, const char*, snd_pcm_stream_t, int )
+{
+    *pcm = reinterpret_cast< snd_pcm_t* >( &gHandle );
+    return 0;
+}
+
+int snd_pcm_close( snd_pcm_t* )
+{
+    return 0;
+}
+
+int snd_pcm_set_params( snd_pcm_t*, snd_pcm_format_t format,
+                        snd_pcm_access_t access, unsigned int channels,
+                        unsigned int, int, unsigned int )
+{
+    // Only what the analysers ask for.
+    return SND_PCM_FORMAT_FLOAT64 == format
+        && SND_PCM_ACCESS_RW_NONINTERLEAVED == access
+        && 1 == channels ? 0 : -EINVAL;
+}
+
+int snd_pcm_recover( snd_pcm_t*, int, int )
+{
+    return 0;
+}
+
+int snd_pcm_sw_params_current( snd_pcm_t*, snd_pcm_sw_params_t* )
+{
+    // No timestamps, the time of reading has to do.
+    return -ENOSYS;
+}
+
+int snd_pcm_status( snd_pcm_t*, snd_pcm_status_t* )
+{
+    return -ENOSYS;
+}
+
+snd_pcm_sframes_t snd_pcm_readn( snd_pcm_t*, void** buffers,
+                                 snd_pcm_uframes_t size )
+{
+    if( gTrouble == gPosition )
+    {
+        gTrouble = -1;
+        if( 0 == gLost )
+            return 0;
+
+        gPosition += gLost;
+        return -EPIPE;
+    }
+
+    // Stop short of the trouble.
+    double* samples = static_cast< double* >( buffers[ 0 ] );
+    const snd_pcm_uframes_t count = std::min< uint64 >(
+        std::min< snd_pcm_uframes_t >( size, FakePcm::PERIOD ),
+        gTrouble - gPosition );
+
+    for( snd_pcm_uframes_t i = 0; i < count; ++i )
+        samples[ i ] = double( gPosition++ );
+
+    return count;
+}
@@ -0,0 +1,50 @@
+/**
+ * @file FakePcm.h
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#ifndef __CGT__TEST__FAKE_PCM_H__INCL__
+#define __CGT__TEST__FAKE_PCM_H__INCL__
+
+/**
+ * @brief A capture PCM which needs no sound card.
+ *
+ * Linking FakePcm.cpp into a test replaces the ALSA
+ * functions the analysers use; any PCM name opens it.
+ *
+ * Each sample tells its position in the stream, counting
+ * the lost ones too, so a gap shows as a jump by more than 1.
+ * A read gets at most a period of samples.
+ *
+ * @author Bloody.Rabbit
+ */
+class FakePcm
+{
+public:
+    /// Most samples a read gets.
+    static const unsigned int PERIOD = 256;
+
+    /**
+     * @brief Rewinds the stream, dropping pending trouble.
+     */
+    static void rewind();
+    /**
+     * @brief Makes a read overrun.
+     *
+     * @param[in] after Number of samples read fine before.
+     * @param[in] lost  Number of samples lost by the overrun.
+     */
+    static void overrun( unsigned int after, unsigned int lost );
+    /**
+     * @brief Makes a read get nothing at all.
+     *
+     * @param[in] after Number of samples read fine before.
+     */
+    static void stall( unsigned int after );
+};
+
+#endif /* !__CGT__TEST__FAKE_PCM_H__INCL__ */
@@ -0,0 +1,114 @@
+/**
+ * @file FloorTest.cpp
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#include "cgt-common.h"
+
+#include "config/Settings.h"
+#include "core/FftAnalyser.h"
+
+using namespace cgt;
+
+/// The sample rate.
+static const unsigned int RATE        = 48000;
+/// The buffer size.
+static const unsigned int BUFFER_SIZE = 4096;
+/// The frequency of the note [Hz].
+static const double       FREQ        = 440.0;
+/// Length of the noise before the note [s].
+static const double       LEAD_IN     = 1.0;
+/// Length of the note [s].
+static const double       HELD        = 20.0;
+
+/*************************************************************************/
+/* Test                                                                  */
+/*************************************************************************/
+/**
+ * @brief Remembers whether the last frame has the note.
+ *
+ * @author Bloody.Rabbit
+ */
+class NoteObserver
+: public core::Analyser::IFrameObserver
+{
+public:
+    /**
+     * @brief Initializes the observer.
+     */
+    NoteObserver()
+    : mFound( false )
+    {
+    }
+
+    /**
+     * @brief Looks for the note in a frame.
+     *
+     * @param[in] frame The frame.
+     */
+    void addFrame( const core::Analyser::Frame& frame )
+    {
+        mFound = false;
+        for( size_t i = 0; i < frame.peakCount; ++i )
+            mFound = mFound || ::fabs( frame.peaks[ i ].freq - FREQ ) < 1.0;
+    }
+
+    /// Whether the last frame has the note.
+    bool mFound;
+};
+
+/**
+ * @brief Holds a note for a long while.
+ *
+ * @param[in] captureSize The capture size.
+ *
+ * @retval true  The note is still there at the end.
+ * @retval false It sank into its floor.
+ */
+static bool testHeld( unsigned int captureSize )
+{
+    const config::Settings settings;
+
+    NoteObserver observer;
+    core::FftAnalyser fft( observer, -60, settings.fftFloorMargin,
+                           settings.fftFloorRise, settings.fftFloorSmoothing );
+    fft.init( RATE, BUFFER_SIZE, captureSize );
+    fft.setGateThreshold( -100 );
+
+    // Some noise for the floors, then the note.
+    std::vector< float > samples( size_t( ( LEAD_IN + HELD ) * RATE ) );
+    for( size_t i = 0; i < samples.size(); ++i )
+    {
+        samples[ i ] = 1e-3 * ( ::rand() / (double)RAND_MAX - 0.5 );
+        if( LEAD_IN * RATE <= i )
+            samples[ i ] += 0.4 * ::sin( 2 * M_PI * FREQ * i / RATE );
+    }
+
+    fft.process( &samples[ 0 ], samples.size() );
+
+    ::printf( "held, %u hop: %s\n", captureSize,
+              observer.mFound ? "still there" : "sank" );
+    return observer.mFound;
+}
+
+int main()
+{
+    bool ok = true;
+    try
+    {
+        // The floor goes by seconds, not hops.
+        ok = testHeld( 1024 ) && ok;
+        ok = testHeld( 256 )  && ok;
+    }
+    catch( const except::Exception& e )
+    {
+        ::fprintf( stderr, "Error: %s\n", e.what() );
+        ok = false;
+    }
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,357 @@
+/**
+ * @file FrameRingTest.cpp
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#include "cgt-common.h"
+
+#include "ipc/FrameRing.h"
+#include "util/Thread.h"
+
+using namespace cgt;
+
+/// Name of the ring under test.
+static const char* const NAME = "/cgt-frame-ring-test";
+
+/// Readability typedef of a frame.
+typedef core::Analyser::Frame Frame;
+/// Readability typedef of a frequency.
+typedef core::Analyser::Peak  Peak;
+
+/*************************************************************************/
+/* Frames                                                                */
+/*************************************************************************/
+/// Most records a test frame carries.
+static const size_t MAX_RECORDS = 8;
+
+/**
+ * @brief Makes a frame which tells its index.
+ *
+ * Frame i carries i % 3 pitches and i % 5 frequencies.
+ *
+ * @param[in]  index   Index of the frame.
+ * @param[out] records Storage of the records.
+ * @param[out] frame   The frame.
+ */
+static void makeFrame( uint64 index, Peak* records, Frame& frame )
+{
+    frame.position   = index;
+    frame.captured   = 2 * index;
+    frame.rate       = 48000;
+    frame.delay      = index % 7;
+    frame.pitchCount = index % 3;
+    frame.peakCount  = index % 5;
+
+    for( size_t k = 0; k < frame.pitchCount + frame.peakCount; ++k )
+    {
+        records[ k ].freq = index + k / 16.0;
+        records[ k ].mag  = k;
+    }
+
+    frame.pitches = records;
+    frame.peaks   = records + frame.pitchCount;
+}
+
+/**
+ * @brief Checks a frame read back.
+ *
+ * @param[in] index    Index of the frame.
+ * @param[in] frame    The frame.
+ * @param[in] maxPeaks Records kept per frame.
+ *
+ * @retval true  The frame is the one written, cut to fit.
+ * @retval false It isn't.
+ */
+static bool checkFrame( uint64 index, const Frame& frame, size_t maxPeaks )
+{
+    // The fundamentals always fit, the frequencies may be cut.
+    const size_t pitchCount = std::min< size_t >( index % 3, maxPeaks );
+    const size_t peakCount  = std::min< size_t >( index % 5, maxPeaks - pitchCount );
+
+    if( index != frame.position || 2 * index != frame.captured
+        || index % 7 != frame.delay || pitchCount != frame.pitchCount
+        || peakCount != frame.peakCount
+        // The frequencies follow the fundamentals.
+        || frame.pitches + pitchCount != frame.peaks )
+        return false;
+
+    for( size_t k = 0; k < pitchCount + peakCount; ++k )
+    {
+        const double freq = index + k / 16.0;
+        if( freq != frame.pitches[ k ].freq || k != frame.pitches[ k ].mag )
+            return false;
+    }
+
+    return true;
+}
+
+/*************************************************************************/
+/* Tests                                                                 */
+/*************************************************************************/
+/**
+ * @brief A ring whose slots can be torn on purpose.
+ *
+ * @author Bloody.Rabbit
+ */
+class RingProbe
+: public ipc::FrameRing
+{
+public:
+    /**
+     * @brief Creates the ring for writing.
+     *
+     * @param[in] capacity Number of slots.
+     * @param[in] maxPeaks Records kept per frame.
+     */
+    RingProbe( size_t capacity, size_t maxPeaks )
+    : ipc::FrameRing( NAME, capacity, maxPeaks )
+    {
+    }
+
+    /**
+     * @brief Makes a frame look like it's being written.
+     *
+     * @param[in] index Index of the frame.
+     */
+    void tear( uint64 index ) { slot( index )->sequence = WRITING; }
+    /**
+     * @brief Makes a torn frame whole again.
+     *
+     * @param[in] index Index of the frame.
+     */
+    void mend( uint64 index ) { slot( index )->sequence = index + 1; }
+};
+
+/**
+ * @brief Writes frames past the capacity and reads them back.
+ *
+ * @retval true  Only the frames still in the ring are read, intact.
+ * @retval false Something else.
+ */
+static bool testRoundTrip()
+{
+    // Two records, so that the fundamentals alone may fill a slot.
+    const size_t capacity = 8, maxPeaks = 2, count = 30;
+
+    ipc::FrameRing writer( NAME, capacity, maxPeaks );
+    ipc::FrameRing reader( NAME );
+
+    if( capacity != reader.capacity() || maxPeaks != reader.maxPeaks() )
+        return false;
+
+    Peak records[ MAX_RECORDS ];
+    Frame frame;
+
+    uint64 truncated = 0;
+    for( uint64 i = 0; i < count; ++i )
+    {
+        makeFrame( i, records, frame );
+        writer.addFrame( frame );
+
+        truncated += maxPeaks < frame.pitchCount + frame.peakCount;
+    }
+
+    if( count != reader.head() || truncated != writer.truncated() )
+        return false;
+
+    for( uint64 i = 0; i < count; ++i )
+    {
+        // Wrapped around, the old frames are gone.
+        const bool kept = reader.read( i, frame );
+        if( kept != ( count - capacity <= i ) )
+            return false;
+        if( kept && !checkFrame( i, frame, maxPeaks ) )
+            return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Reads a frame while it's being written.
+ *
+ * @retval true  The read is refused, then retried fine.
+ * @retval false Something else.
+ */
+static bool testTorn()
+{
+    RingProbe writer( 4, 4 );
+    ipc::FrameRing reader( NAME );
+
+    Peak records[ MAX_RECORDS ];
+    Frame frame;
+
+    makeFrame( 0, records, frame );
+    writer.addFrame( frame );
+
+    writer.tear( 0 );
+    if( reader.read( 0, frame ) )
+        return false;
+
+    writer.mend( 0 );
+    return reader.read( 0, frame ) && checkFrame( 0, frame, 4 );
+}
+
+/**
+ * @brief Writes frames as fast as it can.
+ *
+ * @author Bloody.Rabbit
+ */
+class Writer
+: public util::Thread::IRunnable
+{
+public:
+    /**
+     * @brief Binds the writer to a ring.
+     *
+     * @param[in] ring  The ring.
+     * @param[in] count Number of frames to write.
+     */
+    Writer( ipc::FrameRing& ring, uint64 count )
+    : mRing( ring ),
+      mCount( count )
+    {
+    }
+
+    /**
+     * @brief Writes the frames.
+     *
+     * @param[in] thread The thread.
+     */
+    void run( util::Thread& thread )
+    {
+        Peak records[ MAX_RECORDS ];
+        Frame frame;
+
+        for( uint64 i = 0; i < mCount && !thread.stopRequested(); ++i )
+        {
+            makeFrame( i, records, frame );
+            mRing.addFrame( frame );
+        }
+    }
+
+protected:
+    /// The ring.
+    ipc::FrameRing& mRing;
+    /// Number of frames to write.
+    uint64          mCount;
+};
+
+/**
+ * @brief Reads the newest frames while they're being overwritten.
+ *
+ * @retval true  Every read accepted is intact.
+ * @retval false Some isn't.
+ */
+static bool testConcurrent()
+{
+    // A tiny ring, the writer laps the reader all the time.
+    const size_t maxPeaks = 6;
+    ipc::FrameRing ring( NAME, 2, maxPeaks );
+    ipc::FrameRing reader( NAME );
+
+    Writer writer( ring, 2000000 );
+    util::Thread thread( writer );
+    thread.start();
+
+    Frame frame;
+    uint64 reads = 0, retries = 0, bad = 0;
+    while( thread.running() )
+    {
+        const uint64 head = reader.head();
+        if( 0 == head )
+            continue;
+
+        if( !reader.read( head - 1, frame ) )
+            ++retries;
+        else if( ++reads, !checkFrame( head - 1, frame, maxPeaks ) )
+            ++bad;
+    }
+
+    thread.stop();
+
+    ::printf( "concurrent: %"PRIu64" reads, %"PRIu64" retried, %"PRIu64" bad\n",
+              reads, retries, bad );
+    return 0 < reads && 0 == bad;
+}
+
+/**
+ * @brief Creates a ring over one left behind by an older build.
+ *
+ * @retval true  The stale ring is taken over.
+ * @retval false It isn't.
+ */
+static bool testStale()
+{
+    // Just the magic and version 2, which didn't record the writer.
+    int fd = ::shm_open( NAME, O_RDWR | O_CREAT | O_EXCL, 0644 );
+    if( 0 > fd )
+        return false;
+
+    const uint32 magic   = 0x52544743;
+    const uint16 version = 2;
+    uint8 header[ 32 ] = {};
+    ::memcpy( header, &magic, sizeof( magic ) );
+    ::memcpy( header + sizeof( magic ), &version, sizeof( version ) );
+
+    const bool written = ssize_t( sizeof( header ) ) == ::write( fd, header, sizeof( header ) );
+    ::close( fd );
+    if( !written )
+        return false;
+
+    try
+    {
+        ipc::FrameRing writer( NAME, 4, 4 );
+        return true;
+    }
+    catch( const except::Exception& e )
+    {
+        ::fprintf( stderr, "stale: %s\n", e.what() );
+        ::shm_unlink( NAME );
+        return false;
+    }
+}
+
+/**
+ * @brief Runs a test, reporting the outcome.
+ *
+ * @param[in] name The name of the test.
+ * @param[in] test The test.
+ *
+ * @retval true  The test passed.
+ * @retval false It failed.
+ */
+static bool run( const char* name, bool ( *test )() )
+{
+    bool ok;
+    try
+    {
+        ok = test();
+    }
+    catch( const except::Exception& e )
+    {
+        ::fprintf( stderr, "%s: %s\n", name, e.what() );
+        ok = false;
+    }
+
+    ::printf( "%s: %s\n", name, ok ? "ok" : "FAILED" );
+    return ok;
+}
+
+int main()
+{
+    // Don't trip over what a crashed run left.
+    ::shm_unlink( NAME );
+
+    bool ok = true;
+    ok = run( "round trip", testRoundTrip )  && ok;
+    ok = run( "torn",       testTorn )       && ok;
+    ok = run( "concurrent", testConcurrent ) && ok;
+    ok = run( "stale",      testStale )      && ok;
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,180 @@
+/**
+ * @file GapTest.cpp
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#include "cgt-common.h"
+
+#include "core/Analyser.h"
+
+#include "FakePcm.h"
+
+using namespace cgt;
+
+/// The sample rate.
+static const unsigned int RATE         = 48000;
+/// The buffer size.
+static const unsigned int BUFFER_SIZE  = 2048;
+/// The capture size.
+static const unsigned int CAPTURE_SIZE = 512;
+
+/*************************************************************************/
+/* Test                                                                  */
+/*************************************************************************/
+/**
+ * @brief Ignores the frames.
+ *
+ * @author Bloody.Rabbit
+ */
+class NullObserver
+: public core::Analyser::IFrameObserver
+{
+public:
+    /**
+     * @brief Ignores a frame.
+     *
+     * @param[in] frame The frame.
+     */
+    void addFrame( const core::Analyser::Frame& frame ) {}
+};
+
+/**
+ * @brief An analyser which checks that its buffer is continuous.
+ *
+ * @author Bloody.Rabbit
+ */
+class GapProbe
+: public core::Analyser
+{
+public:
+    /**
+     * @brief Initializes the probe.
+     *
+     * @param[in] observer The frame observer.
+     */
+    GapProbe( IFrameObserver& observer )
+    : core::Analyser( observer ),
+      mAnalysed( 0 ),
+      mSpanning( 0 )
+    {
+    }
+
+    /**
+     * @brief Obtains number of hops analysed.
+     *
+     * @return Number of hops.
+     */
+    size_t analysed() const { return mAnalysed; }
+    /**
+     * @brief Obtains number of hops whose buffer spans a gap.
+     *
+     * @return Number of hops.
+     */
+    size_t spanning() const { return mSpanning; }
+
+protected:
+    /**
+     * @brief Creates an empty probe.
+     *
+     * @return The probe.
+     */
+    Analyser* createTwin() const { return new GapProbe( observer() ); }
+
+    /**
+     * @brief Checks that the samples follow each other.
+     */
+    void analyse()
+    {
+        ++mAnalysed;
+
+        for( size_t i = 1; i < bufferSize(); ++i )
+            if( mSamples[ i - 1 ] + 1 != mSamples[ i ] )
+            {
+                ++mSpanning;
+                break;
+            }
+
+        startFrame();
+        endFrame();
+    }
+
+    /// Number of hops analysed.
+    size_t mAnalysed;
+    /// Number of hops whose buffer spans a gap.
+    size_t mSpanning;
+};
+
+/**
+ * @brief Captures across gaps of a kind.
+ *
+ * @param[in] name Name of the kind.
+ * @param[in] make Makes a gap on the fake PCM.
+ *
+ * @retval true  Every gap is counted and no hop spans it.
+ * @retval false Something else.
+ */
+static bool testGaps( const char* name, void ( *make )() )
+{
+    FakePcm::rewind();
+
+    NullObserver observer;
+    GapProbe probe( observer );
+    probe.init( "fake", RATE, BUFFER_SIZE, CAPTURE_SIZE );
+
+    const unsigned int gaps = 3, steps = 20;
+    for( unsigned int g = 0; g < gaps; ++g )
+    {
+        for( unsigned int i = 0; i < steps; ++i )
+            probe.step();
+
+        // Hit the next hop in the middle of its capture.
+        make();
+    }
+
+    for( unsigned int i = 0; i < steps; ++i )
+        probe.step();
+
+    ::printf( "%s: %lu hops analysed, %lu spanning, %"PRIu64" gaps\n", name,
+              (unsigned long)probe.analysed(), (unsigned long)probe.spanning(),
+              probe.gaps() );
+
+    return 0 < probe.analysed() && 0 == probe.spanning()
+        && gaps == probe.gaps();
+}
+
+/**
+ * @brief Overruns the fake PCM.
+ */
+static void makeOverrun()
+{
+    FakePcm::overrun( CAPTURE_SIZE / 2 + 44, 1000 );
+}
+
+/**
+ * @brief Stalls the fake PCM.
+ */
+static void makeStall()
+{
+    FakePcm::stall( CAPTURE_SIZE / 2 + 44 );
+}
+
+int main()
+{
+    bool ok = true;
+    try
+    {
+        ok = testGaps( "overrun", makeOverrun ) && ok;
+        ok = testGaps( "stall",   makeStall )   && ok;
+    }
+    catch( const except::Exception& e )
+    {
+        ::fprintf( stderr, "Error: %s\n", e.what() );
+        ok = false;
+    }
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
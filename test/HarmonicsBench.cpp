@@ -0,0 +1,225 @@
+/**
+ * @file HarmonicsBench.cpp
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#include "cgt-common.h"
+
+#include "track/TrackReader.h"
+#include "util/Harmonics.h"
+#include "util/Misc.h"
+
+using namespace cgt;
+
+/**
+ * @brief Frequencies of a frame, in the order they're classified.
+ *
+ * @author Bloody.Rabbit
+ */
+struct Frame
+{
+    /// Detected fundamentals, they seed the harmonics.
+    std::vector< double > pitches;
+    /// Detected frequencies.
+    std::vector< double > peaks;
+};
+
+/**
+ * @brief The classification before binary search.
+ *
+ * Scans all the fundamentals, taking a log per test.
+ *
+ * @author Bloody.Rabbit
+ */
+class LinearHarmonics
+{
+public:
+    /**
+     * @brief Initializes the harmonics analyser.
+     *
+     * @param[in] tol The harmonic tolerance.
+     */
+    LinearHarmonics( double tol )
+    : mTolerance( tol )
+    {
+    }
+
+    /**
+     * @brief Obtains harmonic index of a frequency.
+     *
+     * @param[in] freq The frequency.
+     *
+     * @return The harmonic index.
+     */
+    unsigned int get( double freq )
+    {
+        std::vector< double >::const_iterator cur, end;
+        cur = mFundamentals.begin();
+        end = mFundamentals.end();
+        for(; cur != end; ++cur )
+        {
+            double ratio = freq / *cur;
+            int k = ratio + 0.5;
+
+            if( mTolerance > 10 * ::log10( ::fabs( ratio - k ) ) )
+                return k - 1;
+        }
+
+        mFundamentals.push_back( freq );
+        return 0;
+    }
+    /**
+     * @brief Clears all intermediate data.
+     */
+    void clear() { mFundamentals.clear(); }
+
+protected:
+    /// The fundamentals, in order of appearance.
+    std::vector< double > mFundamentals;
+    /// A harmonic tolerance [dB].
+    double mTolerance;
+};
+
+/**
+ * @brief Loads frames of a recorded track.
+ *
+ * @param[in]  path   Path of the track.
+ * @param[out] frames Where to store the frames.
+ */
+static void loadTrack( const char* path, std::vector< Frame >& frames )
+{
+    track::TrackReader reader( path );
+
+    core::Analyser::Frame frame;
+    while( reader.next( frame ) )
+    {
+        frames.push_back( Frame() );
+        for( size_t i = 0; i < frame.pitchCount; ++i )
+            frames.back().pitches.push_back( frame.pitches[ i ].freq );
+        for( size_t i = 0; i < frame.peakCount; ++i )
+            frames.back().peaks.push_back( frame.peaks[ i ].freq );
+    }
+}
+
+/**
+ * @brief Makes frames of a chord in a noisy room.
+ *
+ * @param[out] frames Where to store the frames.
+ */
+static void makeFrames( std::vector< Frame >& frames )
+{
+    // E2, A2, D3 and G3 with their harmonics.
+    const double chord[] = { 82.41, 110.0, 146.83, 196.0 };
+
+    frames.resize( 1000 );
+    for( size_t i = 0; i < frames.size(); ++i )
+    {
+        Frame& frame = frames[ i ];
+        for( size_t j = 0; j < sizeof( chord ) / sizeof( chord[ 0 ] ); ++j )
+        {
+            frame.pitches.push_back( chord[ j ] );
+            for( unsigned int k = 1; k <= 8; ++k )
+                frame.peaks.push_back( k * chord[ j ] * ( 1 + 1e-3 * ( ::rand() / (double)RAND_MAX - 0.5 ) ) );
+        }
+
+        // Hundreds of peaks the room adds.
+        for( unsigned int k = 0; k < 300; ++k )
+            frame.peaks.push_back( 50 + 4950 * ::rand() / (double)RAND_MAX );
+
+        // Peaks come in order of frequency.
+        std::sort( frame.peaks.begin(), frame.peaks.end() );
+    }
+}
+
+/**
+ * @brief Classifies all the frames.
+ *
+ * @param[in]  harmonics The classifier.
+ * @param[in]  frames    The frames.
+ * @param[out] indices   Where to store the harmonic indices.
+ *
+ * @return Time it took [ns].
+ */
+template< typename T >
+static uint64 classify( T& harmonics, const std::vector< Frame >& frames,
+                        std::vector< unsigned int >& indices )
+{
+    indices.clear();
+
+    const uint64 start = util::monotonicTime();
+    for( size_t i = 0; i < frames.size(); ++i )
+    {
+        const Frame& frame = frames[ i ];
+
+        // The same way as the screen does.
+        harmonics.clear();
+        for( size_t j = 0; j < frame.pitches.size(); ++j )
+            harmonics.get( frame.pitches[ j ] );
+        for( size_t j = 0; j < frame.peaks.size(); ++j )
+            indices.push_back( harmonics.get( frame.peaks[ j ] ) );
+    }
+
+    return util::monotonicTime() - start;
+}
+
+int main( int argc, char* argv[] )
+{
+    // Default harmonic tolerance.
+    const double tolerance = -6.0;
+
+    std::vector< Frame > frames;
+    try
+    {
+        if( 1 < argc )
+            loadTrack( argv[ 1 ], frames );
+        else
+            makeFrames( frames );
+    }
+    catch( const except::Exception& e )
+    {
+        ::fprintf( stderr, "Failed to load frames: %s\n", e.what() );
+        return EXIT_FAILURE;
+    }
+
+    size_t peaks = 0;
+    for( size_t i = 0; i < frames.size(); ++i )
+        peaks += frames[ i ].peaks.size();
+    if( 0 == peaks )
+    {
+        ::fprintf( stderr, "No peaks to classify\n" );
+        return EXIT_FAILURE;
+    }
+
+    std::vector< unsigned int > expected, indices;
+    LinearHarmonics linear( tolerance );
+    util::Harmonics sorted( tolerance );
+
+    // Warm up, then take the best of a few runs.
+    uint64 linearTime = classify( linear, frames, expected );
+    uint64 sortedTime = classify( sorted, frames, indices );
+    for( unsigned int i = 0; i < 5; ++i )
+    {
+        linearTime = std::min( linearTime, classify( linear, frames, expected ) );
+        sortedTime = std::min( sortedTime, classify( sorted, frames, indices ) );
+    }
+
+    // The lowest fundamental wins now, not the first one seen,
+    // so fundamentals which come out of order may differ.
+    size_t differ = 0;
+    for( size_t i = 0; i < peaks; ++i )
+        differ += expected[ i ] != indices[ i ];
+
+    ::printf( "%lu frames, %lu peaks\n", (unsigned long)frames.size(), (unsigned long)peaks );
+    ::printf( "linear: %8.1f ns/peak %10.1f us/frame\n",
+              double( linearTime ) / peaks, linearTime / 1e3 / frames.size() );
+    ::printf( "sorted: %8.1f ns/peak %10.1f us/frame\n",
+              double( sortedTime ) / peaks, sortedTime / 1e3 / frames.size() );
+    ::printf( "speedup %.1fx, %lu indices differ\n",
+              double( linearTime ) / sortedTime, (unsigned long)differ );
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,146 @@
+/**
+ * @file PitchBench.cpp
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#include "cgt-common.h"
+
+#include "config/ConfigMgr.h"
+#include "config/Settings.h"
+#include "core/AnalyserFactory.h"
+#include "stats/Histogram.h"
+#include "util/Misc.h"
+
+using namespace cgt;
+
+/**
+ * @brief Notes when the pitch is first found.
+ *
+ * @author Bloody.Rabbit
+ */
+class PitchObserver
+: public core::Analyser::IFrameObserver
+{
+public:
+    /**
+     * @brief Initializes the observer.
+     *
+     * @param[in] freq  The pitch to look for.
+     * @param[in] onset Position of the onset.
+     */
+    PitchObserver( double freq, uint64 onset )
+    : mFreq( freq ),
+      mOnset( onset ),
+      mFound( 0 )
+    {
+    }
+
+    /**
+     * @brief Checks the pitches of a frame.
+     *
+     * @param[in] frame The frame.
+     */
+    void addFrame( const core::Analyser::Frame& frame )
+    {
+        if( 0 != mFound || frame.position <= mOnset )
+            return;
+
+        // Within half a semitone.
+        for( size_t i = 0; i < frame.pitchCount; ++i )
+            if( ::fabs( 12 * ::log( frame.pitches[ i ].freq / mFreq ) / M_LN2 ) < 0.5 )
+            {
+                mFound = frame.position;
+                break;
+            }
+    }
+
+    /// The pitch to look for.
+    double mFreq;
+    /// Position of the onset.
+    uint64 mOnset;
+    /// Position of the first frame with the pitch, 0 if none.
+    uint64 mFound;
+};
+
+/// The sample rate.
+static const unsigned int RATE  = 48000;
+/// The pitch of the pluck, A2.
+static const double       PITCH = 110.0;
+
+/**
+ * @brief Runs an analyser over the samples.
+ *
+ * @param[in] type        The analyser.
+ * @param[in] bufferSize  The buffer size.
+ * @param[in] captureSize The capture size.
+ * @param[in] samples     The samples.
+ * @param[in] onset       Position of the onset.
+ */
+static void bench( const char* type, unsigned int bufferSize, unsigned int captureSize,
+                   const std::vector< float >& samples, uint64 onset )
+{
+    config::ConfigMgr config;
+    config[ "cgt.analyser" ]    = type;
+    config[ "cgt.bufferSize" ]  = bufferSize;
+    config[ "cgt.captureSize" ] = captureSize;
+    const config::Settings settings( config );
+
+    PitchObserver observer( PITCH, onset );
+    std::auto_ptr< core::Analyser > analyser(
+        core::AnalyserFactory( settings ).create( observer ) );
+    analyser->init( RATE, bufferSize, captureSize );
+
+    // Fill the buffer first ...
+    analyser->process( &samples[ 0 ], bufferSize );
+
+    // ... then time each hop.
+    stats::Histogram hops;
+    for( size_t i = bufferSize; i + captureSize <= samples.size(); i += captureSize )
+    {
+        const uint64 start = util::monotonicTime();
+        analyser->process( &samples[ i ], captureSize );
+        hops.add( util::monotonicTime() - start );
+    }
+
+    const double hop    = 1e9 * captureSize / RATE;
+    const double detect = 0 != observer.mFound
+        ? 1e3 * ( observer.mFound - onset ) / RATE : HUGE_VAL;
+
+    ::printf( "%-4s %6u %6u %10.1f %10.1f %8.2f %10.1f %10.1f\n",
+              type, bufferSize, captureSize,
+              hops.percentile( 50 ) / 1e3, hops.percentile( 99 ) / 1e3,
+              100 * hops.percentile( 50 ) / hop,
+              1e3 * analyser->groupDelay() / RATE, detect );
+}
+
+int main()
+{
+    // A second of quiet noise, then a decaying pluck.
+    const uint64 onset = RATE;
+    std::vector< float > samples( 4 * RATE );
+    for( size_t i = 0; i < samples.size(); ++i )
+    {
+        samples[ i ] = 1e-3 * ( ::rand() / (double)RAND_MAX - 0.5 );
+        if( i < onset )
+            continue;
+
+        const double t = double( i - onset ) / RATE;
+        for( unsigned int k = 1; k <= 6; ++k )
+            samples[ i ] += 0.4 / k * ::exp( -t * k ) * ::sin( 2 * M_PI * k * PITCH * t );
+    }
+
+    ::printf( "%-4s %6s %6s %10s %10s %8s %10s %10s\n", "", "buffer", "hop",
+              "p50 [us]", "p99 [us]", "budget %", "delay [ms]", "found [ms]" );
+
+    // The defaults of FFT, and what YIN needs for the same pitch.
+    bench( "fft", 16384, 4096, samples, onset );
+    bench( "fft", 4096,  1024, samples, onset );
+    bench( "yin", 2048,  256,  samples, onset );
+    bench( "yin", 2048,  1024, samples, onset );
+
+    return EXIT_SUCCESS;
+}
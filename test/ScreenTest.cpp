@@ -0,0 +1,143 @@
+/**
+ * @file ScreenTest.cpp
+ *
+ * Console Guitar Tuner (CGT)
+ * Copyright (c) 2011 by Bloody.Rabbit
+ *
+ * @author Bloody.Rabbit
+ */
+
+#include "cgt-curses.h"
+
+#include "curses/Screen.h"
+
+using namespace cgt;
+
+/*************************************************************************/
+/* Test                                                                  */
+/*************************************************************************/
+/**
+ * @brief A screen which tells what it has put on the tuner.
+ *
+ * @author Bloody.Rabbit
+ */
+class ScreenProbe
+: public curses::Screen
+{
+public:
+    /**
+     * @brief Initializes the screen.
+     *
+     * @param[in] settings The settings to follow.
+     */
+    ScreenProbe( const config::Settings& settings )
+    : curses::Screen( settings, 0, 0, 80, 24 )
+    {
+    }
+
+    /**
+     * @brief Obtains number of fundamentals put on the tuner.
+     *
+     * @return Number of tones of the last frame drawn.
+     */
+    size_t tuned() const { return mTuned.size(); }
+    /**
+     * @brief Obtains number of pitches of the last frame drawn.
+     *
+     * @return Number of pitches.
+     */
+    size_t pitches() const { return mFrames.front().pitches.size(); }
+    /**
+     * @brief Obtains number of frequencies of the last frame drawn.
+     *
+     * @return Number of frequencies.
+     */
+    size_t peaks() const { return mFrames.front().peaks.size(); }
+};
+
+/**
+ * @brief Draws a plucked string analysed by an analyser.
+ *
+ * @param[in] name            Name of the analyser.
+ * @param[in] pitchHarmonics  Harmonics of the FFT pitch detection.
+ * @param[in] expectedPitches Whether the tuner should follow the pitches.
+ *
+ * @retval true  The tuner got the fundamentals it should have.
+ * @retval false It didn't.
+ */
+static bool drive( const char* name, unsigned int pitchHarmonics,
+                   bool expectedPitches )
+{
+    config::Settings settings;
+    settings.analyser          = name;
+    settings.fftPitchHarmonics = pitchHarmonics;
+    settings.gateThreshold     = -100;
+
+    ScreenProbe screen( settings );
+    std::auto_ptr< core::Analyser > analyser(
+        core::AnalyserFactory( settings ).create( screen ) );
+    screen.follow( *analyser );
+
+    analyser->init( settings.pcmRate, settings.bufferSize,
+                    settings.captureSize );
+
+    // Some noise for the floors, then a string at 110 Hz with a few harmonics.
+    std::vector< float > samples( 6 * settings.bufferSize );
+    for( size_t i = 0; i < samples.size(); ++i )
+    {
+        samples[ i ] = 1e-3 * ( ::rand() / (double)RAND_MAX - 0.5 );
+        for( unsigned int h = 1; h <= 4 && 2 * settings.bufferSize <= i; ++h )
+            samples[ i ] += 0.4 / h * ::sin( 2 * M_PI * 110.0 * h * i / settings.pcmRate );
+    }
+
+    analyser->process( &samples[ 0 ], samples.size() );
+    screen.render();
+
+    ::printf( "%s: %lu pitches, %lu peaks, %lu on the tuner\n", name,
+              (unsigned long)screen.pitches(), (unsigned long)screen.peaks(),
+              (unsigned long)screen.tuned() );
+
+    // Something must reach the tuner, each fundamental once.
+    if( 0 == screen.tuned() )
+        return false;
+    return expectedPitches
+        ? screen.tuned() == screen.pitches()
+        : 0 == screen.pitches();
+}
+
+int main()
+{
+    // A terminal of our own, which nobody sees.
+    FILE* out = ::fopen( "/dev/null", "w" );
+    FILE* in  = ::fopen( "/dev/null", "r" );
+    SCREEN* term = ::newterm( "xterm", out, in );
+    if( NULL == term )
+    {
+        ::fprintf( stderr, "Failed to setup the terminal\n" );
+        return EXIT_FAILURE;
+    }
+
+    ::start_color();
+    ::use_default_colors();
+
+    bool ok = true;
+    try
+    {
+        ok = drive( "cq",  5, false ) && ok;
+        ok = drive( "yin", 0, true )  && ok;
+        ok = drive( "fft", 0, false ) && ok;
+        ok = drive( "fft", 5, true )  && ok;
+    }
+    catch( const except::Exception& e )
+    {
+        ::fprintf( stderr, "Error: %s\n", e.what() );
+        ok = false;
+    }
+
+    ::endwin();
+    ::delscreen( term );
+    ::fclose( in );
+    ::fclose( out );
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}